@@ -0,0 +1,113 @@
+#pragma once
+#include "StockTracker/Types.h"
+#include <zmq.hpp>
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace StockTracker::Bench {
+
+    inline std::string symbolName(size_t index) {
+        return "SYM" + std::to_string(index);
+    }
+
+    // Random-walk ticks for `symbols` symbols, `per_symbol` ticks each, one second apart
+    inline std::vector<StockQuote> makeQuotes(size_t symbols, size_t per_symbol, uint32_t seed = 42) {
+        std::mt19937 rng(seed);
+        std::normal_distribution<double> step(0.0, 0.002);
+
+        std::vector<StockQuote> quotes;
+        quotes.reserve(symbols * per_symbol);
+        auto start = std::chrono::system_clock::now() - std::chrono::seconds(per_symbol);
+        for (size_t s = 0; s < symbols; ++s) {
+            double price = 50.0 + static_cast<double>(s % 400);
+            for (size_t i = 0; i < per_symbol; ++i) {
+                double change = step(rng);
+                price *= 1.0 + change;
+                quotes.push_back(StockQuote{
+                    symbolName(s),
+                    price,
+                    start + std::chrono::seconds(i),
+                    change * 100.0,
+                    "USD",
+                    std::nullopt
+                });
+            }
+        }
+        return quotes;
+    }
+
+    // Google Benchmark runs each benchmark several times and an endpoint can't be rebound
+    // right after its socket closes, so every run binds a fresh one. Connect to
+    // boundEndpoint() afterwards; for tcp the port is picked by the OS.
+    inline std::string freshEndpoint(const std::string& transport) {
+        static std::atomic<int> counter{ 0 };
+        if (transport == "tcp") {
+            return "tcp://127.0.0.1:*";
+        }
+        if (transport == "ipc") {
+            return "ipc:///tmp/stocktracker-bench-" + std::to_string(++counter);
+        }
+        return "inproc://stocktracker-bench-" + std::to_string(++counter);
+    }
+
+    inline std::string boundEndpoint(zmq::socket_t& socket) {
+        return socket.get(zmq::sockopt::last_endpoint);
+    }
+
+    // Stand-in for the currency service: a REP socket answering conversions from a fixed rate table
+    class CurrencyStub {
+    public:
+        explicit CurrencyStub(std::string endpoint = "tcp://127.0.0.1:15555")
+            : endpoint(std::move(endpoint))
+            , socket(context, zmq::socket_type::rep)
+        {
+            socket.set(zmq::sockopt::linger, 0);
+            socket.set(zmq::sockopt::rcvtimeo, 50);
+            socket.bind(this->endpoint);
+            thread = std::thread([this] { serve(); });
+        }
+
+        ~CurrencyStub() {
+            running = false;
+            thread.join();
+        }
+
+        const std::string endpoint;
+
+    private:
+        zmq::context_t context{ 1 };
+        zmq::socket_t socket;
+        std::atomic<bool> running{ true };
+        std::thread thread;
+
+        const std::unordered_map<std::string, double> rates{
+            {"USD", 1.0}, {"EUR", 0.92}, {"GBP", 0.79}, {"JPY", 149.5}, {"CNY", 7.24}, {"KRW", 1335.0},
+            {"INR", 83.1}, {"CAD", 1.36}, {"AUD", 1.52}, {"CHF", 0.88}, {"HKD", 7.82}, {"SGD", 1.34}
+        };
+
+        void serve() {
+            while (running) {
+                zmq::message_t request;
+                if (!socket.recv(request)) {
+                    continue;
+                }
+
+                auto j = nlohmann::json::parse(request.to_string_view());
+                nlohmann::json reply;
+                auto it = rates.find(j.value("to_currency", ""));
+                if (it == rates.end()) {
+                    reply["error"] = "Unsupported currency";
+                }
+                else {
+                    reply["converted_amount"] = j.at("amount").get<double>() * it->second;
+                }
+                socket.send(zmq::buffer(reply.dump()), zmq::send_flags::none);
+            }
+        }
+    };
+}
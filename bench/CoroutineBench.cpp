@@ -0,0 +1,83 @@
+#include "BenchData.h"
+#include "StockTracker/Coroutines.h"
+#include <benchmark/benchmark.h>
+
+// Only built when the compiler supports coroutines (see bench/CMakeLists.txt)
+#if defined(__cpp_impl_coroutine)
+
+using namespace StockTracker;
+
+namespace {
+
+    Bench::CurrencyStub& stub() {
+        static Bench::CurrencyStub instance("tcp://127.0.0.1:15631");
+        return instance;
+    }
+
+    Task convertFlow(Reactor& reactor, AsyncCurrencyService& fx, int conversions, int& running) {
+        for (int i = 0; i < conversions; ++i) {
+            double converted = co_await convertAsync(reactor, fx, 100.0 + i, "EUR");
+            benchmark::DoNotOptimize(converted);
+        }
+        --running;
+    }
+
+    Task receiveFlow(Reactor& reactor, MessageSocket& socket, int64_t messages, int64_t& received) {
+        while (received < messages) {
+            if (co_await receiveAsync(reactor, socket)) {
+                ++received;
+            }
+        }
+    }
+}
+
+// range(0) concurrent request flows on one thread, each doing a few dependent conversions
+static void BM_CoroutineConvertFlows(benchmark::State& state) {
+    constexpr int CONVERSIONS_PER_FLOW = 4;
+    int flows = static_cast<int>(state.range(0));
+
+    Reactor reactor;
+    AsyncCurrencyService fx(stub().endpoint);
+    for (auto _ : state) {
+        int running = flows;
+        for (int i = 0; i < flows; ++i) {
+            convertFlow(reactor, fx, CONVERSIONS_PER_FLOW, running);
+        }
+        while (running > 0) {
+            reactor.runOnce(std::chrono::milliseconds(100));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * flows * CONVERSIONS_PER_FLOW);
+}
+BENCHMARK(BM_CoroutineConvertFlows)->Arg(1)->Arg(64)->Arg(1024)->UseRealTime();
+
+// A coroutine consuming quote updates that another thread pushes over inproc
+static void BM_CoroutineReceive(benchmark::State& state) {
+    constexpr int64_t BURST = 1000;
+
+    Reactor reactor;
+    MessageSocket pull(zmq::socket_type::pull);
+    pull.bind(Bench::freshEndpoint("inproc"));
+    MessageSocket push(zmq::socket_type::push);
+    push.setWireFormat(WireFormat::Binary);
+    push.connect(Bench::boundEndpoint(pull.getSocket()));
+
+    auto quotes = Bench::makeQuotes(1, BURST);
+    for (auto _ : state) {
+        int64_t received = 0;
+        receiveFlow(reactor, pull, BURST, received);
+        std::thread producer([&] {
+            for (const auto& quote : quotes) {
+                push.send(Message::makeQuoteUpdate(quote));
+            }
+        });
+        while (received < BURST) {
+            reactor.runOnce(std::chrono::milliseconds(100));
+        }
+        producer.join();
+    }
+    state.SetItemsProcessed(state.iterations() * BURST);
+}
+BENCHMARK(BM_CoroutineReceive)->UseRealTime();
+
+#endif
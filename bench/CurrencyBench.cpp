@@ -0,0 +1,136 @@
+#include "BenchData.h"
+#include "StockTracker/AsyncCurrencyService.h"
+#include "StockTracker/CurrencyService.h"
+#include <benchmark/benchmark.h>
+#include <future>
+
+using namespace StockTracker;
+
+namespace {
+
+    // Shared by every currency benchmark; the real service doesn't need to be running
+    Bench::CurrencyStub& stub() {
+        static Bench::CurrencyStub instance("tcp://127.0.0.1:15621");
+        return instance;
+    }
+}
+
+// Every call is a request/reply round trip
+static void BM_ConvertCurrencyUncached(benchmark::State& state) {
+    CurrencyService service(stub().endpoint);
+    service.setRateTtl(std::chrono::milliseconds(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(service.convertCurrency(123.45, "EUR"));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConvertCurrencyUncached)->UseRealTime();
+
+static void BM_ConvertCurrencyCached(benchmark::State& state) {
+    CurrencyService service(stub().endpoint);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(service.convertCurrency(123.45, "EUR"));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConvertCurrencyCached);
+
+// Converting a whole price history, as the server does for a PriceHistory reply
+static void BM_ConvertMany(benchmark::State& state) {
+    CurrencyService service(stub().endpoint);
+    std::vector<double> amounts;
+    for (const auto& quote : Bench::makeQuotes(1, static_cast<size_t>(state.range(0)))) {
+        amounts.push_back(quote.price);
+    }
+    for (auto _ : state) {
+        auto converted = service.convertMany(amounts, "JPY");
+        benchmark::DoNotOptimize(converted.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConvertMany)->Arg(500);
+
+// Price column converted in place, alternating EUR and back so values stay put
+static void BM_ConvertInPlace(benchmark::State& state) {
+    CurrencyService service(stub().endpoint);
+    std::vector<double> amounts;
+    for (const auto& quote : Bench::makeQuotes(1, static_cast<size_t>(state.range(0)))) {
+        amounts.push_back(quote.price);
+    }
+    bool inEur = false;
+    for (auto _ : state) {
+        service.convertInPlace(amounts.data(), amounts.size(), inEur ? "USD" : "EUR", inEur ? "EUR" : "USD");
+        inEur = !inEur;
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConvertInPlace)->Arg(500)->Arg(100000);
+
+// Converting a USD history to JPY one quote at a time, as callers of convertCurrency do.
+// Both quote benchmarks restore the USD input first (an allocation-free copy).
+static void BM_ConvertQuotesScalar(benchmark::State& state) {
+    CurrencyService service(stub().endpoint);
+    const auto source = Bench::makeQuotes(1, static_cast<size_t>(state.range(0)));
+    auto quotes = source;
+    for (auto _ : state) {
+        quotes = source;
+        for (auto& quote : quotes) {
+            quote.price = service.convertCurrency(quote.price, "JPY");
+            quote.currency = "JPY";
+        }
+        benchmark::DoNotOptimize(quotes.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConvertQuotesScalar)->Arg(500);
+
+static void BM_ConvertQuotes(benchmark::State& state) {
+    CurrencyService service(stub().endpoint);
+    const auto source = Bench::makeQuotes(1, static_cast<size_t>(state.range(0)));
+    auto quotes = source;
+    for (auto _ : state) {
+        quotes = source;
+        service.convertQuotes(quotes, "JPY");
+        benchmark::DoNotOptimize(quotes.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConvertQuotes)->Arg(500);
+
+// A batch mixing USD, EUR and GBP quotes: three rate lookups, then one pass
+static void BM_ConvertQuotesMixed(benchmark::State& state) {
+    CurrencyService service(stub().endpoint);
+    auto source = Bench::makeQuotes(1, static_cast<size_t>(state.range(0)));
+    const char* currencies[] = { "USD", "EUR", "GBP" };
+    for (size_t i = 0; i < source.size(); ++i) {
+        source[i].currency = currencies[i % 3];
+    }
+    auto quotes = source;
+    for (auto _ : state) {
+        quotes = source;
+        service.convertQuotes(quotes, "JPY");
+        benchmark::DoNotOptimize(quotes.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConvertQuotesMixed)->Arg(500);
+
+// Keeps range(0) requests in flight on the DEALER socket
+static void BM_ConvertAsyncPipelined(benchmark::State& state) {
+    AsyncCurrencyService service(stub().endpoint);
+    size_t depth = static_cast<size_t>(state.range(0));
+    std::vector<std::future<double>> futures;
+    futures.reserve(depth);
+    for (auto _ : state) {
+        futures.clear();
+        for (size_t i = 0; i < depth; ++i) {
+            futures.push_back(service.convertAsync(100.0 + static_cast<double>(i), "GBP"));
+        }
+        for (auto& future : futures) {
+            benchmark::DoNotOptimize(future.get());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConvertAsyncPipelined)->Arg(1)->Arg(16)->Arg(128)->UseRealTime();
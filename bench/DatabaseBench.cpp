@@ -0,0 +1,601 @@
+#include "BenchData.h"
+#include "StockTracker/DatabaseService.h"
+#include "StockTracker/TickLogStore.h"
+#include <benchmark/benchmark.h>
+#include <sqlite3.h>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <stdexcept>
+#include <thread>
+
+using namespace StockTracker;
+
+namespace {
+
+    constexpr size_t SYMBOLS = 100;
+    constexpr size_t TICKS_PER_SYMBOL = 1000;
+
+    std::string benchDbPath(const char* name) {
+        auto path = std::filesystem::temp_directory_path() / name;
+        for (const char* suffix : { "", "-wal", "-shm" }) {
+            std::filesystem::remove(path.string() + suffix);
+        }
+        return path.string();
+    }
+
+    std::string benchLogDir(const char* name) {
+        auto path = std::filesystem::temp_directory_path() / name;
+        std::filesystem::remove_all(path);
+        return path.string();
+    }
+
+    // 100 symbols x 1000 ticks, built once and shared by the read benchmarks
+    const std::vector<StockQuote>& historyQuotes() {
+        static const auto quotes = Bench::makeQuotes(SYMBOLS, TICKS_PER_SYMBOL);
+        return quotes;
+    }
+
+    void loadHistory(DatabaseService& service) {
+        service.enableBars();
+        service.enableWriteBehind();
+        for (const auto& quote : historyQuotes()) {
+            service.savePrice(quote);
+        }
+        service.flush();
+    }
+
+    DatabaseService& historyDb() {
+        static DatabaseService* db = [] {
+            auto* service = new DatabaseService(benchDbPath("stocktracker-bench-history.db"));
+            loadHistory(*service);
+            return service;
+        }();
+        return *db;
+    }
+
+    // The same history behind a read pool
+    DatabaseService& pooledHistoryDb() {
+        static DatabaseService* db = [] {
+            auto* service = new DatabaseService(benchDbPath("stocktracker-bench-history-pool.db"));
+            loadHistory(*service);
+            service->enableReadPool(ReadPoolOptions{ 8 });
+            return service;
+        }();
+        return *db;
+    }
+
+    // The same history kept in a TickLogStore
+    TickLogStore* tickLog = nullptr;
+
+    DatabaseService& tickLogHistoryDb() {
+        static DatabaseService* db = [] {
+            auto store = std::make_unique<TickLogStore>(TickLogOptions{ benchLogDir("stocktracker-bench-ticks") });
+            tickLog = store.get();
+            auto* service = new DatabaseService(benchDbPath("stocktracker-bench-history-ticks.db"), std::move(store));
+            loadHistory(*service);
+            return service;
+        }();
+        return *db;
+    }
+
+    // Bare SQLite connection with the price_history schema, for comparing a statement
+    // prepared on every call against one prepared once and reset (as SqlitePriceStore does)
+    class RawPriceTable {
+    public:
+        explicit RawPriceTable(const std::string& path) {
+            if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+                throw std::runtime_error(std::string("Failed to open database: ") + sqlite3_errmsg(db));
+            }
+            execute(R"(
+        PRAGMA journal_mode=WAL;
+        PRAGMA synchronous=NORMAL;
+        CREATE TABLE IF NOT EXISTS price_history (
+            symbol TEXT NOT NULL,
+            price REAL NOT NULL,
+            timestamp INTEGER NOT NULL,
+            change_percent REAL
+        );
+        CREATE INDEX IF NOT EXISTS idx_price_history_symbol_timestamp
+            ON price_history (symbol, timestamp);
+    )");
+        }
+
+        ~RawPriceTable() {
+            sqlite3_close(db);
+        }
+
+        void execute(const char* sql) {
+            if (sqlite3_exec(db, sql, nullptr, nullptr, nullptr) != SQLITE_OK) {
+                throw std::runtime_error(std::string("SQLite error: ") + sqlite3_errmsg(db));
+            }
+        }
+
+        sqlite3_stmt* prepare(const char* sql, unsigned int flags = 0) {
+            sqlite3_stmt* stmt = nullptr;
+            if (sqlite3_prepare_v3(db, sql, -1, flags, &stmt, nullptr) != SQLITE_OK) {
+                throw std::runtime_error(std::string("Failed to prepare statement: ") + sqlite3_errmsg(db));
+            }
+            return stmt;
+        }
+
+    private:
+        sqlite3* db = nullptr;
+    };
+
+    const char* INSERT_PRICE_SQL = R"(
+        INSERT INTO price_history (symbol, price, timestamp, change_percent)
+        VALUES (?, ?, ?, ?)
+    )";
+
+    const char* PRICE_HISTORY_SQL = R"(
+        SELECT symbol, price, timestamp, change_percent
+        FROM price_history
+        WHERE symbol = ?
+        ORDER BY timestamp DESC
+        LIMIT ?
+    )";
+
+    void insertPrice(sqlite3_stmt* stmt, const StockQuote& quote) {
+        sqlite3_bind_text(stmt, 1, quote.symbol.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_double(stmt, 2, quote.price);
+        sqlite3_bind_int64(stmt, 3, toStoredTimestamp(quote.timestamp));
+        if (quote.change_percent) {
+            sqlite3_bind_double(stmt, 4, *quote.change_percent);
+        }
+        else {
+            sqlite3_bind_null(stmt, 4);
+        }
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            throw std::runtime_error("Failed to save price");
+        }
+    }
+
+    size_t readPriceHistory(sqlite3_stmt* stmt, const std::string& symbol, int limit, std::vector<StockQuote>& rows) {
+        rows.clear();
+        sqlite3_bind_text(stmt, 1, symbol.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 2, limit);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            auto& quote = rows.emplace_back();
+            quote.symbol = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            quote.price = sqlite3_column_double(stmt, 1);
+            quote.timestamp = std::chrono::system_clock::time_point(std::chrono::milliseconds(sqlite3_column_int64(stmt, 2)));
+            if (sqlite3_column_type(stmt, 3) != SQLITE_NULL) {
+                quote.change_percent = sqlite3_column_double(stmt, 3);
+            }
+        }
+        return rows.size();
+    }
+
+    // historyQuotes() in a bare table, loaded once
+    RawPriceTable& rawHistoryTable() {
+        static RawPriceTable* table = [] {
+            auto* raw = new RawPriceTable(benchDbPath("stocktracker-bench-history-raw.db"));
+            raw->execute("BEGIN");
+            sqlite3_stmt* stmt = raw->prepare(INSERT_PRICE_SQL);
+            for (const auto& quote : historyQuotes()) {
+                insertPrice(stmt, quote);
+                sqlite3_reset(stmt);
+            }
+            sqlite3_finalize(stmt);
+            raw->execute("COMMIT");
+            return raw;
+        }();
+        return *table;
+    }
+
+    const std::string& pickSymbol(int64_t iteration) {
+        static std::vector<std::string> symbols = [] {
+            std::vector<std::string> names;
+            for (size_t i = 0; i < SYMBOLS; ++i) {
+                names.push_back(Bench::symbolName(i));
+            }
+            return names;
+        }();
+        return symbols[static_cast<size_t>(iteration) % symbols.size()];
+    }
+}
+
+static void BM_SavePrice(benchmark::State& state) {
+    DatabaseService db(benchDbPath("stocktracker-bench-save.db"));
+    auto quotes = Bench::makeQuotes(10, 1000);
+    size_t i = 0;
+    for (auto _ : state) {
+        db.savePrice(quotes[i++ % quotes.size()]);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SavePrice);
+
+// Includes the final flush, so the rate is what actually reaches disk
+static void BM_SavePriceWriteBehind(benchmark::State& state) {
+    DatabaseService db(benchDbPath("stocktracker-bench-save-wb.db"));
+    db.enableWriteBehind();
+    auto quotes = Bench::makeQuotes(10, 1000);
+    for (auto _ : state) {
+        for (const auto& quote : quotes) {
+            db.savePrice(quote);
+        }
+        db.flush();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(quotes.size()));
+}
+BENCHMARK(BM_SavePriceWriteBehind)->Unit(benchmark::kMillisecond);
+
+static void BM_SavePriceTickLog(benchmark::State& state) {
+    DatabaseService db(benchDbPath("stocktracker-bench-save-ticks.db"),
+        std::make_unique<TickLogStore>(TickLogOptions{ benchLogDir("stocktracker-bench-save-ticks") }));
+    auto quotes = Bench::makeQuotes(10, 1000);
+    size_t i = 0;
+    for (auto _ : state) {
+        db.savePrice(quotes[i++ % quotes.size()]);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SavePriceTickLog);
+
+// Includes the final flush, which msyncs the touched segments
+static void BM_SavePriceWriteBehindTickLog(benchmark::State& state) {
+    DatabaseService db(benchDbPath("stocktracker-bench-save-wb-ticks.db"),
+        std::make_unique<TickLogStore>(TickLogOptions{ benchLogDir("stocktracker-bench-save-wb-ticks") }));
+    db.enableWriteBehind();
+    auto quotes = Bench::makeQuotes(10, 1000);
+    for (auto _ : state) {
+        for (const auto& quote : quotes) {
+            db.savePrice(quote);
+        }
+        db.flush();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(quotes.size()));
+}
+BENCHMARK(BM_SavePriceWriteBehindTickLog)->Unit(benchmark::kMillisecond);
+
+// savePrice's insert, preparing the statement on every call vs preparing it once and
+// resetting it. range(0) = 1 runs every insert in one transaction, leaving the statement
+// cost instead of the commit as the bulk of each iteration.
+static void BM_SavePricePreparePerCall(benchmark::State& state) {
+    RawPriceTable table(benchDbPath("stocktracker-bench-save-prepare.db"));
+    auto quotes = Bench::makeQuotes(10, 1000);
+    if (state.range(0)) {
+        table.execute("BEGIN");
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        sqlite3_stmt* stmt = table.prepare(INSERT_PRICE_SQL);
+        insertPrice(stmt, quotes[i++ % quotes.size()]);
+        sqlite3_finalize(stmt);
+    }
+    if (state.range(0)) {
+        table.execute("COMMIT");
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SavePricePreparePerCall)->Arg(0)->Arg(1);
+
+static void BM_SavePriceCachedStatement(benchmark::State& state) {
+    RawPriceTable table(benchDbPath("stocktracker-bench-save-cached.db"));
+    auto quotes = Bench::makeQuotes(10, 1000);
+    sqlite3_stmt* stmt = table.prepare(INSERT_PRICE_SQL, SQLITE_PREPARE_PERSISTENT);
+    if (state.range(0)) {
+        table.execute("BEGIN");
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        insertPrice(stmt, quotes[i++ % quotes.size()]);
+        sqlite3_reset(stmt);
+    }
+    if (state.range(0)) {
+        table.execute("COMMIT");
+    }
+    sqlite3_finalize(stmt);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SavePriceCachedStatement)->Arg(0)->Arg(1);
+
+// getPriceHistory's query, the same two ways; compare with BM_GetPriceHistory for the service overhead
+static void BM_GetPriceHistoryPreparePerCall(benchmark::State& state) {
+    auto& table = rawHistoryTable();
+    int limit = static_cast<int>(state.range(0));
+    std::vector<StockQuote> rows;
+    int64_t n = 0;
+    for (auto _ : state) {
+        sqlite3_stmt* stmt = table.prepare(PRICE_HISTORY_SQL);
+        benchmark::DoNotOptimize(readPriceHistory(stmt, pickSymbol(n++), limit, rows));
+        sqlite3_finalize(stmt);
+    }
+    state.SetItemsProcessed(state.iterations() * limit);
+}
+BENCHMARK(BM_GetPriceHistoryPreparePerCall)->Arg(5)->Arg(100);
+
+static void BM_GetPriceHistoryCachedStatement(benchmark::State& state) {
+    auto& table = rawHistoryTable();
+    int limit = static_cast<int>(state.range(0));
+    sqlite3_stmt* stmt = table.prepare(PRICE_HISTORY_SQL, SQLITE_PREPARE_PERSISTENT);
+    std::vector<StockQuote> rows;
+    int64_t n = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(readPriceHistory(stmt, pickSymbol(n++), limit, rows));
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    state.SetItemsProcessed(state.iterations() * limit);
+}
+BENCHMARK(BM_GetPriceHistoryCachedStatement)->Arg(5)->Arg(100);
+
+static void BM_GetPriceHistory(benchmark::State& state) {
+    auto& db = historyDb();
+    int limit = static_cast<int>(state.range(0));
+    int64_t n = 0;
+    for (auto _ : state) {
+        auto rows = db.getPriceHistory(pickSymbol(n++), limit);
+        benchmark::DoNotOptimize(rows.data());
+    }
+    state.SetItemsProcessed(state.iterations() * limit);
+}
+BENCHMARK(BM_GetPriceHistory)->Arg(5)->Arg(100)->Arg(1000);
+
+// Reads from several threads: serialized on the one connection, then spread over the pool
+static void BM_GetPriceHistoryShared(benchmark::State& state) {
+    auto& db = historyDb();
+    int64_t n = state.thread_index();
+    for (auto _ : state) {
+        auto rows = db.getPriceHistory(pickSymbol(n++), 100);
+        benchmark::DoNotOptimize(rows.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetPriceHistoryShared)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_GetPriceHistoryPooled(benchmark::State& state) {
+    auto& db = pooledHistoryDb();
+    int64_t n = state.thread_index();
+    for (auto _ : state) {
+        auto rows = db.getPriceHistory(pickSymbol(n++), 100);
+        benchmark::DoNotOptimize(rows.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetPriceHistoryPooled)->ThreadRange(1, 8)->UseRealTime();
+
+// Stress run of the pool: thread 0 ingests while the others mix every pooled read and check
+// what they get back. Fails the run on a malformed result.
+static void BM_ReadPoolUnderIngest(benchmark::State& state) {
+    auto& db = pooledHistoryDb();
+    const auto& quotes = historyQuotes();
+    auto from = quotes.front().timestamp;
+    auto to = quotes[TICKS_PER_SYMBOL - 1].timestamp + std::chrono::seconds(1);
+    int64_t n = state.thread_index();
+    for (auto _ : state) {
+        if (state.thread_index() == 0) {
+            StockQuote quote = quotes[static_cast<size_t>(n++) % quotes.size()];
+            quote.timestamp = std::chrono::system_clock::now();
+            db.savePrice(quote);
+            continue;
+        }
+
+        const auto& symbol = pickSymbol(n++);
+        // Throughput only; tests/ReadPoolTests.cpp checks what the readers see
+        bool ok = true;
+        switch (n % 4) {
+        case 0:
+            ok = db.getPriceHistory(symbol, 50).size() == 50;
+            break;
+        case 1:
+            ok = db.getPriceHistoryRange(symbol, from, to, 100).size() == 100;
+            break;
+        case 2:
+            ok = db.getPriceHistoryPage(symbol, 20).quotes.size() == 20;
+            break;
+        default:
+            benchmark::DoNotOptimize(db.getSubscriptions());
+            break;
+        }
+        if (!ok) {
+            state.SkipWithError("Pooled read returned a malformed result");
+            break;
+        }
+    }
+    if (state.thread_index() == 0) {
+        db.flush();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ReadPoolUnderIngest)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+
+// One compact() over the whole dataset aged past retention, rolled up into the default tiers,
+// with savePrice running alongside. range(0) is the batch size, range(1) selects the tick log
+// (100-tick segments) instead of price_history. The iteration time is the compaction; the
+// counters show how long ingest ever waited behind a batch.
+static void BM_CompactUnderIngest(benchmark::State& state) {
+    auto expired = historyQuotes();
+    for (auto& quote : expired) {
+        quote.timestamp -= std::chrono::hours(24 * 30);
+    }
+    const auto& live = historyQuotes();
+
+    RetentionOptions retention;
+    retention.raw_ticks = std::chrono::hours(24);
+    retention.batch_size = static_cast<size_t>(state.range(0));
+
+    int64_t removed = 0;
+    int64_t saves = 0;
+    std::chrono::steady_clock::duration slowestSave{ 0 };
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::unique_ptr<PriceStore> store;
+        if (state.range(1)) {
+            store = std::make_unique<TickLogStore>(TickLogOptions{ benchLogDir("stocktracker-bench-compact"), 100 });
+        }
+        DatabaseService db(benchDbPath("stocktracker-bench-compact.db"), std::move(store));
+        db.enableWriteBehind();
+        for (const auto& quote : expired) {
+            db.savePrice(quote);
+        }
+        db.flush();
+        db.enableRetention(retention);
+        state.ResumeTiming();
+
+        std::atomic<bool> done{ false };
+        std::thread compactor([&] {
+            removed += static_cast<int64_t>(db.compact().ticks_removed);
+            done = true;
+        });
+        while (!done) {
+            StockQuote quote = live[static_cast<size_t>(saves++) % live.size()];
+            quote.timestamp = std::chrono::system_clock::now();
+            auto start = std::chrono::steady_clock::now();
+            db.savePrice(quote);
+            slowestSave = std::max(slowestSave, std::chrono::steady_clock::now() - start);
+        }
+        compactor.join();
+    }
+    state.SetItemsProcessed(removed);
+    state.counters["saves"] = static_cast<double>(saves);
+    state.counters["max_save_us"] = std::chrono::duration<double, std::micro>(slowestSave).count();
+}
+BENCHMARK(BM_CompactUnderIngest)
+    ->Args({ 100, 0 })->Args({ 1000, 0 })->Args({ 10000, 0 })->Args({ 100, 1 })->Args({ 1000, 1 })
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Same query answered by the in-memory cache, warmed by replaying the dataset through savePrice
+static void BM_GetPriceHistoryCached(benchmark::State& state) {
+    DatabaseService db(benchDbPath("stocktracker-bench-cache.db"));
+    db.enableCache();
+    db.enableWriteBehind();
+    for (const auto& quote : historyQuotes()) {
+        db.savePrice(quote);
+    }
+    db.flush();
+
+    int limit = static_cast<int>(state.range(0));
+    int64_t n = 0;
+    for (auto _ : state) {
+        auto rows = db.getPriceHistory(pickSymbol(n++), limit);
+        benchmark::DoNotOptimize(rows.data());
+    }
+    state.SetItemsProcessed(state.iterations() * limit);
+    state.counters["hit_rate"] = [&] {
+        auto stats = *db.cacheStats();
+        return static_cast<double>(stats.hits) / static_cast<double>(stats.hits + stats.misses);
+    }();
+}
+BENCHMARK(BM_GetPriceHistoryCached)->Arg(5)->Arg(64);
+
+static void BM_GetPriceHistoryRange(benchmark::State& state) {
+    auto& db = historyDb();
+    const auto& quotes = historyQuotes();
+    auto from = quotes.front().timestamp;
+    auto to = quotes[static_cast<size_t>(state.range(0)) - 1].timestamp + std::chrono::seconds(1);
+    int64_t n = 0;
+    for (auto _ : state) {
+        auto rows = db.getPriceHistoryRange(pickSymbol(n++), from, to);
+        benchmark::DoNotOptimize(rows.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetPriceHistoryRange)->Arg(100)->Arg(1000);
+
+static void BM_GetPriceHistoryRangeTickLog(benchmark::State& state) {
+    auto& db = tickLogHistoryDb();
+    const auto& quotes = historyQuotes();
+    auto from = quotes.front().timestamp;
+    auto to = quotes[static_cast<size_t>(state.range(0)) - 1].timestamp + std::chrono::seconds(1);
+    int64_t n = 0;
+    for (auto _ : state) {
+        auto rows = db.getPriceHistoryRange(pickSymbol(n++), from, to);
+        benchmark::DoNotOptimize(rows.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetPriceHistoryRangeTickLog)->Arg(100)->Arg(1000);
+
+// Same range read in place from the mapped columns, averaging the prices
+static void BM_TickLogScanColumns(benchmark::State& state) {
+    tickLogHistoryDb();
+    const auto& quotes = historyQuotes();
+    auto from = quotes.front().timestamp;
+    auto to = quotes[static_cast<size_t>(state.range(0)) - 1].timestamp + std::chrono::seconds(1);
+    int64_t n = 0;
+    for (auto _ : state) {
+        double sum = 0.0;
+        tickLog->scanColumns(pickSymbol(n++), from, to, [&](const TickColumns& columns) {
+            for (size_t i = 0; i < columns.count; ++i) {
+                sum += columns.prices[i];
+            }
+        });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TickLogScanColumns)->Arg(100)->Arg(1000);
+
+// Walks a symbol's whole history page by page
+static void BM_GetPriceHistoryPages(benchmark::State& state) {
+    auto& db = historyDb();
+    int limit = static_cast<int>(state.range(0));
+    int64_t n = 0;
+    int64_t rows = 0;
+    for (auto _ : state) {
+        const auto& symbol = pickSymbol(n++);
+        std::optional<HistoryPageKey> key;
+        do {
+            auto page = db.getPriceHistoryPage(symbol, limit, key);
+            rows += static_cast<int64_t>(page.quotes.size());
+            key = page.next;
+        } while (key);
+    }
+    state.SetItemsProcessed(rows);
+}
+BENCHMARK(BM_GetPriceHistoryPages)->Arg(50)->Arg(500);
+
+static void BM_PriceHistoryCursor(benchmark::State& state) {
+    auto& db = historyDb();
+    const auto& quotes = historyQuotes();
+    auto from = quotes.front().timestamp;
+    auto to = quotes[TICKS_PER_SYMBOL - 1].timestamp + std::chrono::seconds(1);
+    int64_t n = 0;
+    int64_t rows = 0;
+    StockQuote quote;
+    for (auto _ : state) {
+        auto cursor = db.openPriceHistoryCursor(pickSymbol(n++), from, to);
+        while (cursor.next(quote)) {
+            ++rows;
+        }
+    }
+    state.SetItemsProcessed(rows);
+}
+BENCHMARK(BM_PriceHistoryCursor);
+
+// A symbol's whole history as bars of range(0) seconds; compare with BM_GetPriceHistoryRange/1000
+static void BM_GetBars(benchmark::State& state) {
+    auto& db = historyDb();
+    const auto& quotes = historyQuotes();
+    BarQuery query;
+    query.interval = std::chrono::seconds(state.range(0));
+    query.from = quotes.front().timestamp - query.interval;
+    query.to = quotes[TICKS_PER_SYMBOL - 1].timestamp + query.interval;
+    int64_t n = 0;
+    int64_t bars = 0;
+    for (auto _ : state) {
+        auto rows = db.getBars(pickSymbol(n++), query);
+        bars += static_cast<int64_t>(rows.size());
+        benchmark::DoNotOptimize(rows.data());
+    }
+    state.SetItemsProcessed(bars);
+}
+BENCHMARK(BM_GetBars)->Arg(1)->Arg(60)->Arg(3600);
+
+// Folding one tick into the 1s/1m/1h/1d bars of its symbol
+static void BM_BarAggregatorAdd(benchmark::State& state) {
+    BarAggregator aggregator;
+    const auto& quotes = historyQuotes();
+    size_t i = 0;
+    for (auto _ : state) {
+        aggregator.add(quotes[i++ % quotes.size()]);
+        if (i % 4096 == 0) {
+            benchmark::DoNotOptimize(aggregator.takeClosed());
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BarAggregatorAdd);
@@ -0,0 +1,24 @@
+#include "BenchData.h"
+#include "StockTracker/Indicators.h"
+#include <benchmark/benchmark.h>
+
+using namespace StockTracker;
+
+// One quote through the indicator stage, spread over range(0) symbols.
+// Should stay flat as the windows grow, since every indicator is O(1) per quote.
+static void BM_IndicatorApply(benchmark::State& state) {
+    IndicatorOptions options;
+    options.sma_window = static_cast<size_t>(state.range(1));
+    options.volatility_window = static_cast<size_t>(state.range(1));
+    IndicatorEngine engine(options);
+
+    auto quotes = Bench::makeQuotes(static_cast<size_t>(state.range(0)), 1000);
+    size_t i = 0;
+    for (auto _ : state) {
+        StockQuote& quote = quotes[i++ % quotes.size()];
+        engine.apply(quote);
+        benchmark::DoNotOptimize(quote.indicators);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_IndicatorApply)->Args({ 1, 20 })->Args({ 100, 20 })->Args({ 100, 200 });
@@ -0,0 +1,22 @@
+#include "StockTracker/Metrics.h"
+#include <benchmark/benchmark.h>
+
+using namespace StockTracker;
+
+// Cost of instrumenting one operation; build with -DSTOCKTRACKER_ENABLE_METRICS=OFF to compare
+static void BM_MetricTimer(benchmark::State& state) {
+    for (auto _ : state) {
+        MetricTimer timer(Metric::SocketSend, MessageType::QuoteUpdate);
+        timer.setBytes(64);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MetricTimer)->ThreadRange(1, 8);
+
+static void BM_MetricsSnapshot(benchmark::State& state) {
+    for (auto _ : state) {
+        auto snapshot = Metrics::snapshot();
+        benchmark::DoNotOptimize(snapshot.metrics.data());
+    }
+}
+BENCHMARK(BM_MetricsSnapshot);
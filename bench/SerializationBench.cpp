@@ -0,0 +1,118 @@
+#include "BenchData.h"
+#include "StockTracker/BinaryCodec.h"
+#include "StockTracker/Messages.h"
+#include <benchmark/benchmark.h>
+
+using namespace StockTracker;
+
+namespace {
+
+    Message quoteUpdate() {
+        return Message::makeQuoteUpdate(Bench::makeQuotes(1, 1).front());
+    }
+
+    Message priceHistory(size_t rows) {
+        return Message::makePriceHistory(Bench::symbolName(0), Bench::makeQuotes(1, rows));
+    }
+
+    Message sampleMessage(const benchmark::State& state) {
+        return state.range(0) == 0 ? quoteUpdate() : priceHistory(static_cast<size_t>(state.range(0)));
+    }
+
+    void setItems(benchmark::State& state, size_t bytes) {
+        state.SetItemsProcessed(state.iterations());
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+    }
+}
+
+// Arg 0 is a single QuoteUpdate, anything else a PriceHistory reply with that many rows
+
+static void BM_JsonEncode(benchmark::State& state) {
+    Message msg = sampleMessage(state);
+    std::string out;
+    for (auto _ : state) {
+        json j = msg;
+        out = j.dump();
+        benchmark::DoNotOptimize(out.data());
+    }
+    setItems(state, out.size());
+}
+BENCHMARK(BM_JsonEncode)->Arg(0)->Arg(500);
+
+static void BM_JsonDecode(benchmark::State& state) {
+    std::string frame = json(sampleMessage(state)).dump();
+    Message msg{};
+    for (auto _ : state) {
+        json::parse(frame).get_to(msg);
+        benchmark::DoNotOptimize(msg);
+    }
+    setItems(state, frame.size());
+}
+BENCHMARK(BM_JsonDecode)->Arg(0)->Arg(500);
+
+static void BM_BinaryEncode(benchmark::State& state) {
+    Message msg = sampleMessage(state);
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        to_binary(out, msg);
+        benchmark::DoNotOptimize(out.data());
+    }
+    setItems(state, out.size());
+}
+BENCHMARK(BM_BinaryEncode)->Arg(0)->Arg(500);
+
+static void BM_BinaryDecode(benchmark::State& state) {
+    std::string frame;
+    to_binary(frame, sampleMessage(state));
+    Message msg{};
+    for (auto _ : state) {
+        from_binary(frame.data(), frame.size(), msg);
+        benchmark::DoNotOptimize(msg);
+    }
+    setItems(state, frame.size());
+}
+BENCHMARK(BM_BinaryDecode)->Arg(0)->Arg(500);
+
+// PriceHistory reply with range(0) rows sent as one HistoryCodec block; the frame size
+// counter compares with BM_BinaryEncode at the same row count
+static void BM_BinaryEncodeColumnarHistory(benchmark::State& state) {
+    Message msg = Message::makePriceHistory(Bench::symbolName(0),
+        Bench::makeQuotes(1, static_cast<size_t>(state.range(0))), HistoryEncoding::Columnar);
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        to_binary(out, msg);
+        benchmark::DoNotOptimize(out.data());
+    }
+    setItems(state, out.size());
+    state.counters["frame_bytes"] = static_cast<double>(out.size());
+}
+BENCHMARK(BM_BinaryEncodeColumnarHistory)->Arg(500);
+
+static void BM_BinaryDecodeColumnarHistory(benchmark::State& state) {
+    std::string frame;
+    to_binary(frame, Message::makePriceHistory(Bench::symbolName(0),
+        Bench::makeQuotes(1, static_cast<size_t>(state.range(0))), HistoryEncoding::Columnar));
+    Message msg{};
+    for (auto _ : state) {
+        from_binary(frame.data(), frame.size(), msg);
+        benchmark::DoNotOptimize(msg);
+    }
+    setItems(state, frame.size());
+}
+BENCHMARK(BM_BinaryDecodeColumnarHistory)->Arg(500);
+
+static void BM_JsonEncodeColumnarHistory(benchmark::State& state) {
+    Message msg = Message::makePriceHistory(Bench::symbolName(0),
+        Bench::makeQuotes(1, static_cast<size_t>(state.range(0))), HistoryEncoding::Columnar);
+    std::string out;
+    for (auto _ : state) {
+        json j = msg;
+        out = j.dump();
+        benchmark::DoNotOptimize(out.data());
+    }
+    setItems(state, out.size());
+    state.counters["frame_bytes"] = static_cast<double>(out.size());
+}
+BENCHMARK(BM_JsonEncodeColumnarHistory)->Arg(500);
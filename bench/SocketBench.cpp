@@ -0,0 +1,200 @@
+#include "BenchData.h"
+#include "StockTracker/Messages.h"
+#include "StockTracker/QuoteReplay.h"
+#include "StockTracker/Reactor.h"
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace StockTracker;
+
+// inproc:// works here because every MessageSocket defaults to sharedContext()
+
+static void BM_SocketRoundTrip(benchmark::State& state, const char* transport, WireFormat format) {
+    MessageSocket server(zmq::socket_type::rep);
+    server.setWireFormat(format);
+    server.setTimeout(50);
+    server.bind(Bench::freshEndpoint(transport));
+
+    std::atomic<bool> running{ true };
+    std::thread echo([&] {
+        Message request{};
+        while (running) {
+            if (server.receive(request)) {
+                server.send(request);
+            }
+        }
+    });
+
+    MessageSocket client(zmq::socket_type::req);
+    client.setWireFormat(format);
+    client.connect(Bench::boundEndpoint(server.getSocket()));
+
+    Message request = Message::makeQuoteUpdate(Bench::makeQuotes(1, 1).front());
+    Message reply{};
+    for (auto _ : state) {
+        client.send(request);
+        if (!client.receive(reply)) {
+            state.SkipWithError("No reply");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    running = false;
+    echo.join();
+}
+BENCHMARK_CAPTURE(BM_SocketRoundTrip, inproc_json, "inproc", WireFormat::Json)->UseRealTime();
+BENCHMARK_CAPTURE(BM_SocketRoundTrip, inproc_binary, "inproc", WireFormat::Binary)->UseRealTime();
+BENCHMARK_CAPTURE(BM_SocketRoundTrip, tcp_json, "tcp", WireFormat::Json)->UseRealTime();
+BENCHMARK_CAPTURE(BM_SocketRoundTrip, tcp_binary, "tcp", WireFormat::Binary)->UseRealTime();
+#ifndef _WIN32
+BENCHMARK_CAPTURE(BM_SocketRoundTrip, ipc_json, "ipc", WireFormat::Json)->UseRealTime();
+BENCHMARK_CAPTURE(BM_SocketRoundTrip, ipc_binary, "ipc", WireFormat::Binary)->UseRealTime();
+#endif
+
+// One iteration pushes a burst of quote updates and waits until the receiver has parsed all of them
+static void BM_SocketThroughput(benchmark::State& state, const char* transport, WireFormat format) {
+    constexpr int64_t BURST = 1000;
+
+    MessageSocket pull(zmq::socket_type::pull);
+    pull.setTimeout(50);
+    pull.bind(Bench::freshEndpoint(transport));
+
+    std::atomic<bool> running{ true };
+    std::atomic<int64_t> received{ 0 };
+    std::thread receiver([&] {
+        Message msg{};
+        while (running) {
+            if (pull.receive(msg)) {
+                received.fetch_add(1, std::memory_order_release);
+            }
+        }
+    });
+
+    MessageSocket push(zmq::socket_type::push);
+    push.setWireFormat(format);
+    push.connect(Bench::boundEndpoint(pull.getSocket()));
+
+    auto quotes = Bench::makeQuotes(1, BURST);
+    int64_t sent = 0;
+    for (auto _ : state) {
+        for (const auto& quote : quotes) {
+            push.send(Message::makeQuoteUpdate(quote));
+        }
+        sent += BURST;
+        while (received.load(std::memory_order_acquire) < sent) {
+            std::this_thread::yield();
+        }
+    }
+    state.SetItemsProcessed(sent);
+
+    running = false;
+    receiver.join();
+}
+BENCHMARK_CAPTURE(BM_SocketThroughput, inproc_json, "inproc", WireFormat::Json)->UseRealTime();
+BENCHMARK_CAPTURE(BM_SocketThroughput, inproc_binary, "inproc", WireFormat::Binary)->UseRealTime();
+BENCHMARK_CAPTURE(BM_SocketThroughput, tcp_json, "tcp", WireFormat::Json)->UseRealTime();
+BENCHMARK_CAPTURE(BM_SocketThroughput, tcp_binary, "tcp", WireFormat::Binary)->UseRealTime();
+#ifndef _WIN32
+BENCHMARK_CAPTURE(BM_SocketThroughput, ipc_json, "ipc", WireFormat::Json)->UseRealTime();
+BENCHMARK_CAPTURE(BM_SocketThroughput, ipc_binary, "ipc", WireFormat::Binary)->UseRealTime();
+#endif
+
+// QuoteReplayer at full speed into a receiving LatencyRecorder. Latency includes the time
+// quotes queue up behind the sender, so it is the latency at this transport's saturation
+// point. range(0) is the quote batch size (0 = one QuoteUpdate per quote).
+static void BM_ReplayLoopback(benchmark::State& state, const char* transport, WireFormat format) {
+    constexpr uint64_t BURST = 10000;
+    auto batch = static_cast<size_t>(state.range(0));
+
+    MessageSocket pull(zmq::socket_type::pull);
+    pull.setWireFormat(format);
+    pull.setTimeout(50);
+    pull.bind(Bench::freshEndpoint(transport));
+
+    LatencyRecorder recorder;
+    std::atomic<bool> running{ true };
+    std::thread receiver([&] {
+        Message msg{};
+        while (running) {
+            if (pull.receive(msg)) {
+                recorder.record(msg);
+            }
+        }
+    });
+
+    MessageSocket push(zmq::socket_type::push);
+    push.setWireFormat(format);
+    if (batch > 0) {
+        push.enableQuoteBatching(batch, std::chrono::milliseconds(1));
+    }
+    push.connect(Bench::boundEndpoint(pull.getSocket()));
+
+    QuoteReplayer replayer(push, ReplayOptions{ 0.0, true });
+    uint64_t sent = 0;
+    for (auto _ : state) {
+        SyntheticQuoteSource source(SyntheticQuoteOptions{ 1000, std::chrono::milliseconds(1000), 0.002, 42, BURST });
+        sent += replayer.run(source).sent;
+        while (recorder.received() < sent) {
+            std::this_thread::yield();
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(sent));
+
+    auto stats = recorder.stats();
+    state.counters["p50_us"] = static_cast<double>(stats.latency.p50_ns) / 1000.0;
+    state.counters["p99_us"] = static_cast<double>(stats.latency.p99_ns) / 1000.0;
+    state.counters["max_us"] = static_cast<double>(stats.latency.max_ns) / 1000.0;
+
+    running = false;
+    receiver.join();
+}
+BENCHMARK_CAPTURE(BM_ReplayLoopback, inproc_binary, "inproc", WireFormat::Binary)->Arg(0)->Arg(100)->UseRealTime();
+BENCHMARK_CAPTURE(BM_ReplayLoopback, tcp_binary, "tcp", WireFormat::Binary)->Arg(0)->Arg(100)->UseRealTime();
+BENCHMARK_CAPTURE(BM_ReplayLoopback, tcp_json, "tcp", WireFormat::Json)->Arg(0)->Arg(100)->UseRealTime();
+#ifndef _WIN32
+BENCHMARK_CAPTURE(BM_ReplayLoopback, ipc_binary, "ipc", WireFormat::Binary)->Arg(0)->Arg(100)->UseRealTime();
+#endif
+
+// Round trip through one Reactor serving range(0) REP sockets; shows what an idle
+// socket costs the poll loop
+static void BM_ReactorRoundTrip(benchmark::State& state) {
+    size_t count = static_cast<size_t>(state.range(0));
+
+    Reactor reactor;
+    Message request{};
+    std::vector<std::unique_ptr<MessageSocket>> servers;
+    std::vector<std::unique_ptr<MessageSocket>> clients;
+    for (size_t i = 0; i < count; ++i) {
+        auto& server = servers.emplace_back(std::make_unique<MessageSocket>(zmq::socket_type::rep));
+        server->setWireFormat(WireFormat::Binary);
+        server->bind(Bench::freshEndpoint("inproc"));
+        reactor.addSocket(*server, [&request](MessageSocket& socket) {
+            if (socket.receive(request, true)) {
+                socket.send(request);
+            }
+        });
+
+        auto& client = clients.emplace_back(std::make_unique<MessageSocket>(zmq::socket_type::req));
+        client->setWireFormat(WireFormat::Binary);
+        client->connect(Bench::boundEndpoint(server->getSocket()));
+    }
+    std::thread loop([&reactor] { reactor.run(); });
+
+    Message quote = Message::makeQuoteUpdate(Bench::makeQuotes(1, 1).front());
+    Message reply{};
+    size_t n = 0;
+    for (auto _ : state) {
+        auto& client = *clients[n++ % count];
+        client.send(quote);
+        client.receive(reply);
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    reactor.stop();
+    loop.join();
+}
+BENCHMARK(BM_ReactorRoundTrip)->Arg(1)->Arg(16)->Arg(256)->UseRealTime();
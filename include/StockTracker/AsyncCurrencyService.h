@@ -0,0 +1,87 @@
+#pragma once
+#include "CurrencyService.h"
+#include <zmq.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace StockTracker {
+
+    // Pipelined client for the currency service.
+    //
+    // Uses a DEALER socket and tags every request with an id envelope, which the
+    // service's REP socket echoes back. Any number of conversions can be in flight,
+    // each with its own deadline. A background thread owns the socket, so the
+    // methods below are safe to call from any thread.
+    class AsyncCurrencyService {
+    public:
+        // Called exactly once per request, on the I/O thread. `error` is set on failure.
+        // Keep it short: it runs on the I/O thread and delays other replies.
+        using Callback = std::function<void(double converted, std::exception_ptr error)>;
+
+        explicit AsyncCurrencyService(const std::string& endpoint = CurrencyService::DEFAULT_ENDPOINT,
+            std::chrono::milliseconds default_timeout = std::chrono::milliseconds(2000),
+            std::shared_ptr<zmq::context_t> context = sharedContext());
+        ~AsyncCurrencyService();
+
+        AsyncCurrencyService(const AsyncCurrencyService&) = delete;
+        AsyncCurrencyService& operator=(const AsyncCurrencyService&) = delete;
+
+        // Convert amount from USD to target currency
+        std::future<double> convertAsync(double amount, const std::string& to_currency,
+            std::optional<std::chrono::milliseconds> timeout = std::nullopt);
+        void convertAsync(double amount, const std::string& to_currency, Callback callback,
+            std::optional<std::chrono::milliseconds> timeout = std::nullopt);
+
+        size_t inFlight() const { return inFlightCount.load(); }
+        // Number of times the socket was replaced because the service stopped answering
+        uint64_t reconnects() const { return reconnectCount.load(); }
+
+    private:
+        struct Request {
+            uint64_t id;
+            std::string payload;
+            std::chrono::steady_clock::time_point submitted_at;
+            std::chrono::steady_clock::time_point sent_at;
+            std::chrono::steady_clock::time_point deadline;
+            Callback callback;
+        };
+
+        std::string endpoint;
+        std::chrono::milliseconds defaultTimeout;
+
+        std::shared_ptr<zmq::context_t> context;
+        std::unique_ptr<zmq::socket_t> dealer;   // I/O thread only
+        zmq::socket_t wakeReceiver;              // I/O thread only
+        zmq::socket_t wakeSender;
+
+        std::mutex outboxMutex;   // Guards outbox, nextId, stopping and wakeSender
+        std::vector<Request> outbox;
+        uint64_t nextId{ 1 };
+        bool stopping{ false };
+
+        std::unordered_map<uint64_t, Request> pending;   // I/O thread only
+        std::chrono::steady_clock::time_point lastReplyAt;
+        std::atomic<size_t> inFlightCount{ 0 };
+        std::atomic<uint64_t> reconnectCount{ 0 };
+
+        std::thread ioThread;
+
+        void run();
+        void connectDealer();
+        void sendQueued();
+        void receiveReplies();
+        void expireRequests();
+        void complete(Request& request, double converted, std::exception_ptr error);
+    };
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "Types.h"
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace StockTracker {
+
+    struct BarAggregatorOptions {
+        // Bar sizes maintained for every symbol. Bars are aligned to the Unix epoch (UTC),
+        // so daily bars start at midnight UTC.
+        std::vector<std::chrono::seconds> intervals{
+            std::chrono::seconds(1), std::chrono::minutes(1), std::chrono::hours(1), std::chrono::hours(24) };
+    };
+
+    // Ticks folded into one bar since it was last written out. A delta may cover only part
+    // of its bar; deltas for the same bar combine with merge(), in any order.
+    struct BarDelta {
+        std::string symbol;
+        OhlcvBar bar;
+        std::chrono::system_clock::time_point first_tick;  // Tick that set bar.open
+        std::chrono::system_clock::time_point last_tick;   // Tick that set bar.close
+    };
+
+    // Builds OHLCV bars incrementally from a stream of quotes.
+    //
+    // Each (symbol, interval) has one open bar. A quote past its end closes it and the
+    // closed delta waits in takeClosed() until the owner persists it. A quote older than the
+    // open bar becomes a closed single-tick delta of its own, to be merged with the stored bar.
+    // Thread-safe.
+    class BarAggregator {
+    public:
+        explicit BarAggregator(const BarAggregatorOptions& options = {});
+
+        void add(const StockQuote& quote);
+
+        // Deltas of bars that were closed since the last call
+        std::vector<BarDelta> takeClosed();
+        // Closed and open deltas. The open bars keep going, as new deltas, with the next quote.
+        std::vector<BarDelta> takeAll();
+
+        // Everything not yet taken for `symbol` at `interval` with open_time in [from, to)
+        std::vector<BarDelta> pending(const std::string& symbol, std::chrono::seconds interval,
+            std::chrono::system_clock::time_point from, std::chrono::system_clock::time_point to) const;
+
+        // Forget untaken state for `symbol` (used when its bars are rebuilt from stored ticks)
+        void discard(const std::string& symbol);
+
+        const std::vector<std::chrono::seconds>& intervals() const { return options.intervals; }
+        bool hasInterval(std::chrono::seconds interval) const;
+
+        // Fold `other` into `into`; both must describe the same bar
+        static void merge(BarDelta& into, const BarDelta& other);
+        // Start of the bar of `interval` that contains `time`
+        static std::chrono::system_clock::time_point bucketStart(std::chrono::system_clock::time_point time,
+            std::chrono::seconds interval);
+
+    private:
+        BarAggregatorOptions options;
+
+        mutable std::mutex mutex;
+        // One slot per configured interval, in options.intervals order
+        std::unordered_map<std::string, std::vector<std::optional<BarDelta>>> open;
+        std::vector<BarDelta> closed;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+#include "Messages.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace StockTracker {
+
+    // Compact binary encoding for Message / StockQuote.
+    //
+    // Frame layout (all integers little-endian):
+    //   u8  format      BINARY_FORMAT_V1
+    //   u8  type        MessageType
+    //   var fields      bitmask of present optional fields
+    //   str symbol
+    //   str currency
+    //   [quote] [error] [priceHistory] [subscriptions] [quotes] [stats] [barQuery] [bars]
+    //   [historyEncoding] [packedHistory] [sentAt] [since] [subscriptionsVersion]
+    //   [removedSubscriptions]
+    //
+    // Strings and counts are prefixed with a LEB128 varint length. "fields" is a varint
+    // so new optional fields can be added; below 0x80 it is the same single byte as before.
+    // The decoder rejects bits it doesn't know (in "fields", the per-quote flags and the
+    // indicators byte), so only send a new field to peers that can read it.
+    // With HistoryEncoding::Columnar, priceHistory is sent as packedHistory instead: one
+    // length-prefixed HistoryCodec block. sentAt and since are fixed 8-byte integers (since in
+    // milliseconds since the epoch), subscriptionsVersion a varint.
+    // JSON frames always start with '{', so the first byte tells the two formats apart.
+    constexpr uint8_t BINARY_FORMAT_V1 = 0xB1;
+
+    // True if the frame was produced by to_binary (as opposed to a JSON frame)
+    bool isBinaryFrame(const void* data, size_t size);
+
+    // Binary serialization. to_binary appends the encoded frame to `out`.
+    void to_binary(std::string& out, const Message& msg);
+    void to_binary(std::string& out, const StockQuote& quote);
+
+    // Binary deserialization. Throws std::runtime_error on malformed input.
+    // Fields already present in `msg` are overwritten in place, so reusing one Message
+    // across calls reuses its string and vector capacity.
+    void from_binary(const void* data, size_t size, Message& msg);
+}
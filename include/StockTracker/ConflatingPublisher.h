@@ -0,0 +1,73 @@
+#pragma once
+#include "Messages.h"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+namespace StockTracker {
+
+    struct ConflationStats {
+        uint64_t published{ 0 };    // Messages handed to publish()
+        uint64_t sent{ 0 };         // Messages actually written to the socket
+        uint64_t conflated{ 0 };    // Quote updates replaced by a newer quote for the same symbol
+        uint64_t dropped{ 0 };      // Non-quote messages discarded because the control queue was full
+        size_t pending{ 0 };        // Messages waiting for the subscribers to catch up
+    };
+
+    // Publisher that never lets quote updates pile up behind a slow subscriber.
+    //
+    // The socket is an XPUB with ZMQ_XPUB_NODROP, so a full subscriber queue makes sends
+    // fail instead of silently dropping. While that happens only the newest QuoteUpdate
+    // per symbol is kept; it goes out as soon as the subscribers drain. Other messages
+    // are queued, up to max_pending_control.
+    //
+    // Messages go out in the order they were published, with one exception: a conflated
+    // quote keeps the place of the symbol's first pending update, so it can overtake
+    // messages published between the two. A subscriber is never behind a message it has
+    // received: each symbol's quote is at least as new as any published before it.
+    // Not thread-safe, like MessageSocket.
+    class ConflatingPublisher {
+    public:
+        explicit ConflatingPublisher(size_t max_pending_control = 1024, int send_hwm = 1000,
+            std::shared_ptr<zmq::context_t> context = sharedContext());
+
+        void bind(const std::string& endpoint) { socket.bind(endpoint); }
+        MessageSocket& getSocket() { return socket; }
+
+        // Queue a message and send whatever the socket accepts right now
+        void publish(Message msg);
+
+        // Send queued messages until the queue is empty or the socket would block.
+        // Returns the number of messages sent.
+        size_t pump();
+        // Like pump(), but waits up to `timeout` for slow subscribers to drain
+        size_t pump(std::chrono::milliseconds timeout);
+
+        ConflationStats stats() const;
+
+    private:
+        MessageSocket socket;
+        size_t maxPendingControl;
+
+        // Both queues are ordered by one publish sequence, so pump() can merge them
+        struct PendingControl {
+            uint64_t sequence;
+            Message message;
+        };
+        struct PendingQuote {
+            uint64_t sequence;
+            std::string symbol;     // Key into latestQuotes
+        };
+
+        uint64_t nextSequence{ 0 };
+        std::deque<PendingControl> pendingControl;
+        std::unordered_map<std::string, Message> latestQuotes;
+        std::deque<PendingQuote> quoteOrder;   // Symbols in latestQuotes, oldest first
+
+        ConflationStats counters;
+
+        void drainSubscriptions();
+    };
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <zmq.hpp>
+#include <memory>
+
+namespace StockTracker {
+
+    struct ContextOptions {
+        int io_threads = 1;         // ZMQ_IO_THREADS; one thread handles roughly a gigabit per second
+        int max_sockets = 1024;     // ZMQ_MAX_SOCKETS
+    };
+
+    // A ZeroMQ context configured with `options`. Sockets must share a context to talk over inproc://.
+    std::shared_ptr<zmq::context_t> makeContext(const ContextOptions& options = {});
+
+    // Process-wide context used by MessageSocket, CurrencyService and friends when they
+    // aren't given one. Created on first use.
+    std::shared_ptr<zmq::context_t> sharedContext();
+
+    // Change the options of the shared context. Throws std::logic_error once it has been created.
+    void configureSharedContext(const ContextOptions& options);
+}
\ No newline at end of file
@@ -0,0 +1,182 @@
+#pragma once
+// Coroutine front end for Reactor, MessageSocket and AsyncCurrencyService.
+//
+// The library itself builds as C++17; this header only contributes declarations
+// when it is included from a translation unit compiled with coroutine support (C++20).
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include "AsyncCurrencyService.h"
+#include "Messages.h"
+#include "Reactor.h"
+#include <spdlog/spdlog.h>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <string>
+
+namespace StockTracker {
+
+    // Fire-and-forget coroutine. It starts running immediately and frees itself when it
+    // finishes; an exception escaping it is logged. All the awaitables below resume the
+    // coroutine on the reactor thread, so a Task must be started on that thread (e.g. from
+    // a handler, a timer or Reactor::post) and never touches its sockets from anywhere else.
+    // A Task still suspended when its Reactor is destroyed is leaked, not resumed.
+    struct Task {
+        struct promise_type {
+            Task get_return_object() noexcept { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() noexcept {}
+            void unhandled_exception() noexcept {
+                try {
+                    throw;
+                }
+                catch (const std::exception& e) {
+                    spdlog::error("Coroutine task failed: {}", e.what());
+                }
+                catch (...) {
+                    spdlog::error("Coroutine task failed with an unknown exception");
+                }
+            }
+        };
+    };
+
+    // co_await receiveAsync(reactor, socket) suspends until a message arrives.
+    // With a timeout it yields std::nullopt if nothing arrived in time.
+    // Only one coroutine may wait on a socket at a time, and the socket must not be
+    // registered with the reactor otherwise while it waits.
+    class ReceiveAwaiter {
+    public:
+        ReceiveAwaiter(Reactor& reactor, MessageSocket& socket, std::optional<std::chrono::milliseconds> timeout)
+            : reactor(reactor)
+            , socket(socket)
+            , timeout(timeout)
+        {}
+
+        bool await_ready() {
+            // Skip the round trip through the reactor when a message is already queued
+            Message msg{};
+            if (socket.receive(msg, true)) {
+                result = std::move(msg);
+                return true;
+            }
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            reactor.addSocket(socket, [this, handle](MessageSocket& ready) {
+                Message msg{};
+                if (!ready.receive(msg, true)) {
+                    return;   // Not parseable or already gone; keep waiting
+                }
+                result = std::move(msg);
+                finish(handle);
+            });
+
+            if (timeout) {
+                timer = reactor.callLater(*timeout, [this, handle] {
+                    timer.reset();
+                    finish(handle);
+                });
+            }
+        }
+
+        std::optional<Message> await_resume() {
+            return std::move(result);
+        }
+
+    private:
+        Reactor& reactor;
+        MessageSocket& socket;
+        std::optional<std::chrono::milliseconds> timeout;
+        std::optional<Reactor::TimerId> timer;
+        std::optional<Message> result;
+
+        void finish(std::coroutine_handle<> handle) {
+            reactor.removeSocket(socket);
+            if (timer) {
+                reactor.cancelTimer(*timer);
+            }
+            handle.resume();
+        }
+    };
+
+    inline ReceiveAwaiter receiveAsync(Reactor& reactor, MessageSocket& socket,
+        std::optional<std::chrono::milliseconds> timeout = std::nullopt) {
+        return ReceiveAwaiter(reactor, socket, timeout);
+    }
+
+    // co_await convertAsync(reactor, fx, amount, "EUR") yields the converted amount or
+    // throws what AsyncCurrencyService reported. The reply arrives on the service's
+    // I/O thread and is handed back to the reactor thread before the coroutine resumes.
+    class ConvertAwaiter {
+    public:
+        ConvertAwaiter(Reactor& reactor, AsyncCurrencyService& service, double amount, std::string to_currency,
+            std::optional<std::chrono::milliseconds> timeout)
+            : reactor(reactor)
+            , service(service)
+            , amount(amount)
+            , toCurrency(std::move(to_currency))
+            , timeout(timeout)
+        {}
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            service.convertAsync(amount, toCurrency, [this, handle](double result, std::exception_ptr failure) {
+                converted = result;
+                error = failure;
+                reactor.post([handle] { handle.resume(); });
+            }, timeout);
+        }
+
+        double await_resume() {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return converted;
+        }
+
+    private:
+        Reactor& reactor;
+        AsyncCurrencyService& service;
+        double amount;
+        std::string toCurrency;
+        std::optional<std::chrono::milliseconds> timeout;
+        double converted{ 0.0 };
+        std::exception_ptr error;
+    };
+
+    inline ConvertAwaiter convertAsync(Reactor& reactor, AsyncCurrencyService& service, double amount,
+        std::string to_currency, std::optional<std::chrono::milliseconds> timeout = std::nullopt) {
+        return ConvertAwaiter(reactor, service, amount, std::move(to_currency), timeout);
+    }
+
+    // co_await sleepFor(reactor, delay) resumes after `delay` without blocking the loop
+    class SleepAwaiter {
+    public:
+        SleepAwaiter(Reactor& reactor, std::chrono::milliseconds delay)
+            : reactor(reactor)
+            , delay(delay)
+        {}
+
+        bool await_ready() const noexcept { return delay.count() <= 0; }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            reactor.callLater(delay, [handle] { handle.resume(); });
+        }
+
+        void await_resume() const noexcept {}
+
+    private:
+        Reactor& reactor;
+        std::chrono::milliseconds delay;
+    };
+
+    inline SleepAwaiter sleepFor(Reactor& reactor, std::chrono::milliseconds delay) {
+        return SleepAwaiter(reactor, delay);
+    }
+}
+
+#endif
\ No newline at end of file
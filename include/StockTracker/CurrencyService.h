@@ -1,31 +1,82 @@
 ﻿#pragma once
+#include "Context.h"
+#include "Types.h"
 #include <zmq.hpp>
 #include <string>
 #include <memory>
+#include <chrono>
+#include <unordered_map>
+#include <vector>
 #include <nlohmann/json.hpp>
 
 namespace StockTracker {
 
     class CurrencyService {
     public:
-        CurrencyService();
+        explicit CurrencyService(const std::string& endpoint = DEFAULT_ENDPOINT,
+            std::shared_ptr<zmq::context_t> context = sharedContext());
         ~CurrencyService() = default;
 
         // Convert amount from USD to target currency
         double convertCurrency(double amount, const std::string& to_currency);
 
+        // Convert a batch of USD amounts with a single rate lookup
+        std::vector<double> convertMany(const std::vector<double>& amounts, const std::string& to_currency);
+
+        // Convert `count` amounts in place, e.g. a column of prices. One rate lookup, then a
+        // plain multiply loop the compiler vectorizes.
+        void convertInPlace(double* amounts, size_t count, const std::string& to_currency,
+            const std::string& from_currency = DEFAULT_CURRENCY);
+
+        // Convert quotes (a price history or a quote batch) to to_currency in place: price and
+        // the price-valued indicators are scaled and `currency` is rewritten. Quotes may be in
+        // any supported currency; each distinct one costs one rate lookup. change_percent and
+        // volatility are ratios, so they don't change. Throws before touching anything if a
+        // currency is unsupported, including an invalid to_currency with no quotes.
+        void convertQuotes(std::vector<StockQuote>& quotes, const std::string& to_currency);
+
+        // USD -> to_currency rate, served from cache while younger than the TTL
+        double getRate(const std::string& to_currency);
+
+        // How long a fetched rate is reused. Zero disables caching.
+        void setRateTtl(std::chrono::milliseconds ttl) { rateTtl = ttl; }
+        void clearRateCache() { rates.clear(); }
+
         // Get currency symbol (e.g., "$" for USD, "€" for EUR)
         static std::string getCurrencySymbol(const std::string& currency_code);
 
         // Check if currency code is valid
         static bool isValidCurrencyCode(const std::string& currency);
 
+        // Wire protocol shared with AsyncCurrencyService
+        static std::string makeConversionRequest(double amount, const std::string& to_currency);
+        static double parseConversionReply(const void* data, size_t size);
+
+        static inline const std::string DEFAULT_ENDPOINT = "tcp://localhost:5555";
+
     private:
-        std::unique_ptr<zmq::context_t> context;
+        struct CachedRate {
+            double rate;
+            std::chrono::steady_clock::time_point fetched_at;
+        };
+
+        std::shared_ptr<zmq::context_t> context;
         std::unique_ptr<zmq::socket_t> socket;
+        std::string endpoint;
+        std::unordered_map<std::string, CachedRate> rates;
+        std::chrono::milliseconds rateTtl{ std::chrono::seconds(60) };
+
+        static inline const std::string DEFAULT_CURRENCY = "USD";
+        static constexpr int REPLY_TIMEOUT_MS = 2000;
+
+        // Replace the REQ socket after a lost reply; REQ refuses to send again until it receives one
+        void resetSocket();
+
+        // Round-trip to the currency service for a single conversion
+        double requestConversion(double amount, const std::string& to_currency);
 
-        const std::string DEFAULT_CURRENCY = "USD";
-        const std::string ENDPOINT = "tcp://localhost:5555";
+        // Multiplier taking amounts in from_currency to to_currency
+        double conversionFactor(const std::string& from_currency, const std::string& to_currency);
 
         static const inline std::unordered_map<std::string, std::string> CURRENCY_SYMBOLS = {
             {"USD", "$"},
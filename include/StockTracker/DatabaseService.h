@@ -1,29 +1,232 @@
 #pragma once
 #include "Types.h"
+#include "QuoteCache.h"
+#include "BarAggregator.h"
+#include "PriceStore.h"
+#include "SqlitePriceStore.h"
 #include <sqlite3.h>
 #include <string>
 #include <vector>
 #include <memory>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
 
 namespace StockTracker {
 
+    // Tuning for the asynchronous savePrice path (see enableWriteBehind)
+    struct WriteBehindOptions {
+        size_t max_queue_size = 10000;                // savePrice blocks once this many quotes are pending
+        size_t max_batch_size = 500;                  // Quotes committed per transaction
+        std::chrono::milliseconds max_delay{ 50 };    // Longest a quote waits before being committed
+    };
+
+    // Read-only connections behind the concurrent read path (see enableReadPool)
+    struct ReadPoolOptions {
+        size_t connections = 4;                             // Reads beyond this many wait for a free connection
+        std::chrono::milliseconds busy_timeout{ 1000 };     // How long a read retries while SQLite reports busy
+    };
+
+    // A rollup level kept once raw ticks expire (see enableRetention)
+    struct RetentionTier {
+        std::chrono::seconds interval;          // Bar size in price_bars the ticks are rolled up into
+        std::chrono::hours keep{ 0 };           // Bars older than this are deleted; 0 keeps them forever
+    };
+
+    struct RetentionOptions {
+        std::chrono::hours raw_ticks{ 24 * 7 };     // Ticks older than this are rolled up and deleted
+        std::vector<RetentionTier> tiers{
+            { std::chrono::minutes(1), std::chrono::hours(24 * 90) },
+            { std::chrono::hours(1), std::chrono::hours(0) } };
+        size_t batch_size = 1000;                   // Rows removed per transaction
+    };
+
+    // Progress of one compact() call, reported after every batch
+    struct CompactionStats {
+        size_t symbols{ 0 };                    // Symbols whose raw ticks have been checked so far
+        uint64_t ticks_removed{ 0 };
+        uint64_t bars_written{ 0 };             // Rolled-up bars upserted into price_bars
+        uint64_t bars_removed{ 0 };             // Bars past their tier's keep time
+        uint64_t batches{ 0 };                  // Transactions committed
+        bool complete{ false };                 // Set once nothing is left to compact
+        std::chrono::milliseconds elapsed{ 0 };
+    };
+
     class DatabaseService {
     public:
         DatabaseService(const std::string& db_path = "stocktracker.db");
+        // Keep price history in `price_store` (e.g. a TickLogStore) instead of the price_history
+        // table; subscriptions and bars stay in the database. A null store means the table.
+        DatabaseService(const std::string& db_path, std::unique_ptr<PriceStore> price_store);
         ~DatabaseService();
 
         // Stock price history
         void savePrice(const StockQuote& quote);
         std::vector<StockQuote> getPriceHistory(const std::string& symbol, int limit = 5);
 
+        // Like getPriceHistory, but only quotes newer than `since`: what a client holding
+        // history up to `since` is missing (see Message::since). Timestamps are compared in
+        // whole milliseconds, the resolution quotes are stored and sent at.
+        std::vector<StockQuote> getPriceHistorySince(const std::string& symbol,
+            std::chrono::system_clock::time_point since, int limit = 5);
+
+        // Quotes with timestamp in [from, to), oldest first. A negative limit means no limit.
+        std::vector<StockQuote> getPriceHistoryRange(const std::string& symbol,
+            std::chrono::system_clock::time_point from,
+            std::chrono::system_clock::time_point to,
+            int limit = -1);
+
+        // Keyset pagination from newest to oldest. Pass page.next back in to get the following page.
+        PriceHistoryPage getPriceHistoryPage(const std::string& symbol, int limit,
+            std::optional<HistoryPageKey> after = std::nullopt);
+
+        // Same rows as getPriceHistoryRange, streamed through a cursor
+        PriceHistoryCursor openPriceHistoryCursor(const std::string& symbol,
+            std::chrono::system_clock::time_point from,
+            std::chrono::system_clock::time_point to);
+
+        // Calls `visit` for every quote in [from, to) in storage order, without collecting
+        // them first. For tools that walk long ranges (see HistoryQuoteSource).
+        void scanPriceHistory(const std::string& symbol,
+            std::chrono::system_clock::time_point from,
+            std::chrono::system_clock::time_point to,
+            const std::function<void(const StockQuote&)>& visit);
+
+        // Write-behind mode: savePrice only queues the quote and a background thread
+        // commits queued quotes in batches (one transaction per batch).
+        // Reads only see committed rows; call flush() first if you need read-your-writes.
+        void enableWriteBehind(const WriteBehindOptions& options = {});
+        // Queue a quote without blocking. Returns false if the queue is full.
+        bool trySavePrice(const StockQuote& quote);
+        // Block until every quote queued before this call is committed, write out open bars
+        // and sync the price store.
+        // Rethrows the writer thread's error if a batch failed.
+        void flush();
+        size_t pendingWrites() const;
+
+        // Keep the newest quotes of each symbol in memory (written through by savePrice)
+        // so getPriceHistory can answer recent windows without touching SQLite.
+        // Waits for queued writes to commit, since a symbol's rows from before this call
+        // decide which quotes its cache may hold. Call before the service is shared between threads.
+        void enableCache(const QuoteCacheOptions& options = {});
+        std::optional<QuoteCacheStats> cacheStats() const;
+
+        // Maintain OHLCV bars (table price_bars) from every quote passed to savePrice.
+        // Closed bars are written with the quotes; in write-behind mode the writer thread
+        // builds them from each batch once it has committed, so a dropped batch leaves no
+        // bars. Open bars are written by flush() and on destruction, and getBars merges in
+        // whatever is still in memory. Call before the service is shared between threads.
+        void enableBars(const BarAggregatorOptions& options = {});
+
+        // Bars are answered from price_bars plus in-memory state, never from raw ticks.
+        // Throws std::invalid_argument if bars are enabled but kept at query.interval neither
+        // by enableBars nor by a retention tier.
+        std::vector<OhlcvBar> getBars(const std::string& symbol, const BarQuery& query);
+
+        // Recompute the bars of every enabled interval that overlap [from, to) from price history,
+        // e.g. for ticks stored before bars were enabled. Flushes first; quotes queued in
+        // write-behind mode meanwhile are added to the bars when they commit.
+        void rebuildBars(const std::string& symbol,
+            std::chrono::system_clock::time_point from,
+            std::chrono::system_clock::time_point to);
+
+        // Serve getPriceHistory, getPriceHistoryRange, getPriceHistoryPage and getSubscriptions
+        // from a pool of read-only connections, each with its own prepared statements. They
+        // read WAL snapshots of committed data, so they run in parallel with each other and
+        // with ingest. Cursors, bars and writes stay on the main connection. Needs a file
+        // database. Call before the service is shared between threads.
+        void enableReadPool(const ReadPoolOptions& options = {});
+
+        // Age out price history: raw ticks are kept for options.raw_ticks, then folded into
+        // bars at each tier's interval and deleted, and bars are deleted after their tier's
+        // keep time. Nothing happens until compact() is called. Tiers at an interval that
+        // enableBars already maintains are not rolled up again, so bars enabled after ticks
+        // were stored need rebuildBars first. rebuildBars only sees ticks that are still kept.
+        // Call before the service is shared between threads.
+        void enableRetention(const RetentionOptions& options = {});
+
+        // Apply the retention policy now, in transactions of about batch_size rows each.
+        // Other calls get the database between batches, so ingest and reads carry on meanwhile.
+        // `progress` is called after each batch; returning false stops early, and the next
+        // call picks up where this one left off. Quotes still queued in write-behind mode
+        // are compacted by a later call.
+        CompactionStats compact(const std::function<bool(const CompactionStats&)>& progress = nullptr);
+
         // Subscriptions
         void saveSubscription(const std::string& symbol);
         void removeSubscription(const std::string& symbol);
         std::vector<std::string> getSubscriptions();
 
+        // Every saved or removed subscription gets the next version in table
+        // subscription_changes, which keeps only the latest change per symbol.
+        uint64_t subscriptionsVersion();
+        // Subscriptions added and removed after `since_version`, for a client holding the
+        // list at that version. 0, or a version this database never reached, gets the full
+        // list (delta.full). Served by the read pool like getSubscriptions.
+        SubscriptionDelta getSubscriptionChanges(uint64_t since_version);
+
     private:
+        struct ReadConnection;
+        class ReadLease;
+
+        std::string dbPath;
         sqlite3* db{ nullptr };
+        std::mutex dbMutex; // The writer thread and callers share one connection
+        std::unique_ptr<QuoteCache> cache;
+        std::unique_ptr<BarAggregator> bars;
+        std::unique_ptr<PriceStore> prices;   // Called only under dbMutex
+        bool pricesInDatabase{ false };         // prices is the price_history table on `db`
+        std::optional<RetentionOptions> retention;
+
+        // Prepared once in the constructor, then reset and rebound on every call
+        sqlite3_stmt* saveSubscriptionStmt{ nullptr };
+        sqlite3_stmt* removeSubscriptionStmt{ nullptr };
+        sqlite3_stmt* subscriptionsStmt{ nullptr };
+        sqlite3_stmt* logSubscriptionStmt{ nullptr };
+        sqlite3_stmt* pruneSubscriptionLogStmt{ nullptr };
+        sqlite3_stmt* subscriptionsVersionStmt{ nullptr };
+        sqlite3_stmt* subscriptionChangesStmt{ nullptr };
+        sqlite3_stmt* upsertBarStmt{ nullptr };
+        sqlite3_stmt* barRangeStmt{ nullptr };
+
+        // Idle read-only connections, guarded by readPoolMutex. Empty unless enableReadPool was called.
+        size_t readPoolSize{ 0 };
+        bool pooledPrices{ false };     // Price history lives in the database, so readers query it
+        std::vector<std::unique_ptr<ReadConnection>> idleReaders;
+        std::mutex readPoolMutex;
+        std::condition_variable readerAvailable;
+
+        // Write-behind state, guarded by queueMutex
+        WriteBehindOptions writeBehindOptions;
+        bool writeBehind{ false };
+        bool stopWriter{ false };
+        bool flushRequested{ false };
+        std::deque<StockQuote> writeQueue;
+        uint64_t queuedCount{ 0 };
+        uint64_t committedCount{ 0 };
+        std::exception_ptr writerError;
+        mutable std::mutex queueMutex;
+        std::condition_variable queueNotEmpty;
+        std::condition_variable queueNotFull;
+        std::condition_variable batchCommitted;
+        std::thread writerThread;
+
         void initializeTables();
+        void prepareStatements();
+        void finalizeStatements();
+        void writeBars(const std::vector<BarDelta>& deltas);
+        void logSubscriptionChange(const std::string& symbol, bool added);
+        void writerLoop();
+        void waitForWriter();
+        void stopWriteBehind();
+        void rethrowWriterError();
+        template <typename Read>
+        auto readPrices(Read&& read);
     };
 
-}
\ No newline at end of file
+}
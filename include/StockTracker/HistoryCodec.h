@@ -0,0 +1,33 @@
+#pragma once
+#include "Types.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace StockTracker {
+
+    // Columnar, compressed encoding of one symbol's price history (HistoryEncoding::Columnar).
+    //
+    // Block layout:
+    //   var count
+    //   str symbol, str currency    stated once for every row
+    //   bit stream, MSB first:
+    //     timestamps   first value in 64 bits, then delta-of-delta in 1 to 68 bits
+    //     prices       first value in 64 bits, then XOR with the previous value (Gorilla)
+    //     change       one presence bit per row, present values XOR-encoded as above
+    //
+    // Evenly spaced ticks cost one bit per timestamp, and unchanged prices one bit each.
+    // Timestamps use the same representation as the row encodings, so a history decodes
+    // to the same quotes whichever way it was sent.
+
+    // False if the rows don't share one symbol and currency, or carry indicators
+    bool canEncodeHistory(const std::vector<StockQuote>& history);
+
+    // Appends the block for `history` to `out`. Throws std::invalid_argument if
+    // canEncodeHistory(history) is false.
+    void encodeHistory(std::string& out, const std::vector<StockQuote>& history);
+
+    // Replaces the contents of `history` with the rows of a block, reusing its storage.
+    // Throws std::runtime_error on malformed input.
+    void decodeHistory(const void* data, size_t size, std::vector<StockQuote>& history);
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "Types.h"
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace StockTracker {
+
+    class Message;
+
+    struct IndicatorOptions {
+        size_t sma_window = 20;             // Quotes averaged by the SMA
+        size_t ema_period = 20;             // EMA smoothing factor is 2 / (period + 1)
+        size_t volatility_window = 20;      // Log returns in the rolling volatility
+    };
+
+    // Per-symbol streaming analytics for quotes on their way out to clients.
+    //
+    // apply() updates the symbol's state in O(1) and stamps the quote with QuoteIndicators,
+    // plus change_percent against the previous UTC day's last price when the feed left it
+    // empty. Run every QuoteUpdate through it before it is published, so subscribers never
+    // need to fetch history to compute these. A quote older than the symbol's newest one
+    // gets the current values without changing them. Thread-safe.
+    class IndicatorEngine {
+    public:
+        explicit IndicatorEngine(const IndicatorOptions& options = {});
+
+        void apply(StockQuote& quote);
+        // Applies to msg.quote and every quote in msg.quotes
+        void apply(Message& msg);
+
+        // Seed the close that change_percent is measured against until the next day
+        // boundary, e.g. from the previous day's bar after a restart
+        void setPreviousClose(const std::string& symbol, double close);
+
+        void reset(const std::string& symbol);
+        void clear();
+
+    private:
+        // Fixed-size window with running sums. The sums are recomputed from the window every
+        // time it wraps, so rounding error can't build up over a long-running stream.
+        struct RollingWindow {
+            std::vector<double> values;
+            size_t next{ 0 };
+            size_t count{ 0 };
+            double sum{ 0.0 };
+            double sumSquares{ 0.0 };
+
+            void push(double value);
+            double mean() const { return sum / static_cast<double>(count); }
+            double sampleStdDev() const;
+        };
+
+        struct SymbolState {
+            int64_t day{ 0 };   // UTC day of the newest quote
+            std::chrono::system_clock::time_point lastTimestamp;
+            double lastPrice{ 0.0 };
+            bool started{ false };
+            std::optional<double> previousClose;
+
+            RollingWindow prices;
+            RollingWindow returns;
+            std::optional<double> ema;
+            double sessionSum{ 0.0 };
+            uint64_t sessionTicks{ 0 };
+
+            QuoteIndicators current;
+        };
+
+        IndicatorOptions options;
+        double emaAlpha;
+
+        std::mutex mutex;
+        std::unordered_map<std::string, SymbolState> symbols;
+
+        SymbolState& state(const std::string& symbol);
+        void update(SymbolState& state, const StockQuote& quote);
+    };
+}
\ No newline at end of file
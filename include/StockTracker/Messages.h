@@ -1,9 +1,12 @@
 #pragma once
 #include "Types.h"
+#include "Context.h"
+#include "Metrics.h"
 #include <zmq.hpp>
 #include <memory>
 #include <optional>
 #include <vector>
+#include <chrono>
 #include <spdlog/spdlog.h>
 
 namespace StockTracker {
@@ -17,18 +20,44 @@ namespace StockTracker {
         std::optional<std::vector<StockQuote>> priceHistory;
         std::optional<std::vector<std::string>> subscriptions; // For subscriptions list
         std::string currency;
+        std::optional<std::vector<StockQuote>> quotes; // For quote batches
+        std::optional<MetricsSnapshot> stats; // For stats messages
+        std::optional<BarQuery> barQuery; // For bar history requests
+        std::optional<std::vector<OhlcvBar>> bars; // For bar history responses
+        HistoryEncoding historyEncoding{ HistoryEncoding::Rows }; // Requests: what the client reads. Responses: how priceHistory is sent.
+        std::optional<int64_t> sentAt; // Sender's steady_clock in ns, for end-to-end latency on one host (see QuoteReplay.h)
+        std::optional<std::chrono::system_clock::time_point> since; // History requests: only quotes newer than this. Responses: priceHistory holds only those.
+        std::optional<uint64_t> subscriptionsVersion; // RequestSubscriptions: version the client has. Lists and deltas: version they bring it to.
+        std::optional<std::vector<std::string>> removedSubscriptions; // For subscription deltas; added symbols go in subscriptions
 
         // Static factory methods (declarations only)
         static Message makeSubscribe(std::string symbol);
         static Message makeUnsubscribe(std::string symbol);
         static Message makeQuoteUpdate(StockQuote quote);
+        static Message makeQuoteBatch(std::vector<StockQuote> quotes);
         static Message makeQuery(std::string symbol);
         static Message makeError(std::string error);
-        static Message makeRequestSubscriptions();   // Request list of subscriptions
-        static Message makeSubscriptionsList(const std::vector<std::string>& subscriptions);
-        static Message makeRequestPriceHistory(const std::string& symbol);  // Request price history
-        static Message makePriceHistory(const std::string& symbol, const std::vector<StockQuote>& history);
+        // Request list of subscriptions. A reconnecting client passes the version of the
+        // list it holds and gets a SubscriptionsDelta back instead of the whole list.
+        static Message makeRequestSubscriptions(std::optional<uint64_t> since_version = std::nullopt);
+        static Message makeSubscriptionsList(const std::vector<std::string>& subscriptions,
+            std::optional<uint64_t> version = std::nullopt);
+        // SubscriptionsDelta, or a versioned SubscriptionsList when delta.full is set
+        static Message makeSubscriptionsDelta(const SubscriptionDelta& delta);
+        // Request price history. With `since` (the newest quote the client holds) the
+        // response only carries newer quotes (see DatabaseService::getPriceHistorySince).
+        static Message makeRequestPriceHistory(const std::string& symbol,
+            HistoryEncoding accept = HistoryEncoding::Rows,
+            std::optional<std::chrono::system_clock::time_point> since = std::nullopt);
+        // Pass the request's historyEncoding and since through. Falls back to Rows if the
+        // history can't be sent columnar (see canEncodeHistory).
+        static Message makePriceHistory(const std::string& symbol, const std::vector<StockQuote>& history,
+            HistoryEncoding encoding = HistoryEncoding::Rows,
+            std::optional<std::chrono::system_clock::time_point> since = std::nullopt);
         static Message makeSetCurrency(std::string currency_code);
+        static Message makeStats(MetricsSnapshot snapshot);
+        static Message makeRequestBars(const std::string& symbol, const BarQuery& query);  // Request OHLCV bars
+        static Message makeBarHistory(const std::string& symbol, std::vector<OhlcvBar> bars);
     };
 
     // JSON serialization declarations
@@ -38,16 +67,46 @@ namespace StockTracker {
     // MessageSocket class
     class MessageSocket {
     private:
-        std::unique_ptr<zmq::context_t> context;
+        std::shared_ptr<zmq::context_t> context;
         std::unique_ptr<zmq::socket_t> socket;
+        WireFormat wireFormat{ WireFormat::Json };
+        bool topicFraming{ false };
+
+        // Quote batching state (see enableQuoteBatching)
+        size_t maxBatchQuotes{ 0 };
+        std::chrono::milliseconds maxBatchDelay{ 0 };
+        std::vector<StockQuote> pendingQuotes;
+        std::chrono::steady_clock::time_point batchStartedAt;
+        std::optional<int64_t> batchSentAt;
+
+        // Reused across calls so the steady-state send/receive loop doesn't allocate.
+        // JSON messages are serialized into sendBuffer too, but still build a json value each.
+        struct JsonWriter;
+        std::string sendBuffer;
+        std::string topicBuffer;
+        std::shared_ptr<JsonWriter> jsonWriter;     // Created by the first JSON send
+        zmq::message_t receiveFrame;
+
+        bool sendFrames(const Message& msg, zmq::send_flags flags);
+        // Sends pendingQuotes as one QuoteBatch. Returns false, keeping them, if it would block.
+        bool sendQuoteBatch(zmq::send_flags flags);
 
     public:
-        explicit MessageSocket(zmq::socket_type type);
+        // Sockets share sharedContext() unless given their own; inproc:// peers need the same one
+        explicit MessageSocket(zmq::socket_type type, std::shared_ptr<zmq::context_t> context = sharedContext());
         void bind(const std::string& endpoint);
         void connect(const std::string& endpoint);
         void send(const Message& msg);
+        // Non-blocking send. Returns false (msg not sent) if the socket would block.
+        // Quotes batched by send() go out first; if they can't, nothing is sent.
+        bool trySend(const Message& msg);
         std::optional<Message> receive(bool nonBlocking = false);
 
+        // Parses straight from the ZMQ frame into `msg`, reusing its storage.
+        // Returns false if nothing was received or the frame could not be parsed.
+        // With binary frames a long-lived `msg` makes the receive loop allocation-free.
+        bool receive(Message& msg, bool nonBlocking = false);
+
         // For string options specifically (like subscribe)
         void setSubscribe(const std::string& topic = "") {
             socket->set(zmq::sockopt::subscribe, topic);
@@ -58,6 +117,44 @@ namespace StockTracker {
             socket->set(zmq::sockopt::rcvtimeo, timeout_ms);
         }
 
+        // Encoding used by send(). receive() accepts both formats regardless.
+        // Keep Json while any peer still runs a JSON-only build.
+        void setWireFormat(WireFormat format) {
+            wireFormat = format;
+        }
+
+        // Topic framing (PUB side): every message goes out as [topic][payload].
+        // Quote updates use symbolTopic(symbol), everything else CONTROL_TOPIC, so
+        // subscribers can filter inside ZeroMQ instead of parsing every update.
+        // receive() understands both framed and single-frame messages.
+        void setTopicFraming(bool enabled);
+
+        // SUB side filters matching the topics above
+        void subscribeSymbol(const std::string& symbol) {
+            socket->set(zmq::sockopt::subscribe, symbolTopic(symbol));
+        }
+        void unsubscribeSymbol(const std::string& symbol) {
+            socket->set(zmq::sockopt::unsubscribe, symbolTopic(symbol));
+        }
+        void subscribeControl() {
+            socket->set(zmq::sockopt::subscribe, CONTROL_TOPIC);
+        }
+
+        // The trailing NUL stops "AAPL" from prefix-matching "AAPLX"
+        static std::string symbolTopic(const std::string& symbol) {
+            return symbol + '\0';
+        }
+        static inline const std::string CONTROL_TOPIC = "#";
+
+        // Coalesce QuoteUpdates passed to send() into QuoteBatch messages. A batch goes
+        // out once it holds max_quotes, when a send() finds it older than max_delay, or
+        // before any other message, including one passed to trySend() (to keep ordering).
+        // Call flushQuoteBatch() from a timer if updates can stop arriving. Not compatible
+        // with topic framing, since a batch spans several symbols.
+        void enableQuoteBatching(size_t max_quotes, std::chrono::milliseconds max_delay);
+        void flushQuoteBatch();
+
         zmq::socket_t& getSocket() { return *socket; }
+        const std::shared_ptr<zmq::context_t>& getContext() const { return context; }
     };
 }
\ No newline at end of file
@@ -0,0 +1,167 @@
+#pragma once
+#include "Types.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <vector>
+
+// Instrumentation is compiled in unless the build defines STOCKTRACKER_ENABLE_METRICS=0.
+// When it is off, MetricTimer and Metrics::record are empty inlines and cost nothing.
+#ifndef STOCKTRACKER_ENABLE_METRICS
+#define STOCKTRACKER_ENABLE_METRICS 1
+#endif
+
+namespace StockTracker {
+
+    // Instrumented operations. Socket metrics are additionally split by MessageType.
+    enum class Metric {
+        SocketSend,             // Encoding a message and handing it to ZeroMQ
+        SocketReceive,          // Decoding a received frame (time spent waiting for it is not counted)
+        DbSavePrice,            // savePrice / trySavePrice (only the enqueue in write-behind mode)
+        DbWriteBatch,           // One write-behind transaction
+        DbPriceHistory,
+        DbPriceHistoryRange,
+        DbPriceHistoryPage,
+        DbBars,                 // getBars
+        DbSubscriptions,        // saveSubscription / removeSubscription / getSubscriptions
+        DbCompactBatch,         // One compact() transaction
+        CurrencyConvert,        // One request/reply with the currency service
+        CurrencyConvertAsync    // AsyncCurrencyService, from convertAsync() to completion
+    };
+
+    struct MetricStats {
+        std::string name;       // e.g. "socket.send.quote_update", "db.save_price"
+        uint64_t count{ 0 };
+        uint64_t errors{ 0 };   // Samples recorded as failed (included in count)
+        uint64_t bytes{ 0 };    // Payload bytes, where the operation has a size
+        uint64_t mean_ns{ 0 };
+        uint64_t p50_ns{ 0 };
+        uint64_t p90_ns{ 0 };
+        uint64_t p99_ns{ 0 };
+        uint64_t p999_ns{ 0 };
+        uint64_t max_ns{ 0 };
+    };
+
+    struct MetricsSnapshot {
+        std::chrono::system_clock::time_point taken_at;
+        std::vector<MetricStats> metrics;   // Only metrics that recorded at least one sample
+    };
+
+    void to_json(json& j, const MetricStats& stats);
+    void from_json(const json& j, MetricStats& stats);
+    void to_json(json& j, const MetricsSnapshot& snapshot);
+    void from_json(const json& j, MetricsSnapshot& snapshot);
+
+    // Log-linear latency histogram in the style of HdrHistogram: each power of two is split
+    // into 8 linear sub-buckets, so percentiles are reported within 12.5% of the true value.
+    // Values from 1ns to ~37 minutes are tracked; larger ones land in the last bucket.
+    // Updates are relaxed atomics, so recording never blocks; a snapshot taken while other
+    // threads record may be off by the samples in flight.
+    class LatencyHistogram {
+    public:
+        static constexpr int SUB_BUCKET_BITS = 3;
+        static constexpr int MAX_MAGNITUDE = 41;
+        static constexpr size_t BUCKET_COUNT = (MAX_MAGNITUDE - SUB_BUCKET_BITS + 2) << SUB_BUCKET_BITS;
+
+        void record(uint64_t nanos, bool ok, size_t bytes) noexcept;
+        void reset() noexcept;
+        // Fills everything but the name
+        void snapshot(MetricStats& stats) const;
+
+        static size_t bucketIndex(uint64_t nanos) noexcept;
+        // Largest value that maps to the bucket
+        static uint64_t bucketValue(size_t index) noexcept;
+
+    private:
+        std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets{};
+        std::atomic<uint64_t> count{ 0 };
+        std::atomic<uint64_t> errors{ 0 };
+        std::atomic<uint64_t> bytes{ 0 };
+        std::atomic<uint64_t> totalNanos{ 0 };
+        std::atomic<uint64_t> maxNanos{ 0 };
+    };
+
+    // Process-wide registry of the instrumented operations
+    class Metrics {
+    public:
+        static constexpr bool enabled = STOCKTRACKER_ENABLE_METRICS != 0;
+
+#if STOCKTRACKER_ENABLE_METRICS
+        static void record(Metric metric, std::chrono::nanoseconds elapsed, bool ok = true, size_t bytes = 0) noexcept;
+        static void record(Metric metric, MessageType type, std::chrono::nanoseconds elapsed, bool ok = true, size_t bytes = 0) noexcept;
+        static MetricsSnapshot snapshot();
+        static void reset();
+#else
+        static void record(Metric, std::chrono::nanoseconds, bool = true, size_t = 0) noexcept {}
+        static void record(Metric, MessageType, std::chrono::nanoseconds, bool = true, size_t = 0) noexcept {}
+        static MetricsSnapshot snapshot() { return { std::chrono::system_clock::now(), {} }; }
+        static void reset() {}
+#endif
+    };
+
+    // Records the time between construction and destruction. A sample is counted as an
+    // error if fail() was called or the scope is left by an exception.
+    class MetricTimer {
+    public:
+        MetricTimer(const MetricTimer&) = delete;
+        MetricTimer& operator=(const MetricTimer&) = delete;
+
+#if STOCKTRACKER_ENABLE_METRICS
+        explicit MetricTimer(Metric metric) noexcept
+            : metric(metric)
+            , start(std::chrono::steady_clock::now())
+            , exceptions(std::uncaught_exceptions())
+        {}
+
+        MetricTimer(Metric metric, MessageType type) noexcept
+            : MetricTimer(metric)
+        {
+            setType(type);
+        }
+
+        ~MetricTimer() {
+            if (cancelled) {
+                return;
+            }
+            bool ok = !failed && std::uncaught_exceptions() == exceptions;
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            if (typed) {
+                Metrics::record(metric, type, elapsed, ok, bytes);
+            }
+            else {
+                Metrics::record(metric, elapsed, ok, bytes);
+            }
+        }
+
+        void setType(MessageType message_type) noexcept {
+            type = message_type;
+            typed = true;
+        }
+        void setBytes(size_t size) noexcept { bytes = size; }
+        void fail() noexcept { failed = true; }
+        // Drop the sample (e.g. a receive that timed out)
+        void cancel() noexcept { cancelled = true; }
+
+    private:
+        Metric metric;
+        MessageType type{};
+        bool typed{ false };
+        bool failed{ false };
+        bool cancelled{ false };
+        size_t bytes{ 0 };
+        std::chrono::steady_clock::time_point start;
+        int exceptions;
+#else
+        explicit MetricTimer(Metric) noexcept {}
+        MetricTimer(Metric, MessageType) noexcept {}
+
+        void setType(MessageType) noexcept {}
+        void setBytes(size_t) noexcept {}
+        void fail() noexcept {}
+        void cancel() noexcept {}
+#endif
+    };
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+#include "Types.h"
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+namespace StockTracker {
+
+    using SymbolId = uint32_t;
+
+    // Interns symbol and currency strings as small dense ids.
+    // Ids are never reused or freed, so names returned by name() stay valid for the table's lifetime.
+    class SymbolTable {
+    public:
+        SymbolId intern(std::string_view name);
+        // Like intern(name), but throws std::length_error instead of adding a name whose id
+        // would be above max_id, so a failed call leaves the table as it was
+        SymbolId intern(std::string_view name, SymbolId max_id);
+        std::optional<SymbolId> find(std::string_view name) const;
+        const std::string& name(SymbolId id) const;
+        size_t size() const;
+
+        // Process-wide table used by PackedQuote for symbols by default
+        static SymbolTable& global();
+        // Process-wide table for currency codes, kept apart so their ids stay small
+        static SymbolTable& currencies();
+
+    private:
+        mutable std::shared_mutex mutex;
+        std::deque<std::string> names;                       // Indexed by id, stable addresses
+        std::unordered_map<std::string_view, SymbolId> ids;  // Views into `names`
+    };
+
+    // Fixed-size, trivially copyable form of StockQuote for hot paths that move
+    // quotes around in contiguous arrays without touching the allocator.
+    // Indicators are not packed; they belong to the outgoing stream, not to stored quotes.
+    struct PackedQuote {
+        int64_t timestamp;       // system_clock ticks since epoch
+        double price;
+        double change_percent;   // Only meaningful if HAS_CHANGE_PERCENT is set
+        SymbolId symbol;
+        uint16_t currency;       // Id in SymbolTable::currencies()
+        uint16_t flags;
+
+        static constexpr uint16_t HAS_CHANGE_PERCENT = 1 << 0;
+
+        static PackedQuote pack(const StockQuote& quote, SymbolTable& table = SymbolTable::global());
+        StockQuote unpack(const SymbolTable& table = SymbolTable::global()) const;
+    };
+
+    static_assert(std::is_trivially_copyable_v<PackedQuote>, "PackedQuote must stay POD");
+    static_assert(sizeof(PackedQuote) == 32, "PackedQuote should fit in half a cache line");
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include "Types.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace StockTracker {
+
+    // Price stores keep timestamps as milliseconds since the epoch, the unit used on the
+    // wire, so every quote they return can be passed back in as a bound. Quotes come back
+    // at that resolution.
+    inline int64_t toStoredTimestamp(std::chrono::system_clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+    }
+
+    inline std::chrono::system_clock::time_point fromStoredTimestamp(int64_t stored) {
+        return std::chrono::system_clock::time_point(std::chrono::milliseconds(stored));
+    }
+
+    // Position in a symbol's history, used for keyset pagination. `timestamp` is a stored
+    // timestamp; rowid breaks ties between quotes with the same timestamp.
+    struct HistoryPageKey {
+        int64_t timestamp;
+        int64_t rowid;
+    };
+
+    struct PriceHistoryPage {
+        std::vector<StockQuote> quotes;        // Newest first
+        std::optional<HistoryPageKey> next;    // Key for the following (older) page, empty on the last page
+    };
+
+    // Streams rows of a time-range query one at a time instead of materializing them.
+    // Must not outlive the DatabaseService that opened it.
+    class PriceHistoryCursor {
+    public:
+        // Row source behind a cursor, provided by the PriceStore
+        class Source {
+        public:
+            virtual ~Source() = default;
+            virtual bool next(StockQuote& quote) = 0;
+        };
+
+        // Every call into `source`, including its destruction, is made holding `lock`
+        PriceHistoryCursor(std::unique_ptr<Source> source, std::mutex& lock);
+        PriceHistoryCursor(PriceHistoryCursor&& other) noexcept;
+        PriceHistoryCursor& operator=(PriceHistoryCursor&& other) noexcept;
+        ~PriceHistoryCursor();
+
+        PriceHistoryCursor(const PriceHistoryCursor&) = delete;
+        PriceHistoryCursor& operator=(const PriceHistoryCursor&) = delete;
+
+        // Fills `quote` with the next row. Returns false once the range is exhausted.
+        bool next(StockQuote& quote);
+
+    private:
+        std::unique_ptr<Source> source;
+        std::mutex* lock{ nullptr };
+        bool done{ false };
+
+        void close();
+    };
+
+    // Storage for the price history time series behind DatabaseService.
+    //
+    // DatabaseService makes every call holding its own lock, so implementations don't
+    // need to be thread-safe towards it, unless concurrentReads() says the queries may
+    // run alongside each other and append(). The queries mirror the DatabaseService
+    // methods of the same name.
+    class PriceStore {
+    public:
+        virtual ~PriceStore() = default;
+
+        // One call per savePrice, or per batch in write-behind mode
+        virtual void append(const StockQuote* quotes, size_t count) = 0;
+
+        // Newest first
+        virtual std::vector<StockQuote> latest(const std::string& symbol, int limit) = 0;
+        // [from, to), oldest first. A negative limit means no limit.
+        virtual std::vector<StockQuote> range(const std::string& symbol,
+            std::chrono::system_clock::time_point from,
+            std::chrono::system_clock::time_point to,
+            int limit) = 0;
+        virtual PriceHistoryPage page(const std::string& symbol, int limit,
+            std::optional<HistoryPageKey> after) = 0;
+        virtual std::unique_ptr<PriceHistoryCursor::Source> openCursor(const std::string& symbol,
+            std::chrono::system_clock::time_point from,
+            std::chrono::system_clock::time_point to) = 0;
+
+        // Calls `visit` for every quote in [from, to), in storage order. `visit` may be given
+        // the same StockQuote object each time.
+        virtual void scan(const std::string& symbol,
+            std::chrono::system_clock::time_point from,
+            std::chrono::system_clock::time_point to,
+            const std::function<void(const StockQuote&)>& visit) = 0;
+
+        // Every symbol with stored quotes
+        virtual std::vector<std::string> symbols() = 0;
+
+        // Removes a batch of the symbol's oldest quotes with timestamp before `before` and
+        // returns how many were removed, 0 once there are none left. `retire` is called with
+        // the rows first; if it throws, nothing is removed.
+        // A batch is about `max_rows` rows, but a store that drops rows in larger units may
+        // return fewer or more.
+        virtual size_t trim(const std::string& symbol, std::chrono::system_clock::time_point before,
+            size_t max_rows, const std::function<void(const std::vector<StockQuote>&)>& retire) = 0;
+
+        // Make everything appended so far durable
+        virtual void sync() {}
+
+        // True if latest/range/page may be called from several threads at once, while
+        // another appends, without DatabaseService's lock
+        virtual bool concurrentReads() const { return false; }
+    };
+}
\ No newline at end of file
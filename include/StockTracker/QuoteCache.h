@@ -0,0 +1,86 @@
+#pragma once
+#include "Types.h"
+#include "PackedQuote.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace StockTracker {
+
+    struct QuoteCacheOptions {
+        size_t quotes_per_symbol = 64;              // Ring buffer capacity for each symbol
+        size_t memory_budget_bytes = 16 * 1024 * 1024; // Least recently used symbols are evicted beyond this
+    };
+
+    struct QuoteCacheStats {
+        uint64_t hits{ 0 };
+        uint64_t misses{ 0 };
+        uint64_t evictions{ 0 };
+        size_t symbols{ 0 };
+        size_t memory_bytes{ 0 };   // Approximate, based on ring capacity
+    };
+
+    // Per-symbol ring buffers holding the newest quotes written through DatabaseService.
+    // The cache only answers a request when it holds enough quotes to answer it exactly,
+    // so it assumes it sees every write for a symbol (true when all writes go through savePrice).
+    class QuoteCache {
+    public:
+        // Stored timestamp (see toStoredTimestamp) of the symbol's newest row in the
+        // database, if it has any
+        using NewestStored = std::function<std::optional<int64_t>(const std::string& symbol)>;
+
+        // A new ring only caches quotes at least as new as `newest_stored` reports, so rows
+        // saved before the cache existed can't be skipped by a backfilled quote
+        explicit QuoteCache(const QuoteCacheOptions& options = {}, NewestStored newest_stored = {});
+
+        void insert(const StockQuote& quote);
+
+        // Newest `limit` quotes for `symbol`, newest first, or std::nullopt on a miss.
+        // Timestamps have the price stores' resolution (see toStoredTimestamp).
+        std::optional<std::vector<StockQuote>> getRecent(const std::string& symbol, int limit);
+
+        // Forget `symbol` if its ring holds a quote older than `before` (e.g. one that
+        // retention removed from the database), since the ring could no longer answer exactly
+        void expire(const std::string& symbol, std::chrono::system_clock::time_point before);
+
+        void clear();
+        QuoteCacheStats stats() const;
+
+    private:
+        // Quotes are stored packed so filling a ring never allocates
+        struct Ring {
+            std::vector<PackedQuote> slots;
+            size_t next{ 0 };   // Slot the next quote goes to
+            size_t count{ 0 };
+            // Rows older than this may be missing from the ring (set after an out-of-order write)
+            int64_t floor{ std::numeric_limits<int64_t>::min() };
+            std::list<std::string>::iterator lruPosition;
+        };
+
+        QuoteCacheOptions options;
+        size_t maxSymbols;
+        NewestStored newestStored;
+
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Ring> rings;
+        std::list<std::string> lru; // Most recently used symbol first
+        // Floors of dropped rings, so a recreated ring doesn't cache a quote older than one it
+        // already saw (which may still be in the write-behind queue). One entry per symbol ever dropped.
+        std::unordered_map<std::string, int64_t> droppedFloors;
+
+        uint64_t hits{ 0 };
+        uint64_t misses{ 0 };
+        uint64_t evictions{ 0 };
+
+        size_t ringBytes() const;
+        void touch(Ring& ring);
+        void drop(std::unordered_map<std::string, Ring>::iterator it);
+    };
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include "DatabaseService.h"
+#include "Messages.h"
+#include "Metrics.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace StockTracker {
+
+    // Load generation: replay stored or synthetic quotes through a MessageSocket and
+    // measure what arrives on the other side.
+    //
+    // QuoteReplayer stamps every message with Message::sentAt (steady_clock, ns) and
+    // LatencyRecorder turns that into end-to-end latency at the receiver, so both ends
+    // must run on the same host. Raising ReplayOptions::speed until the receiver stops
+    // keeping up finds the saturation point of a transport.
+
+    // Quotes in timestamp order
+    class QuoteSource {
+    public:
+        virtual ~QuoteSource() = default;
+        // Returns false once the source is exhausted
+        virtual bool next(StockQuote& quote) = 0;
+    };
+
+    // Stored ticks for `symbols` in [from, to), merged across symbols by timestamp.
+    // Reads one `window` of history at a time, so memory stays bounded for long ranges.
+    class HistoryQuoteSource : public QuoteSource {
+    public:
+        HistoryQuoteSource(DatabaseService& db, std::vector<std::string> symbols,
+            std::chrono::system_clock::time_point from,
+            std::chrono::system_clock::time_point to,
+            std::chrono::seconds window = std::chrono::minutes(1));
+
+        bool next(StockQuote& quote) override;
+
+    private:
+        DatabaseService& db;
+        std::vector<std::string> symbols;
+        std::chrono::system_clock::time_point windowStart;
+        std::chrono::system_clock::time_point to;
+        std::chrono::seconds window;
+        std::vector<StockQuote> buffer;
+        size_t position{ 0 };
+    };
+
+    struct SyntheticQuoteOptions {
+        size_t symbols{ 1000 };                         // Named SYM0, SYM1, ...
+        std::chrono::milliseconds interval{ 1000 };     // Every symbol ticks once per interval
+        double volatility{ 0.002 };                     // Standard deviation of each tick's log return
+        uint32_t seed{ 42 };
+        uint64_t max_quotes{ 0 };                       // 0 means unlimited
+    };
+
+    // Random-walk prices. Ticks are spread evenly across each interval, so replaying at
+    // speed 1 offers symbols * 1000 / interval_ms quotes per second. The same seed gives
+    // the same prices; timestamps start at construction time.
+    class SyntheticQuoteSource : public QuoteSource {
+    public:
+        explicit SyntheticQuoteSource(SyntheticQuoteOptions options = {});
+
+        bool next(StockQuote& quote) override;
+
+    private:
+        SyntheticQuoteOptions options;
+        std::mt19937_64 rng;
+        std::normal_distribution<double> noise;
+        std::vector<std::string> names;
+        std::vector<double> prices;
+        std::vector<double> opens;      // First price of each symbol, for change_percent
+        std::chrono::system_clock::time_point start;
+        uint64_t produced{ 0 };
+    };
+
+    struct ReplayOptions {
+        double speed{ 1.0 };            // Multiple of real time. 0 sends as fast as possible.
+        bool stamp_send_time{ true };   // Set Message::sentAt for LatencyRecorder
+    };
+
+    struct ReplayStats {
+        uint64_t sent{ 0 };
+        std::chrono::nanoseconds elapsed{ 0 };
+        std::chrono::nanoseconds max_lag{ 0 };  // Furthest a send fell behind its schedule
+    };
+
+    // Sends quotes from a source as QuoteUpdate messages, keeping the spacing of their
+    // timestamps divided by `speed`. Quote batching and the wire format are whatever the
+    // socket is configured with.
+    class QuoteReplayer {
+    public:
+        explicit QuoteReplayer(MessageSocket& socket, ReplayOptions options = {});
+
+        // Runs until the source is exhausted or stop() is called. Flushes a pending
+        // quote batch before returning.
+        ReplayStats run(QuoteSource& source);
+        // Safe to call from any thread
+        void stop() { stopping = true; }
+
+    private:
+        MessageSocket& socket;
+        ReplayOptions options;
+        std::atomic<bool> stopping{ false };
+    };
+
+    struct LatencyStats {
+        MetricStats latency;                    // Per message, named "replay.latency"
+        uint64_t quotes{ 0 };                   // Quotes received, counting each quote of a batch
+        std::chrono::nanoseconds elapsed{ 0 };  // From the first recorded message to the last
+        double quotes_per_second{ 0 };
+    };
+
+    // Receiver side of a replay. A batch's latency is measured from its oldest quote.
+    // Call record() from the receiving thread; stats() may be called from any thread.
+    class LatencyRecorder {
+    public:
+        // Returns false (nothing recorded) for messages without sentAt
+        bool record(const Message& msg);
+        LatencyStats stats() const;
+        // Cheap to poll, unlike stats()
+        uint64_t received() const { return quotes.load(std::memory_order_relaxed); }
+        void reset();
+
+    private:
+        LatencyHistogram histogram;
+        std::atomic<uint64_t> quotes{ 0 };
+        std::atomic<int64_t> firstAt{ 0 };
+        std::atomic<int64_t> lastAt{ 0 };
+    };
+}
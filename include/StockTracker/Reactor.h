@@ -0,0 +1,95 @@
+#pragma once
+#include "Context.h"
+#include "Messages.h"
+#include <zmq.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace StockTracker {
+
+    // Event loop that waits on many MessageSockets at once with a single zmq::poll.
+    //
+    // Handlers, timers and posted callbacks all run on the thread that calls run().
+    // Sockets and timers may be added or removed before run() starts or from that thread
+    // (including from inside a handler). post() and stop() are safe from any thread.
+    class Reactor {
+    public:
+        using Handler = std::function<void(MessageSocket& socket)>;
+        using Callback = std::function<void()>;
+        using TimerId = uint64_t;
+
+        explicit Reactor(std::shared_ptr<zmq::context_t> context = sharedContext());
+
+        Reactor(const Reactor&) = delete;
+        Reactor& operator=(const Reactor&) = delete;
+
+        // Call `handler` whenever `socket` has a message waiting. The handler should read with
+        // receive(msg, true); it is called again while messages remain, up to MAX_BURST times
+        // per iteration, so one busy socket can't starve the others.
+        void addSocket(MessageSocket& socket, Handler handler);
+        void removeSocket(MessageSocket& socket);
+
+        // Run `callback` every `interval`, starting one interval from now
+        TimerId addTimer(std::chrono::milliseconds interval, Callback callback);
+        // Run `callback` once, after `delay`
+        TimerId callLater(std::chrono::milliseconds delay, Callback callback);
+        void cancelTimer(TimerId id);
+
+        // Run `callback` on the reactor thread
+        void post(Callback callback);
+
+        // Dispatch events until stop() is called
+        void run();
+        // Wait up to `timeout` (negative: no limit) for the next event and dispatch what is ready.
+        // Returns false once stop() has been called.
+        bool runOnce(std::chrono::milliseconds timeout);
+        // Make run() return after the current iteration. Stopping is final.
+        void stop();
+
+        static constexpr int MAX_BURST = 64;
+
+    private:
+        struct Registration {
+            MessageSocket* socket;
+            Handler handler;
+            bool removed{ false };
+        };
+
+        struct Timer {
+            std::chrono::steady_clock::time_point due;
+            std::chrono::milliseconds interval;
+            bool repeat;
+            Callback callback;
+        };
+
+        std::shared_ptr<zmq::context_t> context;
+
+        // A deque, so registering a socket from inside a handler doesn't move the running handler
+        std::deque<Registration> sockets;
+        bool socketsChanged{ true };
+        std::vector<zmq::pollitem_t> pollItems;    // [0] is the wake socket, then one per registration
+
+        std::map<TimerId, Timer> timers;
+        TimerId nextTimerId{ 1 };
+
+        zmq::socket_t wakeReceiver;
+        std::mutex postMutex;       // Guards posted, wakePending and wakeSender
+        zmq::socket_t wakeSender;
+        std::vector<Callback> posted;
+        bool wakePending{ false };
+        std::atomic<bool> stopped{ false };
+
+        void wake();
+        void rebuildPollItems();
+        void dispatchSocket(size_t index);
+        void runPosted();
+        void runTimers();
+        std::chrono::milliseconds pollTimeout(std::chrono::milliseconds limit) const;
+    };
+}
\ No newline at end of file
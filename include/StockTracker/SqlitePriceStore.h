@@ -0,0 +1,79 @@
+#pragma once
+#include "PriceStore.h"
+#include <sqlite3.h>
+
+namespace StockTracker {
+
+    // Returns a cached statement to a clean state when the call using it is done
+    class SqliteStatementReset {
+    public:
+        explicit SqliteStatementReset(sqlite3_stmt* stmt) : stmt(stmt) {}
+        ~SqliteStatementReset() {
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+        }
+
+        SqliteStatementReset(const SqliteStatementReset&) = delete;
+        SqliteStatementReset& operator=(const SqliteStatementReset&) = delete;
+
+    private:
+        sqlite3_stmt* stmt;
+    };
+
+    // Distinct values of the leading `symbol` column of an index on `table`, found with
+    // one index seek each rather than a scan over every row
+    std::vector<std::string> distinctSymbols(sqlite3* db, const char* table);
+
+    // The price_history table. This is DatabaseService's default store; it shares the
+    // service's connection, so ticks and bars commit in the same write-behind transaction.
+    // Timestamps are stored timestamps (see toStoredTimestamp); tables written when the
+    // column held system_clock ticks are converted once, on the first writable open.
+    class SqlitePriceStore : public PriceStore {
+    public:
+        // Creates price_history if needed. `db` must outlive the store.
+        // A read-only store expects the table to exist and throws from append().
+        explicit SqlitePriceStore(sqlite3* db, bool read_only = false);
+        ~SqlitePriceStore() override;
+
+        SqlitePriceStore(const SqlitePriceStore&) = delete;
+        SqlitePriceStore& operator=(const SqlitePriceStore&) = delete;
+
+        void append(const StockQuote* quotes, size_t count) override;
+        std::vector<StockQuote> latest(const std::string& symbol, int limit) override;
+        std::vector<StockQuote> range(const std::string& symbol,
+            std::chrono::system_clock::time_point from,
+            std::chrono::system_clock::time_point to,
+            int limit) override;
+        PriceHistoryPage page(const std::string& symbol, int limit,
+            std::optional<HistoryPageKey> after) override;
+        std::unique_ptr<PriceHistoryCursor::Source> openCursor(const std::string& symbol,
+            std::chrono::system_clock::time_point from,
+            std::chrono::system_clock::time_point to) override;
+        void scan(const std::string& symbol,
+            std::chrono::system_clock::time_point from,
+            std::chrono::system_clock::time_point to,
+            const std::function<void(const StockQuote&)>& visit) override;
+        std::vector<std::string> symbols() override;
+        // Deletes exactly the rows passed to `retire`, oldest first. Run it inside a
+        // transaction so a failure part-way leaves the table as it was.
+        size_t trim(const std::string& symbol, std::chrono::system_clock::time_point before,
+            size_t max_rows, const std::function<void(const std::vector<StockQuote>&)>& retire) override;
+
+    private:
+        sqlite3* db;
+        bool readOnly;
+
+        // Prepared once in the constructor, then reset and rebound on every call
+        sqlite3_stmt* insertPriceStmt{ nullptr };
+        sqlite3_stmt* priceHistoryStmt{ nullptr };
+        sqlite3_stmt* priceRangeStmt{ nullptr };
+        sqlite3_stmt* pricePageStmt{ nullptr };
+        sqlite3_stmt* priceScanStmt{ nullptr };
+        sqlite3_stmt* expiredStmt{ nullptr };
+        sqlite3_stmt* deleteRowStmt{ nullptr };
+
+        void createTable();
+        void migrateTimestamps();
+        void finalizeStatements();
+    };
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+#include "Messages.h"
+#include "Metrics.h"
+#include <chrono>
+
+namespace StockTracker {
+
+    // Periodically sends a Stats message carrying Metrics::snapshot() on a socket.
+    // Call poll() from the loop that owns the socket; it only sends once `interval`
+    // has passed since the previous snapshot.
+    class StatsPublisher {
+    public:
+        StatsPublisher(MessageSocket& socket, std::chrono::milliseconds interval);
+
+        // Returns true if a snapshot was sent
+        bool poll();
+        void publishNow();
+
+    private:
+        MessageSocket& socket;
+        std::chrono::milliseconds interval;
+        std::chrono::steady_clock::time_point lastPublished;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+#include "PriceStore.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace StockTracker {
+
+    struct TickLogOptions {
+        std::string directory;              // Root of the log, one subdirectory per symbol. Created if missing.
+        size_t ticks_per_segment = 65536;   // Rows per segment file, each sized for its full capacity when created
+    };
+
+    // A run of consecutive rows of one segment, pointing straight into the mapped file
+    struct TickColumns {
+        const int64_t* timestamps;          // Stored timestamps (see toStoredTimestamp)
+        const double* prices;
+        const double* change_percents;      // NaN where the quote had none
+        size_t count;
+        uint64_t first_sequence;            // Sequence number of row 0; sequences are per symbol, from 1
+    };
+
+    // Append-only, memory-mapped column store for price history.
+    //
+    // Each symbol's ticks go to fixed-size segment files holding a header and three columns
+    // (timestamps, prices, change percents). A segment is mapped once at full size and never
+    // moved, so appends are plain stores into the page cache and range scans read the columns
+    // in place. While a symbol's ticks arrive in timestamp order, range queries binary-search
+    // the columns; once one arrives out of order they sort the symbol's rows per query instead.
+    //
+    // Queries return the same rows as SqlitePriceStore, so the two are interchangeable behind
+    // DatabaseService. Only ticks already appended are durable after sync(); the rest is up
+    // to the OS flushing the mapping. Files use the host's byte order. Segments written by
+    // the first version of the format, which held system_clock ticks, are converted to
+    // stored timestamps when opened. Thread-safe.
+    class TickLogStore : public PriceStore {
+    public:
+        // Opens the segments already under options.directory
+        explicit TickLogStore(const TickLogOptions& options);
+        ~TickLogStore() override;
+
+        TickLogStore(const TickLogStore&) = delete;
+        TickLogStore& operator=(const TickLogStore&) = delete;
+
+        void append(const StockQuote* quotes, size_t count) override;
+        std::vector<StockQuote> latest(const std::string& symbol, int limit) override;
+        std::vector<StockQuote> range(const std::string& symbol,
+            std::chrono::system_clock::time_point from,
+            std::chrono::system_clock::time_point to,
+            int limit) override;
+        PriceHistoryPage page(const std::string& symbol, int limit,
+            std::optional<HistoryPageKey> after) override;
+        std::unique_ptr<PriceHistoryCursor::Source> openCursor(const std::string& symbol,
+            std::chrono::system_clock::time_point from,
+            std::chrono::system_clock::time_point to) override;
+        void scan(const std::string& symbol,
+            std::chrono::system_clock::time_point from,
+            std::chrono::system_clock::time_point to,
+            const std::function<void(const StockQuote&)>& visit) override;
+        std::vector<std::string> symbols() override;
+        // Drops whole segments from the front of the symbol's log, as long as every row in them
+        // is older than `before`, until at least `max_rows` rows are gone. The segment being
+        // appended to is always kept, so a log never loses its place in the sequence.
+        // `retire` must not call back into the store.
+        size_t trim(const std::string& symbol, std::chrono::system_clock::time_point before,
+            size_t max_rows, const std::function<void(const std::vector<StockQuote>&)>& retire) override;
+        void sync() override;
+        bool concurrentReads() const override { return true; }
+
+        // Zero-copy scan: calls `visit` with every run of rows in [from, to), in storage order
+        // (which is timestamp order unless ticks arrived out of order). The pointers stay valid
+        // until trim() drops their segment. `visit` must not call back into the store.
+        void scanColumns(const std::string& symbol,
+            std::chrono::system_clock::time_point from,
+            std::chrono::system_clock::time_point to,
+            const std::function<void(const TickColumns&)>& visit);
+
+    private:
+        class Segment;
+        struct SymbolLog;
+        class Cursor;
+
+        TickLogOptions options;
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, std::unique_ptr<SymbolLog>> logs;
+
+        const SymbolLog* find(const std::string& symbol) const;
+        SymbolLog& open(const std::string& symbol);
+        void load();
+    };
+}
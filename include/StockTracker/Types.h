@@ -1,27 +1,76 @@
 #pragma once
 #include <string>
 #include <chrono>
+#include <cstdint>
 #include <optional>
+#include <vector>
 #include <nlohmann/json.hpp>
 
 namespace StockTracker {
     using json = nlohmann::json;
 
+    // Streaming analytics attached to a quote by IndicatorEngine (see Indicators.h).
+    // Each value is empty until the engine has seen enough quotes for it.
+    struct QuoteIndicators {
+        std::optional<double> sma;          // Simple moving average of the price
+        std::optional<double> ema;          // Exponential moving average of the price
+        std::optional<double> vwap;         // Since the start of the UTC day, each tick weighted as one unit of volume
+        std::optional<double> volatility;   // Standard deviation of per-tick log returns (not annualized)
+    };
+
     struct StockQuote {
         std::string symbol; // Stock symbol (e.g. "AAPL")
         double price; // Current price of stock.
         std::chrono::system_clock::time_point timestamp; // When the price was recorded
         std::optional<double> change_percent; // Percent change
         std::string currency{ "USD" }; // USD default
+        std::optional<QuoteIndicators> indicators; // Filled in by IndicatorEngine, not stored in the database
 
         // Static factory method to easily create a StockQuote.
         static StockQuote create(std::string sym, double price_val);
     };
 
+    // JSON serialization for QuoteIndicators (only present values are written)
+    void to_json(json& j, const QuoteIndicators& indicators);
+    void from_json(const json& j, QuoteIndicators& indicators);
+
     // JSON serialization for StockQuote
     void to_json(json& j, const StockQuote& quote);
     void from_json(const json& j, StockQuote& quote);
 
+    // One OHLCV candle. StockQuote carries no traded volume, so `volume` counts the ticks in the bar.
+    struct OhlcvBar {
+        std::chrono::system_clock::time_point open_time; // Start of the interval, aligned to the Unix epoch (UTC)
+        std::chrono::seconds interval;
+        double open;
+        double high;
+        double low;
+        double close;
+        uint64_t volume;
+    };
+
+    // Bars of `interval` whose open_time falls in [from, to), oldest first
+    struct BarQuery {
+        std::chrono::seconds interval{ 60 };
+        std::chrono::system_clock::time_point from;
+        std::chrono::system_clock::time_point to;
+        int limit{ -1 }; // Negative means no limit
+    };
+
+    // JSON serialization for bars. Times are milliseconds since the epoch, intervals seconds.
+    void to_json(json& j, const OhlcvBar& bar);
+    void from_json(const json& j, OhlcvBar& bar);
+    void to_json(json& j, const BarQuery& query);
+    void from_json(const json& j, BarQuery& query);
+
+    // Subscription changes since a version the client already has (see DatabaseService::getSubscriptionChanges)
+    struct SubscriptionDelta {
+        uint64_t version{ 0 };              // Current version; the client sends it back next time
+        bool full{ false };                 // `added` is the whole list and replaces what the client has
+        std::vector<std::string> added;
+        std::vector<std::string> removed;
+    };
+
     // Message types for service communication
     enum class MessageType {
         Subscribe,              // Client wants to start getting updates for a stock (subscribe AAPL)
@@ -33,9 +82,18 @@ namespace StockTracker {
         PriceHistoryRequest,    // Request price history for a stock.
         PriceHistoryResponse,   // Response to price history request, sends history back to CLI
         SetCurrency,            // Setting the currency.
-        Error                   // Something went wrong
+        Error,                  // Something went wrong
+        QuoteBatch,             // Several quote updates in one message (see Message::quotes)
+        Stats,                  // Metrics snapshot (see Message::stats)
+        BarHistoryRequest,      // Request OHLCV bars for a stock (see Message::barQuery)
+        BarHistoryResponse,     // OHLCV bars for a stock (see Message::bars)
+        SubscriptionsDelta      // Subscriptions added and removed since a version (see Message::subscriptionsVersion)
     };
 
+    // Number of MessageType values. New types go at the end of the enum (the binary codec
+    // sends the numeric value), so this must name the last one.
+    constexpr size_t MESSAGE_TYPE_COUNT = static_cast<size_t>(MessageType::SubscriptionsDelta) + 1;
+
     // Macro for JSON serialization for our MessageType enum.
     // Maps enum values to strings for JSON.
     // Ex: MessageType::Subscribe will become "subscribe" in JSON.
@@ -49,7 +107,31 @@ namespace StockTracker {
         {MessageType::SubscriptionsList, "subscriptions_list"},
         {MessageType::RequestSubscriptions, "request_subscriptions"},
         {MessageType::SetCurrency, "set_currency"},
-        {MessageType::Error, "error"}
+        {MessageType::Error, "error"},
+        {MessageType::QuoteBatch, "quote_batch"},
+        {MessageType::Stats, "stats"},
+        {MessageType::BarHistoryRequest, "bar_history_request"},
+        {MessageType::BarHistoryResponse, "bar_history_response"},
+        {MessageType::SubscriptionsDelta, "subscriptions_delta"}
+    })
+
+    // Wire encoding used by MessageSocket when sending.
+    // Receivers detect the format per frame, so JSON and binary peers can be mixed.
+    enum class WireFormat {
+        Json,   // Legacy text frames (first byte is always '{')
+        Binary  // Compact frames starting with a format/version byte (see BinaryCodec.h)
+    };
+
+    // How Message::priceHistory travels. A PriceHistoryRequest states what the client can
+    // read and the server answers in kind (see Message::makePriceHistory).
+    enum class HistoryEncoding {
+        Rows,       // One full quote object per row
+        Columnar    // One compressed block per history (see HistoryCodec.h)
+    };
+
+    NLOHMANN_JSON_SERIALIZE_ENUM(HistoryEncoding, {
+        {HistoryEncoding::Rows, "rows"},
+        {HistoryEncoding::Columnar, "columnar"}
     })
 
 }
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include "StockTracker/AsyncCurrencyService.h"
+#include "StockTracker/Metrics.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace StockTracker {
+
+    namespace {
+        // Longest the I/O thread sleeps when nothing is pending
+        constexpr std::chrono::milliseconds IDLE_POLL_INTERVAL{ 1000 };
+    }
+
+    AsyncCurrencyService::AsyncCurrencyService(const std::string& endpoint,
+        std::chrono::milliseconds default_timeout, std::shared_ptr<zmq::context_t> context)
+        : endpoint(endpoint)
+        , defaultTimeout(default_timeout)
+        , context(std::move(context))
+        , wakeReceiver(*this->context, zmq::socket_type::pair)
+        , wakeSender(*this->context, zmq::socket_type::pair)
+        , lastReplyAt(std::chrono::steady_clock::now())
+    {
+        // Callers poke the I/O thread through an inproc pair when they queue a request.
+        // The name must stay unique within a (possibly shared) context, even across instances.
+        static std::atomic<uint64_t> instanceCount{ 0 };
+        std::string wakeEndpoint = "inproc://currency-wake-" + std::to_string(++instanceCount);
+        wakeReceiver.set(zmq::sockopt::linger, 0);
+        wakeSender.set(zmq::sockopt::linger, 0);
+        wakeReceiver.bind(wakeEndpoint);
+        wakeSender.connect(wakeEndpoint);
+
+        connectDealer();
+        ioThread = std::thread(&AsyncCurrencyService::run, this);
+    }
+
+    AsyncCurrencyService::~AsyncCurrencyService() {
+        {
+            std::lock_guard<std::mutex> lock(outboxMutex);
+            stopping = true;
+            zmq::message_t wake;
+            wakeSender.send(wake, zmq::send_flags::dontwait);
+        }
+        ioThread.join();
+    }
+
+    std::future<double> AsyncCurrencyService::convertAsync(double amount, const std::string& to_currency,
+        std::optional<std::chrono::milliseconds> timeout) {
+        auto promise = std::make_shared<std::promise<double>>();
+        auto future = promise->get_future();
+
+        convertAsync(amount, to_currency, [promise](double converted, std::exception_ptr error) {
+            if (error) {
+                promise->set_exception(error);
+            }
+            else {
+                promise->set_value(converted);
+            }
+        }, timeout);
+
+        return future;
+    }
+
+    void AsyncCurrencyService::convertAsync(double amount, const std::string& to_currency, Callback callback,
+        std::optional<std::chrono::milliseconds> timeout) {
+        if (!CurrencyService::isValidCurrencyCode(to_currency)) {
+            throw std::runtime_error("Invalid currency code: " + to_currency);
+        }
+
+        Request request;
+        request.payload = CurrencyService::makeConversionRequest(amount, to_currency);
+        request.submitted_at = std::chrono::steady_clock::now();
+        request.deadline = request.submitted_at + timeout.value_or(defaultTimeout);
+        request.callback = std::move(callback);
+
+        std::lock_guard<std::mutex> lock(outboxMutex);
+        if (stopping) {
+            throw std::logic_error("AsyncCurrencyService is shutting down");
+        }
+        request.id = nextId++;
+        outbox.push_back(std::move(request));
+        ++inFlightCount;
+
+        zmq::message_t wake;
+        wakeSender.send(wake, zmq::send_flags::dontwait);
+    }
+
+    void AsyncCurrencyService::connectDealer() {
+        if (dealer) {
+            dealer->close();
+        }
+        dealer = std::make_unique<zmq::socket_t>(*context, zmq::socket_type::dealer);
+        dealer->set(zmq::sockopt::linger, 0);
+        dealer->connect(endpoint);
+    }
+
+    void AsyncCurrencyService::run() {
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(outboxMutex);
+                if (stopping) {
+                    break;
+                }
+            }
+
+            // Sleep until a reply, a new request, or the nearest deadline
+            auto now = std::chrono::steady_clock::now();
+            auto timeout = IDLE_POLL_INTERVAL;
+            for (const auto& [id, request] : pending) {
+                auto remaining = std::chrono::ceil<std::chrono::milliseconds>(request.deadline - now);
+                timeout = std::min(timeout, std::max(remaining, std::chrono::milliseconds(0)));
+            }
+
+            zmq::pollitem_t items[] = {
+                { dealer->handle(), 0, ZMQ_POLLIN, 0 },
+                { wakeReceiver.handle(), 0, ZMQ_POLLIN, 0 }
+            };
+            zmq::poll(items, 2, timeout);
+
+            if (items[1].revents & ZMQ_POLLIN) {
+                zmq::message_t wake;
+                while (wakeReceiver.recv(wake, zmq::recv_flags::dontwait)) {}
+            }
+
+            sendQueued();
+            if (items[0].revents & ZMQ_POLLIN) {
+                receiveReplies();
+            }
+            expireRequests();
+        }
+
+        // Fail whatever is left so no future is left hanging. Callbacks run without the
+        // lock, since one may call convertAsync (which then throws, as we are stopping).
+        auto shutdown = std::make_exception_ptr(std::runtime_error("Currency service client shut down"));
+        std::vector<Request> queued;
+        {
+            std::lock_guard<std::mutex> lock(outboxMutex);
+            queued.swap(outbox);
+        }
+        for (auto& request : queued) {
+            complete(request, 0.0, shutdown);
+        }
+        for (auto& [id, request] : pending) {
+            complete(request, 0.0, shutdown);
+        }
+        pending.clear();
+    }
+
+    void AsyncCurrencyService::sendQueued() {
+        std::vector<Request> queued;
+        {
+            std::lock_guard<std::mutex> lock(outboxMutex);
+            queued.swap(outbox);
+        }
+
+        for (auto& request : queued) {
+            // [id][empty delimiter][payload]: REP strips and echoes everything up to the delimiter
+            uint64_t id = request.id;
+            zmq::message_t delimiter;
+            bool sent = dealer->send(zmq::buffer(&id, sizeof(id)), zmq::send_flags::sndmore | zmq::send_flags::dontwait)
+                && dealer->send(delimiter, zmq::send_flags::sndmore)
+                && dealer->send(zmq::buffer(request.payload), zmq::send_flags::none);
+
+            if (!sent) {
+                complete(request, 0.0, std::make_exception_ptr(
+                    std::runtime_error("Currency service send queue is full")));
+                continue;
+            }
+
+            request.sent_at = std::chrono::steady_clock::now();
+            pending.emplace(id, std::move(request));
+        }
+    }
+
+    void AsyncCurrencyService::receiveReplies() {
+        std::vector<zmq::message_t> frames;
+        while (true) {
+            frames.clear();
+            do {
+                zmq::message_t frame;
+                if (!dealer->recv(frame, zmq::recv_flags::dontwait)) {
+                    return;
+                }
+                frames.push_back(std::move(frame));
+            } while (frames.back().more());
+
+            lastReplyAt = std::chrono::steady_clock::now();
+
+            if (frames.size() != 3 || frames[0].size() != sizeof(uint64_t)) {
+                spdlog::warn("Ignoring malformed currency service reply ({} frames)", frames.size());
+                continue;
+            }
+
+            uint64_t id;
+            std::memcpy(&id, frames[0].data(), sizeof(id));
+            auto it = pending.find(id);
+            if (it == pending.end()) {
+                continue; // Reply to a request that already timed out
+            }
+
+            Request request = std::move(it->second);
+            pending.erase(it);
+            try {
+                complete(request, CurrencyService::parseConversionReply(frames[2].data(), frames[2].size()), nullptr);
+            }
+            catch (const std::exception&) {
+                complete(request, 0.0, std::current_exception());
+            }
+        }
+    }
+
+    void AsyncCurrencyService::expireRequests() {
+        auto now = std::chrono::steady_clock::now();
+        bool stalled = false;
+
+        for (auto it = pending.begin(); it != pending.end();) {
+            if (it->second.deadline > now) {
+                ++it;
+                continue;
+            }
+            // Nothing came back during this request's whole lifetime
+            stalled |= it->second.sent_at >= lastReplyAt;
+            complete(it->second, 0.0, std::make_exception_ptr(
+                std::runtime_error("No response from currency service")));
+            it = pending.erase(it);
+        }
+
+        if (stalled) {
+            // The connection may be wedged; start over with a fresh socket. Replies for
+            // requests sent on the old socket can't arrive anymore, so fail them now.
+            spdlog::warn("Currency service unresponsive, reconnecting to {}", endpoint);
+            auto reset = std::make_exception_ptr(std::runtime_error("Currency service connection reset"));
+            for (auto& [id, request] : pending) {
+                complete(request, 0.0, reset);
+            }
+            pending.clear();
+            connectDealer();
+            lastReplyAt = now;
+            ++reconnectCount;
+        }
+    }
+
+    void AsyncCurrencyService::complete(Request& request, double converted, std::exception_ptr error) {
+        --inFlightCount;
+        Metrics::record(Metric::CurrencyConvertAsync,
+            std::chrono::steady_clock::now() - request.submitted_at, error == nullptr);
+        try {
+            request.callback(converted, error);
+        }
+        catch (const std::exception& e) {
+            spdlog::error("Currency conversion callback threw: {}", e.what());
+        }
+    }
+}
@@ -0,0 +1,153 @@
+#include "StockTracker/BarAggregator.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace StockTracker {
+
+    namespace {
+        BarDelta startBar(const StockQuote& quote, std::chrono::seconds interval) {
+            return BarDelta{
+                quote.symbol,
+                OhlcvBar{ BarAggregator::bucketStart(quote.timestamp, interval), interval,
+                          quote.price, quote.price, quote.price, quote.price, 1 },
+                quote.timestamp,
+                quote.timestamp
+            };
+        }
+    }
+
+    BarAggregator::BarAggregator(const BarAggregatorOptions& options)
+        : options(options)
+    {
+        if (options.intervals.empty()) {
+            throw std::invalid_argument("Bar aggregator needs at least one interval");
+        }
+        for (auto interval : options.intervals) {
+            if (interval.count() <= 0) {
+                throw std::invalid_argument("Bar intervals must be positive");
+            }
+        }
+    }
+
+    std::chrono::system_clock::time_point BarAggregator::bucketStart(std::chrono::system_clock::time_point time,
+        std::chrono::seconds interval) {
+        auto since = time.time_since_epoch();
+        auto offset = since % interval;
+        if (offset.count() < 0) {
+            offset += interval;   // Round down for times before the epoch too
+        }
+        return time - offset;
+    }
+
+    void BarAggregator::merge(BarDelta& into, const BarDelta& other) {
+        if (other.first_tick < into.first_tick) {
+            into.first_tick = other.first_tick;
+            into.bar.open = other.bar.open;
+        }
+        if (other.last_tick >= into.last_tick) {
+            into.last_tick = other.last_tick;
+            into.bar.close = other.bar.close;
+        }
+        into.bar.high = std::max(into.bar.high, other.bar.high);
+        into.bar.low = std::min(into.bar.low, other.bar.low);
+        into.bar.volume += other.bar.volume;
+    }
+
+    bool BarAggregator::hasInterval(std::chrono::seconds interval) const {
+        return std::find(options.intervals.begin(), options.intervals.end(), interval) != options.intervals.end();
+    }
+
+    void BarAggregator::add(const StockQuote& quote) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto& slots = open[quote.symbol];
+        slots.resize(options.intervals.size());
+
+        for (size_t i = 0; i < slots.size(); ++i) {
+            auto interval = options.intervals[i];
+            auto& current = slots[i];
+            auto bucket = bucketStart(quote.timestamp, interval);
+
+            if (!current) {
+                current = startBar(quote, interval);
+            }
+            else if (bucket == current->bar.open_time) {
+                BarDelta& delta = *current;
+                if (quote.timestamp < delta.first_tick) {
+                    delta.first_tick = quote.timestamp;
+                    delta.bar.open = quote.price;
+                }
+                if (quote.timestamp >= delta.last_tick) {
+                    delta.last_tick = quote.timestamp;
+                    delta.bar.close = quote.price;
+                }
+                delta.bar.high = std::max(delta.bar.high, quote.price);
+                delta.bar.low = std::min(delta.bar.low, quote.price);
+                ++delta.bar.volume;
+            }
+            else if (bucket > current->bar.open_time) {
+                closed.push_back(std::move(*current));
+                current = startBar(quote, interval);
+            }
+            else {
+                // Late tick for a bar that was already closed
+                closed.push_back(startBar(quote, interval));
+            }
+        }
+    }
+
+    std::vector<BarDelta> BarAggregator::takeClosed() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<BarDelta> taken;
+        taken.swap(closed);
+        return taken;
+    }
+
+    std::vector<BarDelta> BarAggregator::takeAll() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<BarDelta> taken;
+        taken.swap(closed);
+        for (auto& [symbol, slots] : open) {
+            for (auto& current : slots) {
+                if (current) {
+                    taken.push_back(std::move(*current));
+                    current.reset();
+                }
+            }
+        }
+        return taken;
+    }
+
+    std::vector<BarDelta> BarAggregator::pending(const std::string& symbol, std::chrono::seconds interval,
+        std::chrono::system_clock::time_point from, std::chrono::system_clock::time_point to) const {
+        auto matches = [&](const BarDelta& delta) {
+            return delta.symbol == symbol && delta.bar.interval == interval &&
+                delta.bar.open_time >= from && delta.bar.open_time < to;
+        };
+
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<BarDelta> result;
+        for (const auto& delta : closed) {
+            if (matches(delta)) {
+                result.push_back(delta);
+            }
+        }
+
+        auto it = open.find(symbol);
+        if (it != open.end()) {
+            for (const auto& current : it->second) {
+                if (current && matches(*current)) {
+                    result.push_back(*current);
+                }
+            }
+        }
+        return result;
+    }
+
+    void BarAggregator::discard(const std::string& symbol) {
+        std::lock_guard<std::mutex> lock(mutex);
+        open.erase(symbol);
+        closed.erase(std::remove_if(closed.begin(), closed.end(),
+            [&](const BarDelta& delta) { return delta.symbol == symbol; }), closed.end());
+    }
+}
\ No newline at end of file
@@ -0,0 +1,545 @@
+#include "StockTracker/BinaryCodec.h"
+#include "StockTracker/HistoryCodec.h"
+#include <array>
+#include <cstring>
+#include <utility>
+#include <stdexcept>
+
+namespace StockTracker {
+
+    namespace {
+
+        // Bits of the "fields" varint
+        constexpr uint64_t HAS_QUOTE = 1 << 0;
+        constexpr uint64_t HAS_ERROR = 1 << 1;
+        constexpr uint64_t HAS_PRICE_HISTORY = 1 << 2;
+        constexpr uint64_t HAS_SUBSCRIPTIONS = 1 << 3;
+        constexpr uint64_t HAS_QUOTES = 1 << 4;
+        constexpr uint64_t HAS_STATS = 1 << 5;
+        constexpr uint64_t HAS_BAR_QUERY = 1 << 6;
+        constexpr uint64_t HAS_BARS = 1 << 7;
+        constexpr uint64_t HAS_HISTORY_ENCODING = 1 << 8;
+        constexpr uint64_t HAS_PACKED_HISTORY = 1 << 9;     // priceHistory as a HistoryCodec block
+        constexpr uint64_t HAS_SENT_AT = 1 << 10;
+        constexpr uint64_t HAS_SINCE = 1 << 11;
+        constexpr uint64_t HAS_SUBSCRIPTIONS_VERSION = 1 << 12;
+        constexpr uint64_t HAS_REMOVED_SUBSCRIPTIONS = 1 << 13;
+        constexpr uint64_t KNOWN_FIELDS = (HAS_REMOVED_SUBSCRIPTIONS << 1) - 1;
+
+        // Bits of the per-quote flags byte
+        constexpr uint8_t HAS_CHANGE_PERCENT = 1 << 0;
+        constexpr uint8_t HAS_INDICATORS = 1 << 1;
+        constexpr uint8_t KNOWN_QUOTE_FLAGS = HAS_CHANGE_PERCENT | HAS_INDICATORS;
+
+        // Bits of the indicators byte that follows HAS_INDICATORS
+        constexpr uint8_t HAS_SMA = 1 << 0;
+        constexpr uint8_t HAS_EMA = 1 << 1;
+        constexpr uint8_t HAS_VWAP = 1 << 2;
+        constexpr uint8_t HAS_VOLATILITY = 1 << 3;
+        constexpr uint8_t KNOWN_INDICATORS = HAS_SMA | HAS_EMA | HAS_VWAP | HAS_VOLATILITY;
+
+        // New MessageTypes must be appended to the enum, since the codec sends the numeric value
+        constexpr uint8_t MAX_MESSAGE_TYPE = static_cast<uint8_t>(MESSAGE_TYPE_COUNT - 1);
+
+        void putByte(std::string& out, uint8_t value) {
+            out.push_back(static_cast<char>(value));
+        }
+
+        void putVarint(std::string& out, uint64_t value) {
+            while (value >= 0x80) {
+                putByte(out, static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            putByte(out, static_cast<uint8_t>(value));
+        }
+
+        void putInt64(std::string& out, int64_t value) {
+            auto bits = static_cast<uint64_t>(value);
+            for (int i = 0; i < 8; ++i) {
+                putByte(out, static_cast<uint8_t>(bits >> (i * 8)));
+            }
+        }
+
+        void putDouble(std::string& out, double value) {
+            int64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            putInt64(out, bits);
+        }
+
+        void putString(std::string& out, const std::string& value) {
+            putVarint(out, value.size());
+            out.append(value);
+        }
+
+        // Bounds-checked cursor over a received frame
+        class Reader {
+        public:
+            Reader(const void* data, size_t size)
+                : pos(static_cast<const uint8_t*>(data))
+                , end(pos + size)
+            {}
+
+            uint8_t byte() {
+                require(1);
+                return *pos++;
+            }
+
+            uint64_t varint() {
+                uint64_t value = 0;
+                for (int shift = 0; shift < 64; shift += 7) {
+                    uint8_t b = byte();
+                    value |= static_cast<uint64_t>(b & 0x7F) << shift;
+                    if ((b & 0x80) == 0) {
+                        return value;
+                    }
+                }
+                throw std::runtime_error("Malformed binary message: varint too long");
+            }
+
+            int64_t int64() {
+                require(8);
+                uint64_t bits = 0;
+                for (int i = 0; i < 8; ++i) {
+                    bits |= static_cast<uint64_t>(pos[i]) << (i * 8);
+                }
+                pos += 8;
+                return static_cast<int64_t>(bits);
+            }
+
+            double float64() {
+                int64_t bits = int64();
+                double value;
+                std::memcpy(&value, &bits, sizeof(value));
+                return value;
+            }
+
+            // Pointer to the next `n` bytes, which the caller consumes in place
+            const uint8_t* bytes(size_t n) {
+                require(n);
+                const uint8_t* start = pos;
+                pos += n;
+                return start;
+            }
+
+            void string(std::string& out) {
+                auto len = varint();
+                require(len);
+                out.assign(reinterpret_cast<const char*>(pos), static_cast<size_t>(len));
+                pos += len;
+            }
+
+            // Upper bound for element counts, so a corrupt count can't trigger a huge reserve
+            size_t count(size_t min_element_size) {
+                auto n = varint();
+                if (n > remaining() / min_element_size) {
+                    throw std::runtime_error("Malformed binary message: bad element count");
+                }
+                return static_cast<size_t>(n);
+            }
+
+            size_t remaining() const { return static_cast<size_t>(end - pos); }
+
+        private:
+            const uint8_t* pos;
+            const uint8_t* end;
+
+            void require(uint64_t n) const {
+                if (n > remaining()) {
+                    throw std::runtime_error("Malformed binary message: truncated frame");
+                }
+            }
+        };
+
+        // Smallest possible encoded quote: two empty strings, flags, price and timestamp
+        constexpr size_t MIN_QUOTE_SIZE = 1 + 8 + 8 + 1 + 1;
+
+        // Indicator values that are present, in bit order
+        template <typename Indicators>
+        auto indicatorFields(Indicators& indicators) {
+            return std::array<std::pair<uint8_t, decltype(&indicators.sma)>, 4>{ {
+                { HAS_SMA, &indicators.sma },
+                { HAS_EMA, &indicators.ema },
+                { HAS_VWAP, &indicators.vwap },
+                { HAS_VOLATILITY, &indicators.volatility } } };
+        }
+
+        int64_t toEpochMillis(std::chrono::system_clock::time_point time) {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+        }
+
+        std::chrono::system_clock::time_point fromEpochMillis(int64_t millis) {
+            return std::chrono::system_clock::time_point(std::chrono::milliseconds(millis));
+        }
+
+        void writeIndicators(std::string& out, const QuoteIndicators& indicators) {
+            uint8_t present = 0;
+            for (auto [bit, value] : indicatorFields(indicators)) {
+                if (*value) present |= bit;
+            }
+            putByte(out, present);
+            for (auto [bit, value] : indicatorFields(indicators)) {
+                if (*value) putDouble(out, **value);
+            }
+        }
+
+        void readIndicators(Reader& in, QuoteIndicators& indicators) {
+            uint8_t present = in.byte();
+            if (present & ~KNOWN_INDICATORS) {
+                throw std::runtime_error("Malformed binary message: unknown indicator bits");
+            }
+            for (auto [bit, value] : indicatorFields(indicators)) {
+                if (present & bit) {
+                    *value = in.float64();
+                }
+                else {
+                    value->reset();
+                }
+            }
+        }
+
+        void readQuote(Reader& in, StockQuote& quote) {
+            in.string(quote.symbol);
+            quote.price = in.float64();
+            // Milliseconds like from_json, so JSON and binary peers agree on timestamps
+            quote.timestamp = fromEpochMillis(in.int64());
+            uint8_t flags = in.byte();
+            if (flags & ~KNOWN_QUOTE_FLAGS) {
+                throw std::runtime_error("Malformed binary message: unknown quote flags");
+            }
+            if (flags & HAS_CHANGE_PERCENT) {
+                quote.change_percent = in.float64();
+            }
+            else {
+                quote.change_percent = std::nullopt;
+            }
+            in.string(quote.currency);
+            if (flags & HAS_INDICATORS) {
+                readIndicators(in, quote.indicators ? *quote.indicators : quote.indicators.emplace());
+            }
+            else {
+                quote.indicators = std::nullopt;
+            }
+        }
+
+        // Smallest possible encoded MetricStats: empty name and ten one-byte varints
+        constexpr size_t MIN_METRIC_STATS_SIZE = 1 + 10;
+
+        void writeStats(std::string& out, const MetricsSnapshot& snapshot) {
+            putInt64(out, std::chrono::duration_cast<std::chrono::milliseconds>(
+                snapshot.taken_at.time_since_epoch()).count());
+            putVarint(out, snapshot.metrics.size());
+            for (const auto& stats : snapshot.metrics) {
+                putString(out, stats.name);
+                for (uint64_t value : { stats.count, stats.errors, stats.bytes, stats.mean_ns,
+                        stats.p50_ns, stats.p90_ns, stats.p99_ns, stats.p999_ns, stats.max_ns }) {
+                    putVarint(out, value);
+                }
+            }
+        }
+
+        void readStats(Reader& in, MetricsSnapshot& snapshot) {
+            snapshot.taken_at = std::chrono::system_clock::time_point(
+                std::chrono::milliseconds(in.int64()));
+            snapshot.metrics.resize(in.count(MIN_METRIC_STATS_SIZE));
+            for (auto& stats : snapshot.metrics) {
+                in.string(stats.name);
+                for (uint64_t* value : { &stats.count, &stats.errors, &stats.bytes, &stats.mean_ns,
+                        &stats.p50_ns, &stats.p90_ns, &stats.p99_ns, &stats.p999_ns, &stats.max_ns }) {
+                    *value = in.varint();
+                }
+            }
+        }
+
+        void writeBarQuery(std::string& out, const BarQuery& query) {
+            putVarint(out, static_cast<uint64_t>(query.interval.count()));
+            putInt64(out, toEpochMillis(query.from));
+            putInt64(out, toEpochMillis(query.to));
+            putInt64(out, query.limit);
+        }
+
+        void readBarQuery(Reader& in, BarQuery& query) {
+            query.interval = std::chrono::seconds(static_cast<int64_t>(in.varint()));
+            query.from = fromEpochMillis(in.int64());
+            query.to = fromEpochMillis(in.int64());
+            query.limit = static_cast<int>(in.int64());
+        }
+
+        // Smallest possible encoded bar: open time, one-byte interval and volume, four prices
+        constexpr size_t MIN_BAR_SIZE = 8 + 1 + 4 * 8 + 1;
+
+        void writeBar(std::string& out, const OhlcvBar& bar) {
+            putInt64(out, toEpochMillis(bar.open_time));
+            putVarint(out, static_cast<uint64_t>(bar.interval.count()));
+            putDouble(out, bar.open);
+            putDouble(out, bar.high);
+            putDouble(out, bar.low);
+            putDouble(out, bar.close);
+            putVarint(out, bar.volume);
+        }
+
+        void readBar(Reader& in, OhlcvBar& bar) {
+            bar.open_time = fromEpochMillis(in.int64());
+            bar.interval = std::chrono::seconds(static_cast<int64_t>(in.varint()));
+            bar.open = in.float64();
+            bar.high = in.float64();
+            bar.low = in.float64();
+            bar.close = in.float64();
+            bar.volume = in.varint();
+        }
+
+        // Returns the optional's value, constructing it only if it is empty, so a
+        // Message reused across receives keeps its strings' and vectors' capacity.
+        template <typename T>
+        T& reuse(std::optional<T>& field) {
+            return field ? *field : field.emplace();
+        }
+    }
+
+    bool isBinaryFrame(const void* data, size_t size) {
+        return size > 0 && *static_cast<const uint8_t*>(data) == BINARY_FORMAT_V1;
+    }
+
+    void to_binary(std::string& out, const StockQuote& quote) {
+        putString(out, quote.symbol);
+        putDouble(out, quote.price);
+        putInt64(out, toEpochMillis(quote.timestamp));
+        uint8_t flags = 0;
+        if (quote.change_percent) flags |= HAS_CHANGE_PERCENT;
+        if (quote.indicators) flags |= HAS_INDICATORS;
+        putByte(out, flags);
+        if (quote.change_percent) {
+            putDouble(out, *quote.change_percent);
+        }
+        putString(out, quote.currency);
+        if (quote.indicators) {
+            writeIndicators(out, *quote.indicators);
+        }
+    }
+
+    void to_binary(std::string& out, const Message& msg) {
+        uint64_t fields = 0;
+        if (msg.quote) fields |= HAS_QUOTE;
+        if (msg.error) fields |= HAS_ERROR;
+        bool packedHistory = msg.priceHistory && msg.historyEncoding == HistoryEncoding::Columnar;
+        if (msg.priceHistory && !packedHistory) fields |= HAS_PRICE_HISTORY;
+        if (msg.subscriptions) fields |= HAS_SUBSCRIPTIONS;
+        if (msg.quotes) fields |= HAS_QUOTES;
+        if (msg.stats) fields |= HAS_STATS;
+        if (msg.barQuery) fields |= HAS_BAR_QUERY;
+        if (msg.bars) fields |= HAS_BARS;
+        if (msg.historyEncoding != HistoryEncoding::Rows) fields |= HAS_HISTORY_ENCODING;
+        if (packedHistory) fields |= HAS_PACKED_HISTORY;
+        if (msg.sentAt) fields |= HAS_SENT_AT;
+        if (msg.since) fields |= HAS_SINCE;
+        if (msg.subscriptionsVersion) fields |= HAS_SUBSCRIPTIONS_VERSION;
+        if (msg.removedSubscriptions) fields |= HAS_REMOVED_SUBSCRIPTIONS;
+
+        putByte(out, BINARY_FORMAT_V1);
+        putByte(out, static_cast<uint8_t>(msg.type));
+        putVarint(out, fields);
+        putString(out, msg.symbol);
+        putString(out, msg.currency);
+
+        if (msg.quote) {
+            to_binary(out, *msg.quote);
+        }
+        if (msg.error) {
+            putString(out, *msg.error);
+        }
+        if (msg.priceHistory && !packedHistory) {
+            putVarint(out, msg.priceHistory->size());
+            for (const auto& quote : *msg.priceHistory) {
+                to_binary(out, quote);
+            }
+        }
+        if (msg.subscriptions) {
+            putVarint(out, msg.subscriptions->size());
+            for (const auto& symbol : *msg.subscriptions) {
+                putString(out, symbol);
+            }
+        }
+        if (msg.quotes) {
+            putVarint(out, msg.quotes->size());
+            for (const auto& quote : *msg.quotes) {
+                to_binary(out, quote);
+            }
+        }
+        if (msg.stats) {
+            writeStats(out, *msg.stats);
+        }
+        if (msg.barQuery) {
+            writeBarQuery(out, *msg.barQuery);
+        }
+        if (msg.bars) {
+            putVarint(out, msg.bars->size());
+            for (const auto& bar : *msg.bars) {
+                writeBar(out, bar);
+            }
+        }
+        if (msg.historyEncoding != HistoryEncoding::Rows) {
+            putByte(out, static_cast<uint8_t>(msg.historyEncoding));
+        }
+        if (packedHistory) {
+            std::string block;
+            encodeHistory(block, *msg.priceHistory);
+            putString(out, block);
+        }
+        if (msg.sentAt) {
+            putInt64(out, *msg.sentAt);
+        }
+        if (msg.since) {
+            putInt64(out, toEpochMillis(*msg.since));
+        }
+        if (msg.subscriptionsVersion) {
+            putVarint(out, *msg.subscriptionsVersion);
+        }
+        if (msg.removedSubscriptions) {
+            putVarint(out, msg.removedSubscriptions->size());
+            for (const auto& symbol : *msg.removedSubscriptions) {
+                putString(out, symbol);
+            }
+        }
+    }
+
+    void from_binary(const void* data, size_t size, Message& msg) {
+        Reader in(data, size);
+
+        if (in.byte() != BINARY_FORMAT_V1) {
+            throw std::runtime_error("Unsupported binary message format");
+        }
+
+        uint8_t type = in.byte();
+        if (type > MAX_MESSAGE_TYPE) {
+            throw std::runtime_error("Unknown message type: " + std::to_string(type));
+        }
+        msg.type = static_cast<MessageType>(type);
+
+        // Skipping a field we can't parse would misread everything after it
+        uint64_t fields = in.varint();
+        if (fields & ~KNOWN_FIELDS) {
+            throw std::runtime_error("Malformed binary message: unknown fields");
+        }
+        in.string(msg.symbol);
+        in.string(msg.currency);
+
+        if (fields & HAS_QUOTE) {
+            readQuote(in, reuse(msg.quote));
+        }
+        else {
+            msg.quote.reset();
+        }
+
+        if (fields & HAS_ERROR) {
+            in.string(reuse(msg.error));
+        }
+        else {
+            msg.error.reset();
+        }
+
+        if (fields & HAS_PRICE_HISTORY) {
+            auto& history = reuse(msg.priceHistory);
+            history.resize(in.count(MIN_QUOTE_SIZE));
+            for (auto& quote : history) {
+                readQuote(in, quote);
+            }
+        }
+        else if (!(fields & HAS_PACKED_HISTORY)) {
+            msg.priceHistory.reset();
+        }
+
+        if (fields & HAS_SUBSCRIPTIONS) {
+            auto& subscriptions = reuse(msg.subscriptions);
+            subscriptions.resize(in.count(1));
+            for (auto& symbol : subscriptions) {
+                in.string(symbol);
+            }
+        }
+        else {
+            msg.subscriptions.reset();
+        }
+
+        if (fields & HAS_QUOTES) {
+            auto& quotes = reuse(msg.quotes);
+            quotes.resize(in.count(MIN_QUOTE_SIZE));
+            for (auto& quote : quotes) {
+                readQuote(in, quote);
+            }
+        }
+        else {
+            msg.quotes.reset();
+        }
+
+        if (fields & HAS_STATS) {
+            readStats(in, reuse(msg.stats));
+        }
+        else {
+            msg.stats.reset();
+        }
+
+        if (fields & HAS_BAR_QUERY) {
+            readBarQuery(in, reuse(msg.barQuery));
+        }
+        else {
+            msg.barQuery.reset();
+        }
+
+        if (fields & HAS_BARS) {
+            auto& bars = reuse(msg.bars);
+            bars.resize(in.count(MIN_BAR_SIZE));
+            for (auto& bar : bars) {
+                readBar(in, bar);
+            }
+        }
+        else {
+            msg.bars.reset();
+        }
+
+        if (fields & HAS_HISTORY_ENCODING) {
+            uint8_t encoding = in.byte();
+            if (encoding > static_cast<uint8_t>(HistoryEncoding::Columnar)) {
+                throw std::runtime_error("Unknown history encoding: " + std::to_string(encoding));
+            }
+            msg.historyEncoding = static_cast<HistoryEncoding>(encoding);
+        }
+        else {
+            msg.historyEncoding = HistoryEncoding::Rows;
+        }
+
+        if (fields & HAS_PACKED_HISTORY) {
+            auto size = static_cast<size_t>(in.count(1));
+            decodeHistory(in.bytes(size), size, reuse(msg.priceHistory));
+        }
+
+        if (fields & HAS_SENT_AT) {
+            msg.sentAt = in.int64();
+        }
+        else {
+            msg.sentAt.reset();
+        }
+
+        if (fields & HAS_SINCE) {
+            msg.since = fromEpochMillis(in.int64());
+        }
+        else {
+            msg.since.reset();
+        }
+
+        if (fields & HAS_SUBSCRIPTIONS_VERSION) {
+            msg.subscriptionsVersion = in.varint();
+        }
+        else {
+            msg.subscriptionsVersion.reset();
+        }
+
+        if (fields & HAS_REMOVED_SUBSCRIPTIONS) {
+            auto& removed = reuse(msg.removedSubscriptions);
+            removed.resize(in.count(1));
+            for (auto& symbol : removed) {
+                in.string(symbol);
+            }
+        }
+        else {
+            msg.removedSubscriptions.reset();
+        }
+    }
+}
@@ -0,0 +1,99 @@
+#include "StockTracker/ConflatingPublisher.h"
+
+namespace StockTracker {
+
+    ConflatingPublisher::ConflatingPublisher(size_t max_pending_control, int send_hwm,
+        std::shared_ptr<zmq::context_t> context)
+        : socket(zmq::socket_type::xpub, std::move(context))
+        , maxPendingControl(max_pending_control)
+    {
+        socket.getSocket().set(zmq::sockopt::sndhwm, send_hwm);
+        socket.getSocket().set(zmq::sockopt::xpub_nodrop, 1);
+    }
+
+    void ConflatingPublisher::publish(Message msg) {
+        ++counters.published;
+        uint64_t sequence = nextSequence++;
+
+        if (msg.type == MessageType::QuoteUpdate) {
+            auto it = latestQuotes.find(msg.symbol);
+            if (it != latestQuotes.end()) {
+                it->second = std::move(msg);
+                ++counters.conflated;
+            }
+            else {
+                quoteOrder.push_back(PendingQuote{ sequence, msg.symbol });
+                latestQuotes.emplace(msg.symbol, std::move(msg));
+            }
+        }
+        else {
+            if (pendingControl.size() >= maxPendingControl) {
+                pendingControl.pop_front();
+                ++counters.dropped;
+            }
+            pendingControl.push_back(PendingControl{ sequence, std::move(msg) });
+        }
+
+        pump();
+    }
+
+    size_t ConflatingPublisher::pump() {
+        drainSubscriptions();
+
+        // Merge the two queues by publish sequence
+        size_t sent = 0;
+        while (!pendingControl.empty() || !quoteOrder.empty()) {
+            bool control = quoteOrder.empty()
+                || (!pendingControl.empty() && pendingControl.front().sequence < quoteOrder.front().sequence);
+            if (control) {
+                if (!socket.trySend(pendingControl.front().message)) {
+                    break;
+                }
+                pendingControl.pop_front();
+            }
+            else {
+                auto it = latestQuotes.find(quoteOrder.front().symbol);
+                if (!socket.trySend(it->second)) {
+                    break;
+                }
+                latestQuotes.erase(it);
+                quoteOrder.pop_front();
+            }
+            ++sent;
+        }
+
+        counters.sent += sent;
+        return sent;
+    }
+
+    size_t ConflatingPublisher::pump(std::chrono::milliseconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        size_t sent = pump();
+
+        while (!pendingControl.empty() || !quoteOrder.empty()) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+            if (remaining.count() <= 0) {
+                break;
+            }
+
+            zmq::pollitem_t item{ socket.getSocket().handle(), 0, ZMQ_POLLOUT, 0 };
+            zmq::poll(&item, 1, remaining);
+            sent += pump();
+        }
+        return sent;
+    }
+
+    ConflationStats ConflatingPublisher::stats() const {
+        ConflationStats stats = counters;
+        stats.pending = pendingControl.size() + latestQuotes.size();
+        return stats;
+    }
+
+    void ConflatingPublisher::drainSubscriptions() {
+        // XPUB hands us (un)subscribe notifications; we don't need them, but
+        // leaving them unread would fill the socket's receive queue
+        zmq::message_t notification;
+        while (socket.getSocket().recv(notification, zmq::recv_flags::dontwait)) {}
+    }
+}
@@ -0,0 +1,35 @@
+#include "StockTracker/Context.h"
+#include <mutex>
+#include <stdexcept>
+
+namespace StockTracker {
+
+    namespace {
+        std::mutex sharedContextMutex;
+        ContextOptions sharedContextOptions;
+        std::shared_ptr<zmq::context_t> sharedContextInstance;
+    }
+
+    std::shared_ptr<zmq::context_t> makeContext(const ContextOptions& options) {
+        if (options.io_threads < 0 || options.max_sockets <= 0) {
+            throw std::invalid_argument("Invalid ZeroMQ context options");
+        }
+        return std::make_shared<zmq::context_t>(options.io_threads, options.max_sockets);
+    }
+
+    std::shared_ptr<zmq::context_t> sharedContext() {
+        std::lock_guard<std::mutex> lock(sharedContextMutex);
+        if (!sharedContextInstance) {
+            sharedContextInstance = makeContext(sharedContextOptions);
+        }
+        return sharedContextInstance;
+    }
+
+    void configureSharedContext(const ContextOptions& options) {
+        std::lock_guard<std::mutex> lock(sharedContextMutex);
+        if (sharedContextInstance) {
+            throw std::logic_error("The shared ZeroMQ context is already in use");
+        }
+        sharedContextOptions = options;
+    }
+}
\ No newline at end of file
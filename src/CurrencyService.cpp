@@ -1,15 +1,46 @@
 #include "StockTracker/CurrencyService.h"
+#include "StockTracker/Metrics.h"
 #include <spdlog/spdlog.h>
 #include <algorithm>
 
 namespace StockTracker {
 
-    CurrencyService::CurrencyService()
-        : context(std::make_unique<zmq::context_t>(1))
-        , socket(std::make_unique<zmq::socket_t>(*context, zmq::socket_type::req))
+    namespace {
+        // Rates are derived by converting this amount, so a service that rounds
+        // its results to a few decimals still gives us a precise rate.
+        constexpr double RATE_PROBE_AMOUNT = 1'000'000.0;
+
+        // No aliasing and no branches, so this compiles to packed multiplies
+        void scaleAmounts(double* amounts, size_t count, double factor) {
+            for (size_t i = 0; i < count; ++i) {
+                amounts[i] *= factor;
+            }
+        }
+
+        void scaleOptional(std::optional<double>& amount, double factor) {
+            if (amount) {
+                *amount *= factor;
+            }
+        }
+    }
+
+    CurrencyService::CurrencyService(const std::string& endpoint, std::shared_ptr<zmq::context_t> context)
+        : context(std::move(context))
+        , endpoint(endpoint)
     {
-        socket->connect(ENDPOINT);
-        //spdlog::info("CurrencyService connected to {}", ENDPOINT);
+        resetSocket();
+        //spdlog::info("CurrencyService connected to {}", endpoint);
+    }
+
+    void CurrencyService::resetSocket() {
+        if (socket) {
+            // Drop the unanswered request instead of blocking on close
+            socket->set(zmq::sockopt::linger, 0);
+            socket->close();
+        }
+        socket = std::make_unique<zmq::socket_t>(*context, zmq::socket_type::req);
+        socket->set(zmq::sockopt::rcvtimeo, REPLY_TIMEOUT_MS);
+        socket->connect(endpoint);
     }
 
     bool CurrencyService::isValidCurrencyCode(const std::string& currency) {
@@ -25,46 +56,136 @@ namespace StockTracker {
     }
 
     double CurrencyService::convertCurrency(double amount, const std::string& to_currency) {
+        return amount * getRate(to_currency);
+    }
+
+    std::vector<double> CurrencyService::convertMany(const std::vector<double>& amounts, const std::string& to_currency) {
+        double rate = getRate(to_currency);
+
+        std::vector<double> converted(amounts);
+        scaleAmounts(converted.data(), converted.size(), rate);
+        return converted;
+    }
+
+    void CurrencyService::convertInPlace(double* amounts, size_t count, const std::string& to_currency,
+        const std::string& from_currency) {
+        scaleAmounts(amounts, count, conversionFactor(from_currency, to_currency));
+    }
+
+    void CurrencyService::convertQuotes(std::vector<StockQuote>& quotes, const std::string& to_currency) {
+        // Checked even when there is nothing to convert, so the caller learns about a bad
+        // target currency from the first (possibly empty) history
+        if (!isValidCurrencyCode(to_currency)) {
+            throw std::runtime_error("Invalid currency code: " + to_currency);
+        }
+
+        // Source currencies in order of first appearance. There are only a dozen, and a
+        // history is normally all one, so a linear scan beats hashing every quote.
+        struct Group {
+            std::string currency;
+            double factor;
+        };
+        std::vector<Group> groups;
+        auto findGroup = [&](const std::string& currency) {
+            return std::find_if(groups.begin(), groups.end(), [&](const Group& g) { return g.currency == currency; });
+        };
+        for (const auto& quote : quotes) {
+            if (findGroup(quote.currency) == groups.end()) {
+                groups.push_back(Group{ quote.currency, conversionFactor(quote.currency, to_currency) });
+            }
+        }
+
+        // All rates are known, so nothing below can throw. Currency codes fit in the small
+        // string buffer, so rewriting them doesn't allocate.
+        auto group = groups.begin();
+        for (auto& quote : quotes) {
+            if (group->currency != quote.currency) {
+                group = findGroup(quote.currency);
+            }
+            double factor = group->factor;
+            quote.price *= factor;
+            if (quote.indicators) {
+                scaleOptional(quote.indicators->sma, factor);
+                scaleOptional(quote.indicators->ema, factor);
+                scaleOptional(quote.indicators->vwap, factor);
+            }
+            quote.currency = to_currency;
+        }
+    }
+
+    double CurrencyService::conversionFactor(const std::string& from_currency, const std::string& to_currency) {
+        if (from_currency == to_currency) {
+            if (!isValidCurrencyCode(to_currency)) {
+                throw std::runtime_error("Invalid currency code: " + to_currency);
+            }
+            return 1.0;
+        }
+        return getRate(to_currency) / getRate(from_currency);
+    }
+
+    double CurrencyService::getRate(const std::string& to_currency) {
         if (!isValidCurrencyCode(to_currency)) {
             throw std::runtime_error("Invalid currency code: " + to_currency);
         }
+        if (to_currency == DEFAULT_CURRENCY) {
+            return 1.0;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        auto it = rates.find(to_currency);
+        if (it != rates.end() && now - it->second.fetched_at < rateTtl) {
+            return it->second.rate;
+        }
+
+        double rate = requestConversion(RATE_PROBE_AMOUNT, to_currency) / RATE_PROBE_AMOUNT;
+        if (rateTtl.count() > 0) {
+            rates[to_currency] = CachedRate{ rate, now };
+        }
+        return rate;
+    }
 
-        // Create request JSON
+    std::string CurrencyService::makeConversionRequest(double amount, const std::string& to_currency) {
         nlohmann::json request = {
             {"amount", amount},
             {"from_currency", DEFAULT_CURRENCY},
             {"to_currency", to_currency}
         };
+        return request.dump();
+    }
+
+    double CurrencyService::parseConversionReply(const void* data, size_t size) {
+        auto begin = static_cast<const char*>(data);
+        auto response = nlohmann::json::parse(begin, begin + size);
+
+        if (response.contains("error")) {
+            throw std::runtime_error("Currency conversion failed: " +
+                response["error"].get<std::string>());
+        }
+
+        if (!response.contains("converted_amount") || response["converted_amount"].is_null()) {
+            throw std::runtime_error("Invalid response from currency service");
+        }
+
+        return response["converted_amount"].get<double>();
+    }
 
+    double CurrencyService::requestConversion(double amount, const std::string& to_currency) {
+        MetricTimer timer(Metric::CurrencyConvert);
         spdlog::debug("Requesting conversion: {} USD to {}", amount, to_currency);
 
         // Send request
-        std::string request_str = request.dump();
+        std::string request_str = makeConversionRequest(amount, to_currency);
         socket->send(zmq::buffer(request_str), zmq::send_flags::none);
 
-        // Set timeout for receive
-        socket->set(zmq::sockopt::rcvtimeo, 2000);
-
         // Receive response
         zmq::message_t reply;
         auto result = socket->recv(reply);
 
         if (result) {
-            std::string reply_str(static_cast<char*>(reply.data()), reply.size());
-            auto response = nlohmann::json::parse(reply_str);
-
-            if (response.contains("error")) {
-                throw std::runtime_error("Currency conversion failed: " +
-                    response["error"].get<std::string>());
-            }
-
-            if (!response.contains("converted_amount") || response["converted_amount"].is_null()) {
-                throw std::runtime_error("Invalid response from currency service");
-            }
-
-            return response["converted_amount"].get<double>();
+            return parseConversionReply(reply.data(), reply.size());
         }
 
+        resetSocket();
         throw std::runtime_error("No response from currency service");
     }
 
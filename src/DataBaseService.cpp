@@ -1,35 +1,259 @@
 #include "StockTracker/DatabaseService.h"
+#include "StockTracker/Metrics.h"
 #include <spdlog/spdlog.h>
 #include <stdexcept>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <utility>
 
 namespace StockTracker {
 
-    DatabaseService::DatabaseService(const std::string& db_path) {
+    namespace {
+        void execute(sqlite3* db, const char* sql, const char* what) {
+            char* errMsg = nullptr;
+            if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+                std::string error = errMsg ? errMsg : "unknown error";
+                sqlite3_free(errMsg);
+                throw std::runtime_error(std::string(what) + ": " + error);
+            }
+        }
+
+        // price_bars times are milliseconds since the epoch, the unit used on the wire
+        int64_t toBarTime(std::chrono::system_clock::time_point time) {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+        }
+
+        std::chrono::system_clock::time_point fromBarTime(int64_t millis) {
+            return std::chrono::system_clock::time_point(std::chrono::milliseconds(millis));
+        }
+
+        // Prepared on the main connection and on every pooled one
+        const char* SUBSCRIPTIONS_SQL = "SELECT symbol FROM subscriptions ORDER BY symbol";
+        const char* SUBSCRIPTIONS_VERSION_SQL = "SELECT COALESCE(MAX(version), 0) FROM subscription_changes";
+        const char* SUBSCRIPTION_CHANGES_SQL = "SELECT symbol, added FROM subscription_changes WHERE version > ? ORDER BY version";
+
+        std::vector<std::string> readSubscriptions(sqlite3_stmt* stmt) {
+            SqliteStatementReset reset(stmt);
+
+            std::vector<std::string> subscriptions;
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                subscriptions.push_back(
+                    reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0))
+                );
+            }
+            return subscriptions;
+        }
+
+        uint64_t readSubscriptionsVersion(sqlite3_stmt* stmt) {
+            SqliteStatementReset reset(stmt);
+            if (sqlite3_step(stmt) != SQLITE_ROW) {
+                throw std::runtime_error("Failed to read subscriptions version");
+            }
+            return static_cast<uint64_t>(sqlite3_column_int64(stmt, 0));
+        }
+
+        // One read transaction, so the version matches the rows read with it
+        SubscriptionDelta readSubscriptionChanges(sqlite3* db, sqlite3_stmt* versionStmt,
+            sqlite3_stmt* changesStmt, sqlite3_stmt* listStmt, uint64_t since) {
+            SubscriptionDelta delta;
+            execute(db, "BEGIN", "Failed to begin transaction");
+            try {
+                delta.version = readSubscriptionsVersion(versionStmt);
+                if (since == 0 || since > delta.version) {
+                    delta.full = true;
+                    delta.added = readSubscriptions(listStmt);
+                }
+                else {
+                    SqliteStatementReset reset(changesStmt);
+                    sqlite3_bind_int64(changesStmt, 1, static_cast<int64_t>(since));
+                    while (sqlite3_step(changesStmt) == SQLITE_ROW) {
+                        auto& list = sqlite3_column_int(changesStmt, 1) ? delta.added : delta.removed;
+                        list.push_back(reinterpret_cast<const char*>(sqlite3_column_text(changesStmt, 0)));
+                    }
+                }
+                execute(db, "COMMIT", "Failed to end transaction");
+            }
+            catch (...) {
+                sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+                throw;
+            }
+            return delta;
+        }
+
+    }
+
+    DatabaseService::DatabaseService(const std::string& db_path)
+        : DatabaseService(db_path, nullptr)
+    {}
+
+    // One pooled read-only connection with its own statements
+    struct DatabaseService::ReadConnection {
+        sqlite3* db{ nullptr };
+        std::unique_ptr<SqlitePriceStore> prices;   // Null unless price history is in the database
+        sqlite3_stmt* subscriptionsStmt{ nullptr };
+        sqlite3_stmt* subscriptionsVersionStmt{ nullptr };
+        sqlite3_stmt* subscriptionChangesStmt{ nullptr };
+
+        ReadConnection(const std::string& path, const ReadPoolOptions& options, bool withPrices) {
+            // NOMUTEX: a connection is only ever used by the thread leasing it
+            if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK) {
+                std::string error = db ? sqlite3_errmsg(db) : "out of memory";
+                sqlite3_close(db);
+                throw std::runtime_error("Failed to open read connection: " + error);
+            }
+            try {
+                sqlite3_busy_timeout(db, static_cast<int>(options.busy_timeout.count()));
+                if (withPrices) {
+                    prices = std::make_unique<SqlitePriceStore>(db, true);
+                }
+                for (auto [sql, stmt] : { std::pair{ SUBSCRIPTIONS_SQL, &subscriptionsStmt },
+                                          std::pair{ SUBSCRIPTIONS_VERSION_SQL, &subscriptionsVersionStmt },
+                                          std::pair{ SUBSCRIPTION_CHANGES_SQL, &subscriptionChangesStmt } }) {
+                    if (sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, stmt, nullptr) != SQLITE_OK) {
+                        throw std::runtime_error(std::string("Failed to prepare statement: ") + sqlite3_errmsg(db));
+                    }
+                }
+            }
+            catch (...) {
+                finalizeStatements();
+                prices.reset();
+                sqlite3_close(db);
+                throw;
+            }
+        }
+
+        ~ReadConnection() {
+            finalizeStatements();
+            prices.reset();
+            sqlite3_close(db);
+        }
+
+        ReadConnection(const ReadConnection&) = delete;
+        ReadConnection& operator=(const ReadConnection&) = delete;
+
+    private:
+        void finalizeStatements() {
+            for (sqlite3_stmt* stmt : { subscriptionsStmt, subscriptionsVersionStmt, subscriptionChangesStmt }) {
+                sqlite3_finalize(stmt);
+            }
+        }
+    };
+
+    // Takes an idle connection for the duration of one read, waiting if there is none
+    class DatabaseService::ReadLease {
+    public:
+        explicit ReadLease(DatabaseService& service)
+            : service(service)
+        {
+            std::unique_lock<std::mutex> lock(service.readPoolMutex);
+            service.readerAvailable.wait(lock, [&] { return !service.idleReaders.empty(); });
+            connection = std::move(service.idleReaders.back());
+            service.idleReaders.pop_back();
+        }
+
+        ~ReadLease() {
+            {
+                std::lock_guard<std::mutex> lock(service.readPoolMutex);
+                service.idleReaders.push_back(std::move(connection));
+            }
+            service.readerAvailable.notify_one();
+        }
+
+        ReadLease(const ReadLease&) = delete;
+        ReadLease& operator=(const ReadLease&) = delete;
+
+        ReadConnection* operator->() const { return connection.get(); }
+
+    private:
+        DatabaseService& service;
+        std::unique_ptr<ReadConnection> connection;
+    };
+
+    DatabaseService::DatabaseService(const std::string& db_path, std::unique_ptr<PriceStore> price_store)
+        : dbPath(db_path)
+        , prices(std::move(price_store))
+    {
         if (sqlite3_open(db_path.c_str(), &db) != SQLITE_OK) {
             throw std::runtime_error("Failed to open database");
         }
-        initializeTables();
+        try {
+            initializeTables();
+            if (!prices) {
+                prices = std::make_unique<SqlitePriceStore>(db);
+            }
+            pricesInDatabase = dynamic_cast<SqlitePriceStore*>(prices.get()) != nullptr;
+            prepareStatements();
+        }
+        catch (...) {
+            finalizeStatements();
+            prices.reset();
+            sqlite3_close(db);
+            throw;
+        }
     }
 
     DatabaseService::~DatabaseService() {
+        stopWriteBehind();
+        if (bars) {
+            try {
+                std::lock_guard<std::mutex> lock(dbMutex);
+                writeBars(bars->takeAll());
+            }
+            catch (const std::exception& e) {
+                spdlog::error("Failed to save open bars: {}", e.what());
+            }
+        }
+        try {
+            prices->sync();
+        }
+        catch (const std::exception& e) {
+            spdlog::error("Failed to sync price history: {}", e.what());
+        }
+        idleReaders.clear();
+        finalizeStatements();
+        prices.reset();   // Before the connection closes; the SQLite store uses it
         if (db) {
             sqlite3_close(db);
         }
     }
 
     void DatabaseService::initializeTables() {
+        // WAL lets readers run alongside the writer, and with synchronous=NORMAL
+        // a commit no longer needs its own fsync (only checkpoints do).
         const char* sql = R"(
-        CREATE TABLE IF NOT EXISTS price_history (
+        PRAGMA journal_mode=WAL;
+        PRAGMA synchronous=NORMAL;
+
+        -- first_tick/last_tick (ms) tell which write holds the bar's open and close,
+        -- so partial bars written at different times merge correctly
+        CREATE TABLE IF NOT EXISTS price_bars (
             symbol TEXT NOT NULL,
-            price REAL NOT NULL,
-            timestamp INTEGER NOT NULL,
-            change_percent REAL
-        );
+            interval_s INTEGER NOT NULL,
+            open_time INTEGER NOT NULL,
+            open REAL NOT NULL,
+            high REAL NOT NULL,
+            low REAL NOT NULL,
+            close REAL NOT NULL,
+            volume INTEGER NOT NULL,
+            first_tick INTEGER NOT NULL,
+            last_tick INTEGER NOT NULL,
+            PRIMARY KEY (symbol, interval_s, open_time)
+        ) WITHOUT ROWID;
 
         CREATE TABLE IF NOT EXISTS subscriptions (
             symbol TEXT PRIMARY KEY,
             added_at INTEGER NOT NULL
         );
+
+        -- Latest change per symbol; version is what clients sync subscriptions from.
+        -- AUTOINCREMENT so versions never go back when old changes are pruned.
+        CREATE TABLE IF NOT EXISTS subscription_changes (
+            version INTEGER PRIMARY KEY AUTOINCREMENT,
+            symbol TEXT NOT NULL,
+            added INTEGER NOT NULL
+        );
+        CREATE INDEX IF NOT EXISTS idx_subscription_changes_symbol ON subscription_changes (symbol);
     )";
 
         char* errMsg = nullptr;
@@ -40,131 +264,856 @@ namespace StockTracker {
         }
     }
 
+    void DatabaseService::prepareStatements() {
+        auto prepare = [this](const char* sql, sqlite3_stmt*& stmt) {
+            if (sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+                throw std::runtime_error(std::string("Failed to prepare statement: ") + sqlite3_errmsg(db));
+            }
+        };
+
+        prepare(R"(
+        INSERT OR REPLACE INTO subscriptions (symbol, added_at)
+        VALUES (?, ?)
+    )", saveSubscriptionStmt);
+
+        prepare("DELETE FROM subscriptions WHERE symbol = ?", removeSubscriptionStmt);
+        prepare(SUBSCRIPTIONS_SQL, subscriptionsStmt);
+        prepare("INSERT INTO subscription_changes (symbol, added) VALUES (?, ?)", logSubscriptionStmt);
+        prepare(R"(
+        DELETE FROM subscription_changes
+        WHERE symbol = ?1 AND version < (SELECT MAX(version) FROM subscription_changes WHERE symbol = ?1)
+    )", pruneSubscriptionLogStmt);
+        prepare(SUBSCRIPTIONS_VERSION_SQL, subscriptionsVersionStmt);
+        prepare(SUBSCRIPTION_CHANGES_SQL, subscriptionChangesStmt);
+
+        // SET expressions see the row as it was before the update
+        prepare(R"(
+        INSERT INTO price_bars (symbol, interval_s, open_time, open, high, low, close, volume, first_tick, last_tick)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+        ON CONFLICT (symbol, interval_s, open_time) DO UPDATE SET
+            open = CASE WHEN excluded.first_tick < first_tick THEN excluded.open ELSE open END,
+            close = CASE WHEN excluded.last_tick >= last_tick THEN excluded.close ELSE close END,
+            high = MAX(high, excluded.high),
+            low = MIN(low, excluded.low),
+            volume = volume + excluded.volume,
+            first_tick = MIN(first_tick, excluded.first_tick),
+            last_tick = MAX(last_tick, excluded.last_tick)
+    )", upsertBarStmt);
+
+        prepare(R"(
+        SELECT open_time, open, high, low, close, volume, first_tick, last_tick
+        FROM price_bars
+        WHERE symbol = ? AND interval_s = ? AND open_time >= ? AND open_time < ?
+        ORDER BY open_time ASC
+        LIMIT ?
+    )", barRangeStmt);
+    }
+
+    void DatabaseService::finalizeStatements() {
+        // sqlite3_finalize is a no-op on nullptr
+        for (sqlite3_stmt** stmt : { &saveSubscriptionStmt, &removeSubscriptionStmt, &subscriptionsStmt,
+                                     &logSubscriptionStmt, &pruneSubscriptionLogStmt, &subscriptionsVersionStmt,
+                                     &subscriptionChangesStmt, &upsertBarStmt, &barRangeStmt }) {
+            sqlite3_finalize(*stmt);
+            *stmt = nullptr;
+        }
+    }
+
     void DatabaseService::savePrice(const StockQuote& quote) {
-        const char* sql = R"(
-        INSERT INTO price_history (symbol, price, timestamp, change_percent)
-        VALUES (?, ?, ?, ?)
-    )";
+        MetricTimer timer(Metric::DbSavePrice);
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            if (writeBehind) {
+                rethrowWriterError();
+                // Backpressure: hold the producer until the writer catches up
+                queueNotFull.wait(lock, [this] {
+                    return writeQueue.size() < writeBehindOptions.max_queue_size || stopWriter;
+                });
+                writeQueue.push_back(quote);
+                ++queuedCount;
+                queueNotEmpty.notify_one();
+            }
+            else {
+                std::lock_guard<std::mutex> dbLock(dbMutex);
+                prices->append(&quote, 1);
+                if (bars) {
+                    bars->add(quote);
+                    writeBars(bars->takeClosed());
+                }
+            }
+        }
+
+        if (cache) {
+            cache->insert(quote);
+        }
+    }
+
+    bool DatabaseService::trySavePrice(const StockQuote& quote) {
+        MetricTimer timer(Metric::DbSavePrice);
+        bool queued = false;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (writeBehind) {
+                rethrowWriterError();
+                if (writeQueue.size() >= writeBehindOptions.max_queue_size) {
+                    timer.fail();
+                    return false;
+                }
+                writeQueue.push_back(quote);
+                ++queuedCount;
+                queueNotEmpty.notify_one();
+                queued = true;
+            }
+        }
+
+        if (!queued) {
+            timer.cancel();     // savePrice records its own sample
+            savePrice(quote);
+        }
+        else if (cache) {
+            cache->insert(quote);
+        }
+        return true;
+    }
+
+    // Caller must hold dbMutex
+    void DatabaseService::writeBars(const std::vector<BarDelta>& deltas) {
+        if (deltas.empty()) {
+            return;
+        }
+
+        // Group the upserts unless the caller already has a transaction open
+        bool ownTransaction = deltas.size() > 1 && sqlite3_get_autocommit(db);
+        if (ownTransaction) {
+            execute(db, "BEGIN", "Failed to begin transaction");
+        }
+
+        try {
+            sqlite3_stmt* stmt = upsertBarStmt;
+            SqliteStatementReset reset(stmt);
+
+            for (const auto& delta : deltas) {
+                const OhlcvBar& bar = delta.bar;
+                sqlite3_bind_text(stmt, 1, delta.symbol.c_str(), -1, SQLITE_STATIC);
+                sqlite3_bind_int64(stmt, 2, bar.interval.count());
+                sqlite3_bind_int64(stmt, 3, toBarTime(bar.open_time));
+                sqlite3_bind_double(stmt, 4, bar.open);
+                sqlite3_bind_double(stmt, 5, bar.high);
+                sqlite3_bind_double(stmt, 6, bar.low);
+                sqlite3_bind_double(stmt, 7, bar.close);
+                sqlite3_bind_int64(stmt, 8, static_cast<int64_t>(bar.volume));
+                sqlite3_bind_int64(stmt, 9, toBarTime(delta.first_tick));
+                sqlite3_bind_int64(stmt, 10, toBarTime(delta.last_tick));
+
+                if (sqlite3_step(stmt) != SQLITE_DONE) {
+                    throw std::runtime_error("Failed to save bar");
+                }
+                sqlite3_reset(stmt);
+            }
 
-        sqlite3_stmt* stmt;
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            throw std::runtime_error("Failed to prepare statement");
+            if (ownTransaction) {
+                execute(db, "COMMIT", "Failed to commit bars");
+            }
+        }
+        catch (...) {
+            if (ownTransaction) {
+                sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+            }
+            throw;
+        }
+    }
+
+    void DatabaseService::enableWriteBehind(const WriteBehindOptions& options) {
+        if (options.max_queue_size == 0 || options.max_batch_size == 0) {
+            throw std::invalid_argument("Write-behind queue and batch sizes must be non-zero");
         }
 
-        auto timestamp = quote.timestamp.time_since_epoch().count();
-        sqlite3_bind_text(stmt, 1, quote.symbol.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_double(stmt, 2, quote.price);
-        sqlite3_bind_int64(stmt, 3, timestamp);
-        if (quote.change_percent) {
-            sqlite3_bind_double(stmt, 4, *quote.change_percent);
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (writeBehind) {
+            throw std::logic_error("Write-behind is already enabled");
         }
-        else {
-            sqlite3_bind_null(stmt, 4);
+        writeBehindOptions = options;
+        writeBehind = true;
+        writerThread = std::thread(&DatabaseService::writerLoop, this);
+    }
+
+    void DatabaseService::flush() {
+        waitForWriter();
+
+        std::lock_guard<std::mutex> lock(dbMutex);
+        if (bars) {
+            writeBars(bars->takeAll());
         }
+        prices->sync();
+    }
 
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            sqlite3_finalize(stmt);
-            throw std::runtime_error("Failed to save price");
+    // Blocks until every quote queued so far is committed. Does nothing without write-behind.
+    void DatabaseService::waitForWriter() {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        if (writeBehind) {
+            uint64_t target = queuedCount;
+            flushRequested = true;
+            queueNotEmpty.notify_one();
+            batchCommitted.wait(lock, [&] { return committedCount >= target; });
+            rethrowWriterError();
         }
+    }
 
-        sqlite3_finalize(stmt);
+    size_t DatabaseService::pendingWrites() const {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        return static_cast<size_t>(queuedCount - committedCount);
+    }
+
+    void DatabaseService::writerLoop() {
+        std::vector<StockQuote> batch;
+        std::unique_lock<std::mutex> lock(queueMutex);
+
+        while (true) {
+            queueNotEmpty.wait(lock, [this] { return !writeQueue.empty() || stopWriter; });
+            if (writeQueue.empty()) {
+                break; // Stopping and fully drained
+            }
+
+            // Let the batch fill up unless someone needs it committed now
+            auto deadline = std::chrono::steady_clock::now() + writeBehindOptions.max_delay;
+            queueNotEmpty.wait_until(lock, deadline, [this] {
+                return writeQueue.size() >= writeBehindOptions.max_batch_size || stopWriter || flushRequested;
+            });
+
+            size_t count = std::min(writeQueue.size(), writeBehindOptions.max_batch_size);
+            batch.assign(std::make_move_iterator(writeQueue.begin()),
+                std::make_move_iterator(writeQueue.begin() + count));
+            writeQueue.erase(writeQueue.begin(), writeQueue.begin() + count);
+            if (writeQueue.empty()) {
+                flushRequested = false;
+            }
+            queueNotFull.notify_all();
+            lock.unlock();
+
+            std::exception_ptr error;
+            {
+                MetricTimer timer(Metric::DbWriteBatch);
+                std::lock_guard<std::mutex> dbLock(dbMutex);
+                bool committed = false;
+                try {
+                    execute(db, "BEGIN", "Failed to begin transaction");
+                    try {
+                        prices->append(batch.data(), batch.size());
+                        execute(db, "COMMIT", "Failed to commit prices");
+                        committed = true;
+                    }
+                    catch (...) {
+                        sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+                        throw;
+                    }
+
+                    // Only quotes that made it into the store count towards bars. Still under
+                    // dbMutex, so rebuildBars sees each quote either in the store and the
+                    // aggregator or in neither.
+                    if (bars) {
+                        for (const auto& quote : batch) {
+                            bars->add(quote);
+                        }
+                        writeBars(bars->takeClosed());
+                    }
+                }
+                catch (const std::exception& e) {
+                    if (committed) {
+                        spdlog::error("Failed to save bars for a batch of {} quotes: {}", batch.size(), e.what());
+                    }
+                    else {
+                        spdlog::error("Dropped batch of {} quotes: {}", batch.size(), e.what());
+                    }
+                    timer.fail();
+                    error = std::current_exception();
+                }
+            }
+
+            lock.lock();
+            committedCount += count;
+            if (error) {
+                writerError = error;
+            }
+            batchCommitted.notify_all();
+        }
+    }
+
+    void DatabaseService::stopWriteBehind() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (!writeBehind) {
+                return;
+            }
+            stopWriter = true;
+        }
+        queueNotEmpty.notify_all();
+        queueNotFull.notify_all();
+        writerThread.join();
+
+        std::lock_guard<std::mutex> lock(queueMutex);
+        writeBehind = false;
+        stopWriter = false;
+    }
+
+    // Caller must hold queueMutex
+    void DatabaseService::rethrowWriterError() {
+        if (writerError) {
+            auto error = writerError;
+            writerError = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Runs a query against the store itself when it allows concurrent reads, against a
+    // pooled connection's copy when the history is in the database, or else under dbMutex
+    template <typename Read>
+    auto DatabaseService::readPrices(Read&& read) {
+        if (prices->concurrentReads()) {
+            return read(*prices);
+        }
+        if (pooledPrices) {
+            ReadLease reader(*this);
+            return read(*reader->prices);
+        }
+        std::lock_guard<std::mutex> lock(dbMutex);
+        return read(*prices);
     }
 
     std::vector<StockQuote> DatabaseService::getPriceHistory(const std::string& symbol, int limit) {
-        const char* sql = R"(
-        SELECT symbol, price, timestamp, change_percent
-        FROM price_history
-        WHERE symbol = ?
-        ORDER BY timestamp DESC
-        LIMIT ?
-    )";
+        MetricTimer timer(Metric::DbPriceHistory);
+        if (cache) {
+            if (auto recent = cache->getRecent(symbol, limit)) {
+                return std::move(*recent);
+            }
+        }
+
+        return readPrices([&](PriceStore& store) { return store.latest(symbol, limit); });
+    }
+
+    std::vector<StockQuote> DatabaseService::getPriceHistorySince(const std::string& symbol,
+        std::chrono::system_clock::time_point since, int limit) {
+        // The newest `limit` quotes, cut at `since`, are exactly the newest `limit` quotes
+        // after it, so this is a getPriceHistory call (cache included) and a trim
+        auto history = getPriceHistory(symbol, limit);
+        auto cutoff = toStoredTimestamp(since);
+        auto stale = std::find_if(history.begin(), history.end(),
+            [&](const StockQuote& quote) { return toStoredTimestamp(quote.timestamp) <= cutoff; });
+        history.erase(stale, history.end());
+        return history;
+    }
+
+    std::vector<StockQuote> DatabaseService::getPriceHistoryRange(const std::string& symbol,
+        std::chrono::system_clock::time_point from,
+        std::chrono::system_clock::time_point to,
+        int limit) {
+        MetricTimer timer(Metric::DbPriceHistoryRange);
+        return readPrices([&](PriceStore& store) { return store.range(symbol, from, to, limit); });
+    }
+
+    PriceHistoryPage DatabaseService::getPriceHistoryPage(const std::string& symbol, int limit,
+        std::optional<HistoryPageKey> after) {
+        MetricTimer timer(Metric::DbPriceHistoryPage);
+        return readPrices([&](PriceStore& store) { return store.page(symbol, limit, after); });
+    }
+
+    void DatabaseService::scanPriceHistory(const std::string& symbol,
+        std::chrono::system_clock::time_point from,
+        std::chrono::system_clock::time_point to,
+        const std::function<void(const StockQuote&)>& visit) {
+        MetricTimer timer(Metric::DbPriceHistoryRange);
+        readPrices([&](PriceStore& store) { store.scan(symbol, from, to, visit); });
+    }
+
+    PriceHistoryCursor DatabaseService::openPriceHistoryCursor(const std::string& symbol,
+        std::chrono::system_clock::time_point from,
+        std::chrono::system_clock::time_point to) {
+        std::lock_guard<std::mutex> lock(dbMutex);
+        return PriceHistoryCursor(prices->openCursor(symbol, from, to), dbMutex);
+    }
+
+    PriceHistoryCursor::PriceHistoryCursor(std::unique_ptr<Source> source, std::mutex& lock)
+        : source(std::move(source))
+        , lock(&lock)
+    {}
+
+    PriceHistoryCursor::PriceHistoryCursor(PriceHistoryCursor&& other) noexcept
+        : source(std::move(other.source))
+        , lock(other.lock)
+        , done(other.done)
+    {}
+
+    PriceHistoryCursor& PriceHistoryCursor::operator=(PriceHistoryCursor&& other) noexcept {
+        if (this != &other) {
+            close();
+            source = std::move(other.source);
+            lock = other.lock;
+            done = other.done;
+        }
+        return *this;
+    }
+
+    PriceHistoryCursor::~PriceHistoryCursor() {
+        close();
+    }
+
+    void PriceHistoryCursor::close() {
+        if (source) {
+            std::lock_guard<std::mutex> guard(*lock);
+            source.reset();
+        }
+    }
+
+    bool PriceHistoryCursor::next(StockQuote& quote) {
+        if (done || !source) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> guard(*lock);
+        try {
+            if (source->next(quote)) {
+                return true;
+            }
+        }
+        catch (...) {
+            done = true;
+            throw;
+        }
+        done = true;
+        return false;
+    }
+
+    void DatabaseService::enableCache(const QuoteCacheOptions& options) {
+        // Seeds each new ring from the store, so older rows must be committed by then
+        waitForWriter();
+        cache = std::make_unique<QuoteCache>(options, [this](const std::string& symbol) -> std::optional<int64_t> {
+            // The key of a one-row page is the newest row's timestamp as stored
+            auto newest = readPrices([&](PriceStore& store) { return store.page(symbol, 1, std::nullopt); });
+            if (!newest.next) {
+                return std::nullopt;
+            }
+            return newest.next->timestamp;
+        });
+    }
 
-        sqlite3_stmt* stmt;
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            throw std::runtime_error("Failed to prepare statement");
+    std::optional<QuoteCacheStats> DatabaseService::cacheStats() const {
+        if (!cache) {
+            return std::nullopt;
         }
+        return cache->stats();
+    }
+
+    void DatabaseService::enableBars(const BarAggregatorOptions& options) {
+        bars = std::make_unique<BarAggregator>(options);
+    }
+
+    std::vector<OhlcvBar> DatabaseService::getBars(const std::string& symbol, const BarQuery& query) {
+        MetricTimer timer(Metric::DbBars);
+        auto isTier = [&](const RetentionTier& tier) { return tier.interval == query.interval; };
+        bool rolledUp = retention && std::any_of(retention->tiers.begin(), retention->tiers.end(), isTier);
+        if (bars && !bars->hasInterval(query.interval) && !rolledUp) {
+            throw std::invalid_argument("Bars are not kept at " + std::to_string(query.interval.count()) + "s");
+        }
+
+        // Held across both reads, so a bar can't move from memory to the table in between
+        std::lock_guard<std::mutex> lock(dbMutex);
+        sqlite3_stmt* stmt = barRangeStmt;
+        SqliteStatementReset reset(stmt);
 
         sqlite3_bind_text(stmt, 1, symbol.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_int(stmt, 2, limit);
+        sqlite3_bind_int64(stmt, 2, query.interval.count());
+        sqlite3_bind_int64(stmt, 3, toBarTime(query.from));
+        sqlite3_bind_int64(stmt, 4, toBarTime(query.to));
+        sqlite3_bind_int(stmt, 5, query.limit);
 
-        std::vector<StockQuote> history;
+        std::vector<BarDelta> rows;
         while (sqlite3_step(stmt) == SQLITE_ROW) {
-            StockQuote quote;
-            quote.symbol = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-            quote.price = sqlite3_column_double(stmt, 1);
-            auto timestamp = sqlite3_column_int64(stmt, 2);
-            quote.timestamp = std::chrono::system_clock::time_point(
-                std::chrono::milliseconds(timestamp));
+            BarDelta& row = rows.emplace_back();
+            row.bar.open_time = fromBarTime(sqlite3_column_int64(stmt, 0));
+            row.bar.interval = query.interval;
+            row.bar.open = sqlite3_column_double(stmt, 1);
+            row.bar.high = sqlite3_column_double(stmt, 2);
+            row.bar.low = sqlite3_column_double(stmt, 3);
+            row.bar.close = sqlite3_column_double(stmt, 4);
+            row.bar.volume = static_cast<uint64_t>(sqlite3_column_int64(stmt, 5));
+            row.first_tick = fromBarTime(sqlite3_column_int64(stmt, 6));
+            row.last_tick = fromBarTime(sqlite3_column_int64(stmt, 7));
+        }
 
-            if (sqlite3_column_type(stmt, 3) != SQLITE_NULL) {
-                quote.change_percent = sqlite3_column_double(stmt, 3);
+        // Rows are the oldest `limit` stored bars, so anything merged in past
+        // the limit is newer than all of them and is cut off again below
+        if (bars) {
+            for (auto& delta : bars->pending(symbol, query.interval, query.from, query.to)) {
+                auto it = std::lower_bound(rows.begin(), rows.end(), delta.bar.open_time,
+                    [](const BarDelta& row, auto time) { return row.bar.open_time < time; });
+                if (it != rows.end() && it->bar.open_time == delta.bar.open_time) {
+                    BarAggregator::merge(*it, delta);
+                }
+                else {
+                    rows.insert(it, std::move(delta));
+                }
             }
-
-            history.push_back(quote);
+        }
+        if (query.limit >= 0 && rows.size() > static_cast<size_t>(query.limit)) {
+            rows.resize(static_cast<size_t>(query.limit));
         }
 
-        sqlite3_finalize(stmt);
-        return history;
+        std::vector<OhlcvBar> result;
+        result.reserve(rows.size());
+        for (const auto& row : rows) {
+            result.push_back(row.bar);
+        }
+        return result;
     }
 
-    void DatabaseService::saveSubscription(const std::string& symbol) {
-        const char* sql = R"(
-        INSERT OR REPLACE INTO subscriptions (symbol, added_at)
-        VALUES (?, ?)
-    )";
+    void DatabaseService::rebuildBars(const std::string& symbol,
+        std::chrono::system_clock::time_point from,
+        std::chrono::system_clock::time_point to) {
+        if (!bars) {
+            throw std::logic_error("Bars are not enabled");
+        }
+        if (to <= from) {
+            return;
+        }
+        flush();
+
+        std::lock_guard<std::mutex> lock(dbMutex);
 
-        sqlite3_stmt* stmt;
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            throw std::runtime_error("Failed to prepare statement");
+        // Prepared per call: rebuilding is rare
+        using Statement = std::unique_ptr<sqlite3_stmt, decltype(&sqlite3_finalize)>;
+        auto prepare = [this](const char* sql) {
+            sqlite3_stmt* stmt;
+            if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+                throw std::runtime_error(std::string("Failed to prepare statement: ") + sqlite3_errmsg(db));
+            }
+            return Statement(stmt, &sqlite3_finalize);
+        };
+        Statement deleteBars = prepare(R"(
+        DELETE FROM price_bars
+        WHERE symbol = ? AND interval_s = ? AND open_time >= ? AND open_time < ?
+    )");
+
+        execute(db, "BEGIN", "Failed to begin transaction");
+        try {
+            // Anything still in memory for the symbol is already in the price store
+            bars->discard(symbol);
+
+            for (auto interval : bars->intervals()) {
+                // Whole bars only: widen the range to the bars it touches
+                auto start = BarAggregator::bucketStart(from, interval);
+                auto end = BarAggregator::bucketStart(to - std::chrono::system_clock::duration(1), interval) + interval;
+
+                sqlite3_stmt* stmt = deleteBars.get();
+                sqlite3_bind_text(stmt, 1, symbol.c_str(), -1, SQLITE_STATIC);
+                sqlite3_bind_int64(stmt, 2, interval.count());
+                sqlite3_bind_int64(stmt, 3, toBarTime(start));
+                sqlite3_bind_int64(stmt, 4, toBarTime(end));
+                if (sqlite3_step(stmt) != SQLITE_DONE) {
+                    throw std::runtime_error("Failed to delete bars");
+                }
+                sqlite3_reset(stmt);
+
+                BarAggregator rebuilt(BarAggregatorOptions{ { interval } });
+                prices->scan(symbol, start, end, [&](const StockQuote& quote) { rebuilt.add(quote); });
+                writeBars(rebuilt.takeAll());
+            }
+            execute(db, "COMMIT", "Failed to commit bars");
         }
+        catch (...) {
+            sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+            throw;
+        }
+    }
+
+    void DatabaseService::saveSubscription(const std::string& symbol) {
+        MetricTimer timer(Metric::DbSubscriptions);
+        std::lock_guard<std::mutex> lock(dbMutex);
+        sqlite3_stmt* stmt = saveSubscriptionStmt;
+        SqliteStatementReset reset(stmt);
 
         auto now = std::chrono::system_clock::now().time_since_epoch().count();
         sqlite3_bind_text(stmt, 1, symbol.c_str(), -1, SQLITE_STATIC);
         sqlite3_bind_int64(stmt, 2, now);
 
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            sqlite3_finalize(stmt);
-            throw std::runtime_error("Failed to save subscription");
+        execute(db, "BEGIN", "Failed to begin transaction");
+        try {
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                throw std::runtime_error("Failed to save subscription");
+            }
+            logSubscriptionChange(symbol, true);
+            execute(db, "COMMIT", "Failed to commit subscription");
+        }
+        catch (...) {
+            sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+            throw;
         }
-
-        sqlite3_finalize(stmt);
     }
 
     void DatabaseService::removeSubscription(const std::string& symbol) {
-        const char* sql = "DELETE FROM subscriptions WHERE symbol = ?";
-
-        sqlite3_stmt* stmt;
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            throw std::runtime_error("Failed to prepare statement");
-        }
+        MetricTimer timer(Metric::DbSubscriptions);
+        std::lock_guard<std::mutex> lock(dbMutex);
+        sqlite3_stmt* stmt = removeSubscriptionStmt;
+        SqliteStatementReset reset(stmt);
 
         sqlite3_bind_text(stmt, 1, symbol.c_str(), -1, SQLITE_STATIC);
 
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            sqlite3_finalize(stmt);
-            throw std::runtime_error("Failed to remove subscription");
+        execute(db, "BEGIN", "Failed to begin transaction");
+        try {
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                throw std::runtime_error("Failed to remove subscription");
+            }
+            // Removing a symbol that wasn't subscribed changes nothing clients need to hear about
+            if (sqlite3_changes(db) > 0) {
+                logSubscriptionChange(symbol, false);
+            }
+            execute(db, "COMMIT", "Failed to commit subscription");
+        }
+        catch (...) {
+            sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+            throw;
+        }
+    }
+
+    // Caller holds dbMutex and has a transaction open
+    void DatabaseService::logSubscriptionChange(const std::string& symbol, bool added) {
+        {
+            SqliteStatementReset reset(logSubscriptionStmt);
+            sqlite3_bind_text(logSubscriptionStmt, 1, symbol.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int(logSubscriptionStmt, 2, added ? 1 : 0);
+            if (sqlite3_step(logSubscriptionStmt) != SQLITE_DONE) {
+                throw std::runtime_error("Failed to log subscription change");
+            }
         }
 
-        sqlite3_finalize(stmt);
+        // Earlier changes of the symbol are superseded; any client that missed them gets this one
+        SqliteStatementReset reset(pruneSubscriptionLogStmt);
+        sqlite3_bind_text(pruneSubscriptionLogStmt, 1, symbol.c_str(), -1, SQLITE_STATIC);
+        if (sqlite3_step(pruneSubscriptionLogStmt) != SQLITE_DONE) {
+            throw std::runtime_error("Failed to prune subscription changes");
+        }
     }
 
     std::vector<std::string> DatabaseService::getSubscriptions() {
-        const char* sql = "SELECT symbol FROM subscriptions ORDER BY symbol";
+        MetricTimer timer(Metric::DbSubscriptions);
+        if (readPoolSize > 0) {
+            ReadLease reader(*this);
+            return readSubscriptions(reader->subscriptionsStmt);
+        }
+        std::lock_guard<std::mutex> lock(dbMutex);
+        return readSubscriptions(subscriptionsStmt);
+    }
 
-        sqlite3_stmt* stmt;
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            throw std::runtime_error("Failed to prepare statement");
+    uint64_t DatabaseService::subscriptionsVersion() {
+        MetricTimer timer(Metric::DbSubscriptions);
+        if (readPoolSize > 0) {
+            ReadLease reader(*this);
+            return readSubscriptionsVersion(reader->subscriptionsVersionStmt);
         }
+        std::lock_guard<std::mutex> lock(dbMutex);
+        return readSubscriptionsVersion(subscriptionsVersionStmt);
+    }
 
-        std::vector<std::string> subscriptions;
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            subscriptions.push_back(
-                reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0))
-            );
+    SubscriptionDelta DatabaseService::getSubscriptionChanges(uint64_t since_version) {
+        MetricTimer timer(Metric::DbSubscriptions);
+        if (readPoolSize > 0) {
+            ReadLease reader(*this);
+            return readSubscriptionChanges(reader->db, reader->subscriptionsVersionStmt,
+                reader->subscriptionChangesStmt, reader->subscriptionsStmt, since_version);
+        }
+        std::lock_guard<std::mutex> lock(dbMutex);
+        return readSubscriptionChanges(db, subscriptionsVersionStmt, subscriptionChangesStmt,
+            subscriptionsStmt, since_version);
+    }
+
+    void DatabaseService::enableReadPool(const ReadPoolOptions& options) {
+        if (options.connections == 0) {
+            throw std::invalid_argument("Read pool needs at least one connection");
+        }
+        if (readPoolSize > 0) {
+            throw std::logic_error("Read pool is already enabled");
+        }
+        // Each connection would open its own empty database
+        if (dbPath.empty() || dbPath == ":memory:" || dbPath.rfind("file::memory:", 0) == 0) {
+            throw std::logic_error("Read pool needs a file database");
+        }
+
+        std::vector<std::unique_ptr<ReadConnection>> readers;
+        for (size_t i = 0; i < options.connections; ++i) {
+            readers.push_back(std::make_unique<ReadConnection>(dbPath, options, pricesInDatabase));
+        }
+
+        std::lock_guard<std::mutex> lock(readPoolMutex);
+        idleReaders = std::move(readers);
+        readPoolSize = options.connections;
+        pooledPrices = pricesInDatabase;
+    }
+
+    void DatabaseService::enableRetention(const RetentionOptions& options) {
+        if (options.raw_ticks.count() <= 0) {
+            throw std::invalid_argument("Raw tick retention must be positive");
+        }
+        if (options.batch_size == 0) {
+            throw std::invalid_argument("Compaction batch size must be non-zero");
+        }
+        for (const auto& tier : options.tiers) {
+            if (tier.interval.count() <= 0 || tier.keep.count() < 0) {
+                throw std::invalid_argument("Retention tiers need a positive interval and a non-negative keep time");
+            }
+        }
+        retention = options;
+    }
+
+    CompactionStats DatabaseService::compact(const std::function<bool(const CompactionStats&)>& progress) {
+        if (!retention) {
+            throw std::logic_error("Retention is not enabled");
+        }
+        const RetentionOptions& options = *retention;
+        auto started = std::chrono::steady_clock::now();
+        auto now = std::chrono::system_clock::now();
+        CompactionStats stats;
+
+        auto report = [&] {
+            ++stats.batches;
+            stats.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+            return !progress || progress(stats);
+        };
+
+        // Tiers the live aggregator keeps already have a bar for every stored tick
+        BarAggregatorOptions rollup{ {} };
+        for (const auto& tier : options.tiers) {
+            if (!bars || !bars->hasInterval(tier.interval)) {
+                rollup.intervals.push_back(tier.interval);
+            }
+        }
+
+        std::vector<std::string> symbols;
+        {
+            std::lock_guard<std::mutex> lock(dbMutex);
+            symbols = prices->symbols();
+        }
+
+        // Raw ticks: each batch is rolled up and deleted in one transaction
+        auto cutoff = now - options.raw_ticks;
+        for (const auto& symbol : symbols) {
+            while (true) {
+                MetricTimer timer(Metric::DbCompactBatch);
+                size_t removed = 0;
+                {
+                    std::lock_guard<std::mutex> lock(dbMutex);
+                    execute(db, "BEGIN", "Failed to begin transaction");
+                    bool committed = false;
+                    try {
+                        removed = prices->trim(symbol, cutoff, options.batch_size, [&](const std::vector<StockQuote>& rows) {
+                            if (!rollup.intervals.empty()) {
+                                BarAggregator aggregator(rollup);
+                                for (const auto& quote : rows) {
+                                    aggregator.add(quote);
+                                }
+                                auto deltas = aggregator.takeAll();
+                                writeBars(deltas);
+                                stats.bars_written += deltas.size();
+                            }
+                            // Any other store deletes the rows once this returns, outside the
+                            // transaction, so their bars must be committed first
+                            if (!pricesInDatabase) {
+                                execute(db, "COMMIT", "Failed to commit compaction");
+                                committed = true;
+                            }
+                        });
+                        if (!committed) {
+                            execute(db, "COMMIT", "Failed to commit compaction");
+                        }
+                    }
+                    catch (...) {
+                        if (!committed) {
+                            sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+                        }
+                        throw;
+                    }
+                }
+                if (removed == 0) {
+                    timer.cancel();
+                    break;
+                }
+
+                stats.ticks_removed += removed;
+                if (cache) {
+                    cache->expire(symbol, cutoff);
+                }
+                if (!report()) {
+                    return stats;
+                }
+            }
+            ++stats.symbols;
+        }
+
+        // Bars past their tier's keep time, per symbol so each delete walks the primary key
+        bool expiring = std::any_of(options.tiers.begin(), options.tiers.end(),
+            [](const RetentionTier& tier) { return tier.keep.count() > 0; });
+        if (expiring) {
+            using Statement = std::unique_ptr<sqlite3_stmt, decltype(&sqlite3_finalize)>;
+            std::vector<std::string> barSymbols;
+            Statement deleteBars(nullptr, &sqlite3_finalize);
+            {
+                std::lock_guard<std::mutex> lock(dbMutex);
+                barSymbols = distinctSymbols(db, "price_bars");
+
+                // Prepared per call: compaction is rare
+                sqlite3_stmt* stmt;
+                if (sqlite3_prepare_v2(db, R"(
+        DELETE FROM price_bars
+        WHERE symbol = ?1 AND interval_s = ?2 AND open_time IN (
+            SELECT open_time FROM price_bars
+            WHERE symbol = ?1 AND interval_s = ?2 AND open_time < ?3
+            ORDER BY open_time
+            LIMIT ?4)
+    )", -1, &stmt, nullptr) != SQLITE_OK) {
+                    throw std::runtime_error(std::string("Failed to prepare statement: ") + sqlite3_errmsg(db));
+                }
+                deleteBars.reset(stmt);
+            }
+
+            for (const auto& tier : options.tiers) {
+                if (tier.keep.count() == 0) {
+                    continue;
+                }
+                int64_t barCutoff = toBarTime(now - tier.keep);
+                for (const auto& symbol : barSymbols) {
+                    while (true) {
+                        MetricTimer timer(Metric::DbCompactBatch);
+                        size_t removed;
+                        {
+                            std::lock_guard<std::mutex> lock(dbMutex);
+                            sqlite3_stmt* stmt = deleteBars.get();
+                            SqliteStatementReset reset(stmt);
+                            sqlite3_bind_text(stmt, 1, symbol.c_str(), -1, SQLITE_STATIC);
+                            sqlite3_bind_int64(stmt, 2, tier.interval.count());
+                            sqlite3_bind_int64(stmt, 3, barCutoff);
+                            sqlite3_bind_int64(stmt, 4, static_cast<int64_t>(options.batch_size));
+                            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                                throw std::runtime_error("Failed to delete bars");
+                            }
+                            removed = static_cast<size_t>(sqlite3_changes(db));
+                        }
+                        if (removed == 0) {
+                            timer.cancel();
+                            break;
+                        }
+
+                        stats.bars_removed += removed;
+                        if (!report()) {
+                            return stats;
+                        }
+                        if (removed < options.batch_size) {
+                            break;
+                        }
+                    }
+                }
+            }
         }
 
-        sqlite3_finalize(stmt);
-        return subscriptions;
+        stats.complete = true;
+        stats.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+        return stats;
     }
 
 } // namespace StockTracker
\ No newline at end of file
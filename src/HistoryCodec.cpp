@@ -0,0 +1,372 @@
+#include "StockTracker/HistoryCodec.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace StockTracker {
+
+    namespace {
+
+        // Timestamp delta-of-delta buckets: prefix bits, then the zigzag value in `bits`
+        struct DodBucket {
+            uint64_t prefix;
+            int prefixBits;
+            int bits;
+        };
+
+        constexpr DodBucket DOD_BUCKETS[] = {
+            { 0b10, 2, 7 },
+            { 0b110, 3, 12 },
+            { 0b1110, 4, 20 },
+            { 0b1111, 4, 64 },
+        };
+
+        uint64_t zigzag(uint64_t value) {
+            return (value << 1) ^ (0 - (value >> 63));
+        }
+
+        uint64_t unzigzag(uint64_t value) {
+            return (value >> 1) ^ (0 - (value & 1));
+        }
+
+        uint64_t doubleBits(double value) {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return bits;
+        }
+
+        double fromBits(uint64_t bits) {
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        // Both require value != 0
+        int leadingZeros(uint64_t value) {
+            int n = 0;
+            for (uint64_t bit = uint64_t(1) << 63; !(value & bit); bit >>= 1) {
+                ++n;
+            }
+            return n;
+        }
+
+        int trailingZeros(uint64_t value) {
+            int n = 0;
+            for (uint64_t bit = 1; !(value & bit); bit <<= 1) {
+                ++n;
+            }
+            return n;
+        }
+
+        class BitWriter {
+        public:
+            explicit BitWriter(std::string& out) : out(out) {}
+
+            // Low `bits` bits of `value`, most significant first
+            void write(uint64_t value, int bits) {
+                while (bits > 0) {
+                    if (used == 0) {
+                        out.push_back(0);
+                    }
+                    int take = std::min(8 - used, bits);
+                    auto chunk = static_cast<uint8_t>((value >> (bits - take)) & ((1u << take) - 1));
+                    out.back() = static_cast<char>(static_cast<uint8_t>(out.back()) | (chunk << (8 - used - take)));
+                    used = (used + take) % 8;
+                    bits -= take;
+                }
+            }
+
+        private:
+            std::string& out;
+            int used{ 0 };  // Bits filled in the last byte of `out`
+        };
+
+        class BitReader {
+        public:
+            BitReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+            uint64_t read(int bits) {
+                uint64_t value = 0;
+                while (bits > 0) {
+                    if (pos >= size) {
+                        throw std::runtime_error("Malformed history block: truncated");
+                    }
+                    int take = std::min(8 - used, bits);
+                    uint64_t chunk = (data[pos] >> (8 - used - take)) & ((1u << take) - 1);
+                    value = (value << take) | chunk;
+                    used += take;
+                    bits -= take;
+                    if (used == 8) {
+                        used = 0;
+                        ++pos;
+                    }
+                }
+                return value;
+            }
+
+            bool bit() { return read(1) != 0; }
+
+            size_t bitsLeft() const { return (size - pos) * 8 - static_cast<size_t>(used); }
+
+        private:
+            const uint8_t* data;
+            size_t size;
+            size_t pos{ 0 };
+            int used{ 0 };  // Bits consumed from data[pos]
+        };
+
+        // Gorilla XOR stream for one column of doubles
+        class XorEncoder {
+        public:
+            void write(BitWriter& out, double value) {
+                uint64_t bits = doubleBits(value);
+                if (first) {
+                    out.write(bits, 64);
+                    first = false;
+                }
+                else {
+                    uint64_t x = bits ^ previous;
+                    if (x == 0) {
+                        out.write(0, 1);
+                    }
+                    else {
+                        int leading = std::min(leadingZeros(x), 31);
+                        int trailing = trailingZeros(x);
+                        if (window && leading >= windowLeading && trailing >= windowTrailing) {
+                            // Fits the previous window: only the meaningful bits
+                            out.write(0b10, 2);
+                            out.write(x >> windowTrailing, 64 - windowLeading - windowTrailing);
+                        }
+                        else {
+                            int significant = 64 - leading - trailing;
+                            out.write(0b11, 2);
+                            out.write(static_cast<uint64_t>(leading), 5);
+                            out.write(static_cast<uint64_t>(significant - 1), 6);
+                            out.write(x >> trailing, significant);
+                            window = true;
+                            windowLeading = leading;
+                            windowTrailing = trailing;
+                        }
+                    }
+                }
+                previous = bits;
+            }
+
+        private:
+            bool first{ true };
+            uint64_t previous{ 0 };
+            bool window{ false };
+            int windowLeading{ 0 };
+            int windowTrailing{ 0 };
+        };
+
+        class XorDecoder {
+        public:
+            double read(BitReader& in) {
+                if (first) {
+                    previous = in.read(64);
+                    first = false;
+                }
+                else if (in.bit()) {
+                    if (in.bit()) {
+                        windowLeading = static_cast<int>(in.read(5));
+                        int significant = static_cast<int>(in.read(6)) + 1;
+                        windowTrailing = 64 - windowLeading - significant;
+                        if (windowTrailing < 0) {
+                            throw std::runtime_error("Malformed history block: bad XOR window");
+                        }
+                        window = true;
+                    }
+                    else if (!window) {
+                        throw std::runtime_error("Malformed history block: XOR window missing");
+                    }
+                    previous ^= in.read(64 - windowLeading - windowTrailing) << windowTrailing;
+                }
+                return fromBits(previous);
+            }
+
+        private:
+            bool first{ true };
+            uint64_t previous{ 0 };
+            bool window{ false };
+            int windowLeading{ 0 };
+            int windowTrailing{ 0 };
+        };
+
+        void putVarint(std::string& out, uint64_t value) {
+            while (value >= 0x80) {
+                out.push_back(static_cast<char>(value | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<char>(value));
+        }
+
+        void putString(std::string& out, const std::string& value) {
+            putVarint(out, value.size());
+            out.append(value);
+        }
+
+        uint64_t getVarint(const uint8_t*& pos, const uint8_t* end) {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                if (pos == end) {
+                    throw std::runtime_error("Malformed history block: truncated");
+                }
+                uint8_t b = *pos++;
+                value |= static_cast<uint64_t>(b & 0x7F) << shift;
+                if ((b & 0x80) == 0) {
+                    return value;
+                }
+            }
+            throw std::runtime_error("Malformed history block: varint too long");
+        }
+
+        void getString(const uint8_t*& pos, const uint8_t* end, std::string& out) {
+            auto len = getVarint(pos, end);
+            if (len > static_cast<uint64_t>(end - pos)) {
+                throw std::runtime_error("Malformed history block: truncated");
+            }
+            out.assign(reinterpret_cast<const char*>(pos), static_cast<size_t>(len));
+            pos += len;
+        }
+    }
+
+    bool canEncodeHistory(const std::vector<StockQuote>& history) {
+        for (const auto& quote : history) {
+            if (quote.indicators || quote.symbol != history.front().symbol
+                || quote.currency != history.front().currency) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void encodeHistory(std::string& out, const std::vector<StockQuote>& history) {
+        if (!canEncodeHistory(history)) {
+            throw std::invalid_argument("History rows must share symbol and currency and have no indicators");
+        }
+
+        putVarint(out, history.size());
+        if (history.empty()) {
+            return;
+        }
+        putString(out, history.front().symbol);
+        putString(out, history.front().currency);
+
+        BitWriter bits(out);
+
+        // Unsigned arithmetic, so extreme timestamps wrap instead of overflowing
+        uint64_t previous = 0;
+        uint64_t previousDelta = 0;
+        for (size_t i = 0; i < history.size(); ++i) {
+            auto timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                history[i].timestamp.time_since_epoch()).count());
+            if (i == 0) {
+                bits.write(timestamp, 64);
+            }
+            else {
+                uint64_t delta = timestamp - previous;
+                uint64_t dod = zigzag(delta - previousDelta);
+                if (dod == 0) {
+                    bits.write(0, 1);
+                }
+                else {
+                    for (const auto& bucket : DOD_BUCKETS) {
+                        if (bucket.bits == 64 || dod < (uint64_t(1) << bucket.bits)) {
+                            bits.write(bucket.prefix, bucket.prefixBits);
+                            bits.write(dod, bucket.bits);
+                            break;
+                        }
+                    }
+                }
+                previousDelta = delta;
+            }
+            previous = timestamp;
+        }
+
+        XorEncoder prices;
+        for (const auto& quote : history) {
+            prices.write(bits, quote.price);
+        }
+
+        XorEncoder changes;
+        for (const auto& quote : history) {
+            bits.write(quote.change_percent ? 1 : 0, 1);
+            if (quote.change_percent) {
+                changes.write(bits, *quote.change_percent);
+            }
+        }
+    }
+
+    void decodeHistory(const void* data, size_t size, std::vector<StockQuote>& history) {
+        auto pos = static_cast<const uint8_t*>(data);
+        auto end = pos + size;
+
+        auto count = getVarint(pos, end);
+        if (count == 0) {
+            history.clear();
+            return;
+        }
+
+        std::string symbol;
+        std::string currency;
+        getString(pos, end, symbol);
+        getString(pos, end, currency);
+
+        BitReader bits(pos, static_cast<size_t>(end - pos));
+        // Every row after the first takes at least three bits, so a corrupt count can't
+        // trigger a huge resize
+        if (count - 1 > bits.bitsLeft() / 3) {
+            throw std::runtime_error("Malformed history block: bad row count");
+        }
+        history.resize(static_cast<size_t>(count));
+
+        uint64_t previous = 0;
+        uint64_t previousDelta = 0;
+        for (size_t i = 0; i < history.size(); ++i) {
+            uint64_t timestamp;
+            if (i == 0) {
+                timestamp = bits.read(64);
+            }
+            else {
+                uint64_t dod = 0;
+                if (bits.bit()) {
+                    // The prefixes are unary: count further one bits, up to the last bucket
+                    size_t bucket = 0;
+                    while (bucket + 1 < std::size(DOD_BUCKETS) && bits.bit()) {
+                        ++bucket;
+                    }
+                    dod = bits.read(DOD_BUCKETS[bucket].bits);
+                }
+                uint64_t delta = previousDelta + unzigzag(dod);
+                timestamp = previous + delta;
+                previousDelta = delta;
+            }
+            previous = timestamp;
+
+            auto& quote = history[i];
+            quote.symbol = symbol;
+            quote.currency = currency;
+            quote.indicators = std::nullopt;
+            // Milliseconds, like from_json and from_binary
+            quote.timestamp = std::chrono::system_clock::time_point(
+                std::chrono::milliseconds(static_cast<int64_t>(timestamp)));
+        }
+
+        XorDecoder prices;
+        for (auto& quote : history) {
+            quote.price = prices.read(bits);
+        }
+
+        XorDecoder changes;
+        for (auto& quote : history) {
+            if (bits.bit()) {
+                quote.change_percent = changes.read(bits);
+            }
+            else {
+                quote.change_percent = std::nullopt;
+            }
+        }
+    }
+}
@@ -0,0 +1,134 @@
+#include "StockTracker/Indicators.h"
+#include "StockTracker/Messages.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace StockTracker {
+
+    namespace {
+        int64_t utcDay(std::chrono::system_clock::time_point time) {
+            using days = std::chrono::duration<int64_t, std::ratio<86400>>;
+            return std::chrono::floor<days>(time.time_since_epoch()).count();
+        }
+    }
+
+    void IndicatorEngine::RollingWindow::push(double value) {
+        if (count == values.size()) {
+            double old = values[next];
+            sum -= old;
+            sumSquares -= old * old;
+        }
+        else {
+            ++count;
+        }
+        values[next] = value;
+        sum += value;
+        sumSquares += value * value;
+
+        next = (next + 1) % values.size();
+        if (next == 0) {
+            sum = 0.0;
+            sumSquares = 0.0;
+            for (double v : values) {
+                sum += v;
+                sumSquares += v * v;
+            }
+        }
+    }
+
+    double IndicatorEngine::RollingWindow::sampleStdDev() const {
+        double n = static_cast<double>(count);
+        double variance = (sumSquares - sum * sum / n) / (n - 1.0);
+        return std::sqrt(std::max(variance, 0.0));
+    }
+
+    IndicatorEngine::IndicatorEngine(const IndicatorOptions& options)
+        : options(options)
+        , emaAlpha(2.0 / (static_cast<double>(options.ema_period) + 1.0))
+    {
+        if (options.sma_window == 0 || options.ema_period == 0 || options.volatility_window < 2) {
+            throw std::invalid_argument("Indicator windows must be non-zero (volatility needs at least 2)");
+        }
+    }
+
+    IndicatorEngine::SymbolState& IndicatorEngine::state(const std::string& symbol) {
+        auto it = symbols.find(symbol);
+        if (it == symbols.end()) {
+            it = symbols.emplace(symbol, SymbolState{}).first;
+            it->second.prices.values.resize(options.sma_window);
+            it->second.returns.values.resize(options.volatility_window);
+        }
+        return it->second;
+    }
+
+    void IndicatorEngine::update(SymbolState& s, const StockQuote& quote) {
+        int64_t day = utcDay(quote.timestamp);
+        if (!s.started || day != s.day) {
+            if (s.started) {
+                s.previousClose = s.lastPrice;
+            }
+            s.day = day;
+            s.sessionSum = 0.0;
+            s.sessionTicks = 0;
+        }
+
+        if (s.started && s.lastPrice > 0.0 && quote.price > 0.0) {
+            s.returns.push(std::log(quote.price / s.lastPrice));
+        }
+        s.prices.push(quote.price);
+        s.ema = s.ema ? *s.ema + emaAlpha * (quote.price - *s.ema) : quote.price;
+        s.sessionSum += quote.price;
+        ++s.sessionTicks;
+
+        s.started = true;
+        s.lastPrice = quote.price;
+        s.lastTimestamp = quote.timestamp;
+
+        // The SMA waits for a full window; the EMA is usable from the first tick
+        s.current.sma = s.prices.count == s.prices.values.size() ? std::optional<double>(s.prices.mean()) : std::nullopt;
+        s.current.ema = s.ema;
+        s.current.vwap = s.sessionSum / static_cast<double>(s.sessionTicks);
+        s.current.volatility = s.returns.count >= 2 ? std::optional<double>(s.returns.sampleStdDev()) : std::nullopt;
+    }
+
+    void IndicatorEngine::apply(StockQuote& quote) {
+        std::lock_guard<std::mutex> lock(mutex);
+        SymbolState& s = state(quote.symbol);
+
+        if (!s.started || quote.timestamp >= s.lastTimestamp) {
+            update(s, quote);
+        }
+
+        quote.indicators = s.current;
+        if (!quote.change_percent && s.previousClose && *s.previousClose != 0.0) {
+            quote.change_percent = (quote.price - *s.previousClose) / *s.previousClose * 100.0;
+        }
+    }
+
+    void IndicatorEngine::apply(Message& msg) {
+        if (msg.quote) {
+            apply(*msg.quote);
+        }
+        if (msg.quotes) {
+            for (auto& quote : *msg.quotes) {
+                apply(quote);
+            }
+        }
+    }
+
+    void IndicatorEngine::setPreviousClose(const std::string& symbol, double close) {
+        std::lock_guard<std::mutex> lock(mutex);
+        state(symbol).previousClose = close;
+    }
+
+    void IndicatorEngine::reset(const std::string& symbol) {
+        std::lock_guard<std::mutex> lock(mutex);
+        symbols.erase(symbol);
+    }
+
+    void IndicatorEngine::clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        symbols.clear();
+    }
+}
\ No newline at end of file
@@ -1,4 +1,7 @@
 #include "StockTracker/Messages.h"
+#include "StockTracker/BinaryCodec.h"
+#include "StockTracker/HistoryCodec.h"
+#include <cstring>
 
 namespace StockTracker {
     // Message factory methods
@@ -18,6 +21,12 @@ namespace StockTracker {
         };
     }
 
+    Message Message::makeQuoteBatch(std::vector<StockQuote> quotes) {
+        Message msg{ MessageType::QuoteBatch };
+        msg.quotes = std::move(quotes);
+        return msg;
+    }
+
     Message Message::makeQuery(std::string symbol) {
         return Message{
             MessageType::Query,
@@ -25,18 +34,25 @@ namespace StockTracker {
         };
     }
 
-    Message Message::makeRequestPriceHistory(const std::string& symbol) {
-        return Message{ MessageType::PriceHistoryRequest, symbol };
+    Message Message::makeRequestPriceHistory(const std::string& symbol, HistoryEncoding accept,
+        std::optional<std::chrono::system_clock::time_point> since) {
+        Message msg{ MessageType::PriceHistoryRequest, symbol };
+        msg.historyEncoding = accept;
+        msg.since = since;
+        return msg;
     }
 
     // Create a message to request the subscription list from the backend
-    Message Message::makeRequestSubscriptions() {
-        return Message{ MessageType::RequestSubscriptions };
+    Message Message::makeRequestSubscriptions(std::optional<uint64_t> since_version) {
+        Message msg{ MessageType::RequestSubscriptions };
+        msg.subscriptionsVersion = since_version;
+        return msg;
     }
 
     // Create a message to send the subscription list to the frontend (CLI)
-    Message Message::makeSubscriptionsList(const std::vector<std::string>& subscriptions) {
-        return Message{
+    Message Message::makeSubscriptionsList(const std::vector<std::string>& subscriptions,
+        std::optional<uint64_t> version) {
+        Message msg{
             MessageType::SubscriptionsList,
             "",  // No specific symbol for this message
             std::nullopt,   // No quote
@@ -44,16 +60,35 @@ namespace StockTracker {
             std::nullopt,   // No priceHistory
             subscriptions   // Subscription list
         };
+        msg.subscriptionsVersion = version;
+        return msg;
     }
 
-    Message Message::makePriceHistory(const std::string& symbol, const std::vector<StockQuote>& history) {
-        return Message{
+    Message Message::makeSubscriptionsDelta(const SubscriptionDelta& delta) {
+        if (delta.full) {
+            return makeSubscriptionsList(delta.added, delta.version);
+        }
+        Message msg{ MessageType::SubscriptionsDelta };
+        msg.subscriptions = delta.added;
+        msg.removedSubscriptions = delta.removed;
+        msg.subscriptionsVersion = delta.version;
+        return msg;
+    }
+
+    Message Message::makePriceHistory(const std::string& symbol, const std::vector<StockQuote>& history,
+        HistoryEncoding encoding, std::optional<std::chrono::system_clock::time_point> since) {
+        Message msg{
             MessageType::PriceHistoryResponse,  // Use appropriate message type
             symbol,
             std::nullopt,  // No quote
             std::nullopt,  // No error
             history        // Price history
         };
+        if (encoding == HistoryEncoding::Columnar && canEncodeHistory(history)) {
+            msg.historyEncoding = encoding;
+        }
+        msg.since = since;
+        return msg;
     }
 
     Message Message::makeSetCurrency(std::string currency_code) {
@@ -77,6 +112,79 @@ namespace StockTracker {
         };
     }
 
+    Message Message::makeStats(MetricsSnapshot snapshot) {
+        Message msg{ MessageType::Stats };
+        msg.stats = std::move(snapshot);
+        return msg;
+    }
+
+    Message Message::makeRequestBars(const std::string& symbol, const BarQuery& query) {
+        Message msg{ MessageType::BarHistoryRequest, symbol };
+        msg.barQuery = query;
+        return msg;
+    }
+
+    Message Message::makeBarHistory(const std::string& symbol, std::vector<OhlcvBar> bars) {
+        Message msg{ MessageType::BarHistoryResponse, symbol };
+        msg.bars = std::move(bars);
+        return msg;
+    }
+
+    namespace {
+        const char BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        // Packed histories travel in JSON as standard, padded base64
+        std::string toBase64(const std::string& data) {
+            std::string out;
+            out.reserve((data.size() + 2) / 3 * 4);
+            size_t i = 0;
+            for (; i + 2 < data.size(); i += 3) {
+                uint32_t n = (uint32_t(uint8_t(data[i])) << 16) | (uint32_t(uint8_t(data[i + 1])) << 8) | uint8_t(data[i + 2]);
+                for (int shift : { 18, 12, 6, 0 }) {
+                    out += BASE64_ALPHABET[(n >> shift) & 0x3F];
+                }
+            }
+            if (i < data.size()) {
+                uint32_t n = uint32_t(uint8_t(data[i])) << 16;
+                if (i + 1 < data.size()) {
+                    n |= uint32_t(uint8_t(data[i + 1])) << 8;
+                }
+                out += BASE64_ALPHABET[(n >> 18) & 0x3F];
+                out += BASE64_ALPHABET[(n >> 12) & 0x3F];
+                out += i + 1 < data.size() ? BASE64_ALPHABET[(n >> 6) & 0x3F] : '=';
+                out += '=';
+            }
+            return out;
+        }
+
+        std::string fromBase64(const std::string& text) {
+            if (text.size() % 4 != 0) {
+                throw std::runtime_error("Malformed base64: bad length");
+            }
+            std::string out;
+            out.reserve(text.size() / 4 * 3);
+            for (size_t i = 0; i < text.size(); i += 4) {
+                uint32_t n = 0;
+                int padding = 0;
+                for (size_t k = 0; k < 4; ++k) {
+                    char c = text[i + k];
+                    const char* digit = c ? std::strchr(BASE64_ALPHABET, c) : nullptr;
+                    if (c == '=' && i + 4 == text.size() && k >= 2) {
+                        ++padding;
+                    }
+                    else if (!digit || padding > 0) {
+                        throw std::runtime_error("Malformed base64: bad character");
+                    }
+                    n = (n << 6) | (digit ? static_cast<uint32_t>(digit - BASE64_ALPHABET) : 0);
+                }
+                out += static_cast<char>(n >> 16);
+                if (padding < 2) out += static_cast<char>((n >> 8) & 0xFF);
+                if (padding < 1) out += static_cast<char>(n & 0xFF);
+            }
+            return out;
+        }
+    }
+
     // JSON serialization
     void to_json(json& j, const Message& msg) {
         j = json{
@@ -93,11 +201,46 @@ namespace StockTracker {
         if (msg.subscriptions) {
             j["subscriptions"] = *msg.subscriptions;
         }
+        if (msg.historyEncoding != HistoryEncoding::Rows) {
+            j["historyEncoding"] = msg.historyEncoding;
+        }
         if (msg.priceHistory) {
-            j["priceHistory"] = *msg.priceHistory;
+            if (msg.historyEncoding == HistoryEncoding::Columnar) {
+                std::string block;
+                encodeHistory(block, *msg.priceHistory);
+                j["packedHistory"] = toBase64(block);
+            }
+            else {
+                j["priceHistory"] = *msg.priceHistory;
+            }
+        }
+        if (msg.quotes) {
+            j["quotes"] = *msg.quotes;
+        }
+        if (msg.stats) {
+            j["stats"] = *msg.stats;
+        }
+        if (msg.barQuery) {
+            j["barQuery"] = *msg.barQuery;
+        }
+        if (msg.bars) {
+            j["bars"] = *msg.bars;
+        }
+        if (msg.sentAt) {
+            j["sentAt"] = *msg.sentAt;
+        }
+        if (msg.since) {
+            j["since"] = std::chrono::duration_cast<std::chrono::milliseconds>(msg.since->time_since_epoch()).count();
+        }
+        if (msg.subscriptionsVersion) {
+            j["subscriptionsVersion"] = *msg.subscriptionsVersion;
+        }
+        if (msg.removedSubscriptions) {
+            j["removedSubscriptions"] = *msg.removedSubscriptions;
         }
     }
 
+    // Absent fields are reset, so `msg` may be a reused Message
     void from_json(const json& j, Message& msg) {
         j.at("type").get_to(msg.type);
         j.at("symbol").get_to(msg.symbol);
@@ -107,21 +250,116 @@ namespace StockTracker {
         if (j.contains("quote") && !j["quote"].is_null()) {
             msg.quote = j.at("quote").get<StockQuote>();
         }
+        else {
+            msg.quote.reset();
+        }
         if (j.contains("error") && !j["error"].is_null()) {
             msg.error = j.at("error").get<std::string>();
         }
+        else {
+            msg.error.reset();
+        }
         if (j.contains("subscriptions") && !j["subscriptions"].is_null()) {
             msg.subscriptions = j.at("subscriptions").get<std::vector<std::string>>();
         }
-        if (j.contains("priceHistory") && !j["priceHistory"].is_null()) {
+        else {
+            msg.subscriptions.reset();
+        }
+        if (j.contains("historyEncoding") && !j["historyEncoding"].is_null()) {
+            j.at("historyEncoding").get_to(msg.historyEncoding);
+        }
+        else {
+            msg.historyEncoding = HistoryEncoding::Rows;
+        }
+        if (j.contains("packedHistory") && !j["packedHistory"].is_null()) {
+            std::string block = fromBase64(j.at("packedHistory").get<std::string>());
+            decodeHistory(block.data(), block.size(), msg.priceHistory ? *msg.priceHistory : msg.priceHistory.emplace());
+        }
+        else if (j.contains("priceHistory") && !j["priceHistory"].is_null()) {
             msg.priceHistory = j.at("priceHistory").get<std::vector<StockQuote>>();
         }
+        else {
+            msg.priceHistory.reset();
+        }
+        if (j.contains("quotes") && !j["quotes"].is_null()) {
+            msg.quotes = j.at("quotes").get<std::vector<StockQuote>>();
+        }
+        else {
+            msg.quotes.reset();
+        }
+        if (j.contains("stats") && !j["stats"].is_null()) {
+            msg.stats = j.at("stats").get<MetricsSnapshot>();
+        }
+        else {
+            msg.stats.reset();
+        }
+        if (j.contains("barQuery") && !j["barQuery"].is_null()) {
+            msg.barQuery = j.at("barQuery").get<BarQuery>();
+        }
+        else {
+            msg.barQuery.reset();
+        }
+        if (j.contains("bars") && !j["bars"].is_null()) {
+            msg.bars = j.at("bars").get<std::vector<OhlcvBar>>();
+        }
+        else {
+            msg.bars.reset();
+        }
+        if (j.contains("sentAt") && !j["sentAt"].is_null()) {
+            msg.sentAt = j.at("sentAt").get<int64_t>();
+        }
+        else {
+            msg.sentAt.reset();
+        }
+        if (j.contains("since") && !j["since"].is_null()) {
+            msg.since = std::chrono::system_clock::time_point(std::chrono::milliseconds(j.at("since").get<int64_t>()));
+        }
+        else {
+            msg.since.reset();
+        }
+        if (j.contains("subscriptionsVersion") && !j["subscriptionsVersion"].is_null()) {
+            msg.subscriptionsVersion = j.at("subscriptionsVersion").get<uint64_t>();
+        }
+        else {
+            msg.subscriptionsVersion.reset();
+        }
+        if (j.contains("removedSubscriptions") && !j["removedSubscriptions"].is_null()) {
+            msg.removedSubscriptions = j.at("removedSubscriptions").get<std::vector<std::string>>();
+        }
+        else {
+            msg.removedSubscriptions.reset();
+        }
     }
 
     // MessageSocket implementation
-    MessageSocket::MessageSocket(zmq::socket_type type)
-        : context(std::make_unique<zmq::context_t>(1))
-        , socket(std::make_unique<zmq::socket_t>(*context, type))
+
+    // Serializes into whichever string `target` points at, appending, so the socket's send
+    // buffer keeps its capacity (json::dump() returns a new string every time)
+    struct MessageSocket::JsonWriter {
+        class Sink : public nlohmann::detail::output_adapter_protocol<char> {
+        public:
+            std::string* target{ nullptr };
+
+            void write_character(char c) override {
+                target->push_back(c);
+            }
+            void write_characters(const char* s, std::size_t length) override {
+                target->append(s, length);
+            }
+        };
+
+        std::shared_ptr<Sink> sink = std::make_shared<Sink>();
+        nlohmann::detail::serializer<json> serializer{ sink, ' ' };
+
+        void write(const json& j, std::string& target) {
+            sink->target = &target;
+            serializer.dump(j, false, false, 0);
+        }
+    };
+
+    MessageSocket::MessageSocket(zmq::socket_type type, std::shared_ptr<zmq::context_t> context)
+        : context(std::move(context))
+        , socket(std::make_unique<zmq::socket_t>(*this->context, type))
     {}
 
     void MessageSocket::bind(const std::string& endpoint) {
@@ -134,29 +372,155 @@ namespace StockTracker {
         //spdlog::info("Socket connected to {}", endpoint);
     }
 
+    void MessageSocket::setTopicFraming(bool enabled) {
+        if (enabled && maxBatchQuotes > 0) {
+            throw std::logic_error("Topic framing and quote batching can't be combined");
+        }
+        topicFraming = enabled;
+    }
+
+    void MessageSocket::enableQuoteBatching(size_t max_quotes, std::chrono::milliseconds max_delay) {
+        if (topicFraming) {
+            throw std::logic_error("Topic framing and quote batching can't be combined");
+        }
+        flushQuoteBatch();
+        maxBatchQuotes = max_quotes;
+        maxBatchDelay = max_delay;
+        pendingQuotes.reserve(max_quotes);
+    }
+
+    void MessageSocket::flushQuoteBatch() {
+        sendQuoteBatch(zmq::send_flags::none);
+    }
+
+    bool MessageSocket::sendQuoteBatch(zmq::send_flags flags) {
+        if (pendingQuotes.empty()) {
+            return true;
+        }
+
+        Message batch = Message::makeQuoteBatch(std::move(pendingQuotes));
+        batch.sentAt = batchSentAt;     // The oldest quote's, so latency covers the wait in the batch
+        bool sent = sendFrames(batch, flags);
+
+        // Take the vector back so the next batch reuses its capacity
+        pendingQuotes = std::move(*batch.quotes);
+        if (sent) {
+            pendingQuotes.clear();
+        }
+        return sent;
+    }
+
     void MessageSocket::send(const Message& msg) {
-        json j;
-        to_json(j, msg);
-        std::string serialized = j.dump();
-        socket->send(zmq::buffer(serialized), zmq::send_flags::none);
+        if (maxBatchQuotes > 0) {
+            if (msg.type == MessageType::QuoteUpdate && msg.quote) {
+                if (pendingQuotes.empty()) {
+                    batchStartedAt = std::chrono::steady_clock::now();
+                    batchSentAt = msg.sentAt;
+                }
+                pendingQuotes.push_back(*msg.quote);
+
+                if (pendingQuotes.size() >= maxBatchQuotes ||
+                    std::chrono::steady_clock::now() - batchStartedAt >= maxBatchDelay) {
+                    flushQuoteBatch();
+                }
+                return;
+            }
+            flushQuoteBatch();
+        }
+
+        sendFrames(msg, zmq::send_flags::none);
+    }
+
+    bool MessageSocket::trySend(const Message& msg) {
+        // Batched quotes were handed over first, so they must not be overtaken
+        if (!sendQuoteBatch(zmq::send_flags::dontwait)) {
+            return false;
+        }
+        return sendFrames(msg, zmq::send_flags::dontwait);
+    }
+
+    bool MessageSocket::sendFrames(const Message& msg, zmq::send_flags flags) {
+        MetricTimer timer(Metric::SocketSend, msg.type);
+        sendBuffer.clear();
+        if (wireFormat == WireFormat::Binary) {
+            to_binary(sendBuffer, msg);
+        }
+        else {
+            json j;
+            to_json(j, msg);
+            if (!jsonWriter) {
+                jsonWriter = std::make_shared<JsonWriter>();
+            }
+            jsonWriter->write(j, sendBuffer);
+        }
+
+        if (topicFraming) {
+            if (msg.type == MessageType::QuoteUpdate) {
+                topicBuffer.assign(msg.symbol);
+                topicBuffer.push_back('\0');
+            }
+            else {
+                topicBuffer.assign(CONTROL_TOPIC);
+            }
+            if (!socket->send(zmq::buffer(topicBuffer), zmq::send_flags::sndmore | flags)) {
+                timer.cancel();
+                return false;
+            }
+            // Once the first part is accepted the rest of the multipart is too
+            flags = zmq::send_flags::none;
+        }
+        timer.setBytes(sendBuffer.size());
+        if (!socket->send(zmq::buffer(sendBuffer), flags)) {
+            timer.cancel();
+            return false;
+        }
+        return true;
     }
 
     std::optional<Message> MessageSocket::receive(bool nonBlocking) {
-        zmq::message_t zmq_msg;
+        Message msg;
+        if (receive(msg, nonBlocking)) {
+            return msg;
+        }
+        return std::nullopt;
+    }
+
+    bool MessageSocket::receive(Message& msg, bool nonBlocking) {
         auto flags = nonBlocking ? zmq::recv_flags::dontwait : zmq::recv_flags::none;
 
-        if (socket->recv(zmq_msg, flags)) {
-            std::string serialized(static_cast<char*>(zmq_msg.data()), zmq_msg.size());
+        if (socket->recv(receiveFrame, flags)) {
+            MetricTimer timer(Metric::SocketReceive);
+            if (receiveFrame.more()) {
+                // Topic-framed: the payload follows the topic frame (multipart arrives atomically)
+                socket->recv(receiveFrame, zmq::recv_flags::none);
+                if (receiveFrame.more()) {
+                    spdlog::error("Failed to parse message: unexpected extra frames");
+                    zmq::message_t extra;
+                    do {
+                        socket->recv(extra, zmq::recv_flags::none);
+                    } while (extra.more());
+                    timer.fail();
+                    return false;
+                }
+            }
+
+            timer.setBytes(receiveFrame.size());
             try {
-                auto j = nlohmann::json::parse(serialized);
-                Message msg;
-                from_json(j, msg);
-                return msg;
+                const char* data = static_cast<const char*>(receiveFrame.data());
+                if (isBinaryFrame(data, receiveFrame.size())) {
+                    from_binary(data, receiveFrame.size(), msg);
+                }
+                else {
+                    from_json(nlohmann::json::parse(data, data + receiveFrame.size()), msg);
+                }
+                timer.setType(msg.type);
+                return true;
             }
             catch (const std::exception& e) {
                 spdlog::error("Failed to parse message: {}", e.what());
+                timer.fail();
             }
         }
-        return std::nullopt;
+        return false;
     }
 }
\ No newline at end of file
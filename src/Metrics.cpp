@@ -0,0 +1,223 @@
+#include "StockTracker/Metrics.h"
+#include <algorithm>
+#include <cmath>
+
+namespace StockTracker {
+
+    void to_json(json& j, const MetricStats& stats) {
+        j = json{
+            {"name", stats.name},
+            {"count", stats.count},
+            {"errors", stats.errors},
+            {"bytes", stats.bytes},
+            {"mean_ns", stats.mean_ns},
+            {"p50_ns", stats.p50_ns},
+            {"p90_ns", stats.p90_ns},
+            {"p99_ns", stats.p99_ns},
+            {"p999_ns", stats.p999_ns},
+            {"max_ns", stats.max_ns}
+        };
+    }
+
+    void from_json(const json& j, MetricStats& stats) {
+        j.at("name").get_to(stats.name);
+        j.at("count").get_to(stats.count);
+        stats.errors = j.value("errors", uint64_t{ 0 });
+        stats.bytes = j.value("bytes", uint64_t{ 0 });
+        stats.mean_ns = j.value("mean_ns", uint64_t{ 0 });
+        stats.p50_ns = j.value("p50_ns", uint64_t{ 0 });
+        stats.p90_ns = j.value("p90_ns", uint64_t{ 0 });
+        stats.p99_ns = j.value("p99_ns", uint64_t{ 0 });
+        stats.p999_ns = j.value("p999_ns", uint64_t{ 0 });
+        stats.max_ns = j.value("max_ns", uint64_t{ 0 });
+    }
+
+    void to_json(json& j, const MetricsSnapshot& snapshot) {
+        j = json{
+            {"taken_at", std::chrono::duration_cast<std::chrono::milliseconds>(
+                snapshot.taken_at.time_since_epoch()).count()},
+            {"metrics", snapshot.metrics}
+        };
+    }
+
+    void from_json(const json& j, MetricsSnapshot& snapshot) {
+        // Milliseconds since the epoch
+        snapshot.taken_at = std::chrono::system_clock::time_point(
+            std::chrono::milliseconds(j.at("taken_at").get<int64_t>()));
+        j.at("metrics").get_to(snapshot.metrics);
+    }
+
+    size_t LatencyHistogram::bucketIndex(uint64_t nanos) noexcept {
+        constexpr uint64_t SUB_BUCKETS = uint64_t{ 1 } << SUB_BUCKET_BITS;
+        if (nanos < SUB_BUCKETS) {
+            return static_cast<size_t>(nanos);
+        }
+
+        int magnitude = 63;
+        while ((nanos >> magnitude) == 0) {
+            --magnitude;
+        }
+        if (magnitude > MAX_MAGNITUDE) {
+            return BUCKET_COUNT - 1;
+        }
+
+        // The top SUB_BUCKET_BITS + 1 bits pick the bucket within the power of two
+        uint64_t sub = nanos >> (magnitude - SUB_BUCKET_BITS);
+        return static_cast<size_t>((static_cast<uint64_t>(magnitude - SUB_BUCKET_BITS) << SUB_BUCKET_BITS) + sub);
+    }
+
+    uint64_t LatencyHistogram::bucketValue(size_t index) noexcept {
+        constexpr size_t SUB_BUCKETS = size_t{ 1 } << SUB_BUCKET_BITS;
+        if (index < 2 * SUB_BUCKETS) {
+            return index;
+        }
+
+        int shift = static_cast<int>(index >> SUB_BUCKET_BITS) - 1;
+        uint64_t sub = (index & (SUB_BUCKETS - 1)) + SUB_BUCKETS;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    void LatencyHistogram::record(uint64_t nanos, bool ok, size_t size) noexcept {
+        buckets[bucketIndex(nanos)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        totalNanos.fetch_add(nanos, std::memory_order_relaxed);
+        if (!ok) {
+            errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (size > 0) {
+            bytes.fetch_add(size, std::memory_order_relaxed);
+        }
+
+        uint64_t max = maxNanos.load(std::memory_order_relaxed);
+        while (nanos > max && !maxNanos.compare_exchange_weak(max, nanos, std::memory_order_relaxed)) {}
+    }
+
+    void LatencyHistogram::reset() noexcept {
+        for (auto& bucket : buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count.store(0, std::memory_order_relaxed);
+        errors.store(0, std::memory_order_relaxed);
+        bytes.store(0, std::memory_order_relaxed);
+        totalNanos.store(0, std::memory_order_relaxed);
+        maxNanos.store(0, std::memory_order_relaxed);
+    }
+
+    void LatencyHistogram::snapshot(MetricStats& stats) const {
+        std::array<uint64_t, BUCKET_COUNT> counts;
+        uint64_t total = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            counts[i] = buckets[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+
+        stats.count = count.load(std::memory_order_relaxed);
+        stats.errors = errors.load(std::memory_order_relaxed);
+        stats.bytes = bytes.load(std::memory_order_relaxed);
+        stats.max_ns = maxNanos.load(std::memory_order_relaxed);
+        stats.mean_ns = stats.count > 0 ? totalNanos.load(std::memory_order_relaxed) / stats.count : 0;
+
+        // Percentiles come from the bucket counts alone, so they are consistent with each other
+        auto percentile = [&](double p) -> uint64_t {
+            if (total == 0) {
+                return 0;
+            }
+            auto rank = static_cast<uint64_t>(std::ceil(p * static_cast<double>(total)));
+            uint64_t seen = 0;
+            for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+                seen += counts[i];
+                if (seen >= rank && counts[i] > 0) {
+                    return std::min(bucketValue(i), stats.max_ns);
+                }
+            }
+            return stats.max_ns;
+        };
+        stats.p50_ns = percentile(0.50);
+        stats.p90_ns = percentile(0.90);
+        stats.p99_ns = percentile(0.99);
+        stats.p999_ns = percentile(0.999);
+    }
+
+#if STOCKTRACKER_ENABLE_METRICS
+
+    namespace {
+
+        constexpr size_t METRIC_COUNT = static_cast<size_t>(Metric::CurrencyConvertAsync) + 1;
+
+        // Metrics split by MessageType; they come first in the Metric enum
+        constexpr size_t TYPED_METRIC_COUNT = static_cast<size_t>(Metric::SocketReceive) + 1;
+
+        const char* const METRIC_NAMES[METRIC_COUNT] = {
+            "socket.send",
+            "socket.receive",
+            "db.save_price",
+            "db.write_batch",
+            "db.price_history",
+            "db.price_history_range",
+            "db.price_history_page",
+            "db.bars",
+            "db.subscriptions",
+            "db.compact_batch",
+            "currency.convert",
+            "currency.convert_async"
+        };
+
+        // One untyped histogram per metric, followed by one per (typed metric, MessageType).
+        // The untyped slot of a typed metric collects samples whose type is unknown,
+        // e.g. frames that failed to decode.
+        LatencyHistogram histograms[METRIC_COUNT + TYPED_METRIC_COUNT * MESSAGE_TYPE_COUNT];
+
+        size_t slot(Metric metric) {
+            return static_cast<size_t>(metric);
+        }
+
+        size_t slot(Metric metric, MessageType type) {
+            auto index = static_cast<size_t>(metric);
+            if (index >= TYPED_METRIC_COUNT) {
+                return index;
+            }
+            return METRIC_COUNT + index * MESSAGE_TYPE_COUNT + static_cast<size_t>(type);
+        }
+    }
+
+    void Metrics::record(Metric metric, std::chrono::nanoseconds elapsed, bool ok, size_t bytes) noexcept {
+        histograms[slot(metric)].record(static_cast<uint64_t>(elapsed.count()), ok, bytes);
+    }
+
+    void Metrics::record(Metric metric, MessageType type, std::chrono::nanoseconds elapsed, bool ok, size_t bytes) noexcept {
+        histograms[slot(metric, type)].record(static_cast<uint64_t>(elapsed.count()), ok, bytes);
+    }
+
+    MetricsSnapshot Metrics::snapshot() {
+        MetricsSnapshot snapshot{ std::chrono::system_clock::now(), {} };
+
+        auto add = [&](const LatencyHistogram& histogram, std::string name) {
+            MetricStats stats;
+            histogram.snapshot(stats);
+            if (stats.count > 0) {
+                stats.name = std::move(name);
+                snapshot.metrics.push_back(std::move(stats));
+            }
+        };
+
+        for (size_t m = 0; m < METRIC_COUNT; ++m) {
+            add(histograms[m], METRIC_NAMES[m]);
+            if (m < TYPED_METRIC_COUNT) {
+                for (size_t t = 0; t < MESSAGE_TYPE_COUNT; ++t) {
+                    auto type = static_cast<MessageType>(t);
+                    add(histograms[slot(static_cast<Metric>(m), type)],
+                        std::string(METRIC_NAMES[m]) + '.' + json(type).get<std::string>());
+                }
+            }
+        }
+        return snapshot;
+    }
+
+    void Metrics::reset() {
+        for (auto& histogram : histograms) {
+            histogram.reset();
+        }
+    }
+
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "StockTracker/PackedQuote.h"
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+
+namespace StockTracker {
+
+    SymbolId SymbolTable::intern(std::string_view name) {
+        return intern(name, std::numeric_limits<SymbolId>::max());
+    }
+
+    SymbolId SymbolTable::intern(std::string_view name, SymbolId max_id) {
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            auto it = ids.find(name);
+            if (it != ids.end()) {
+                return it->second;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto it = ids.find(name); // Another thread may have interned it meanwhile
+        if (it != ids.end()) {
+            return it->second;
+        }
+        if (names.size() > max_id) {
+            throw std::length_error("Too many names to intern " + std::string(name));
+        }
+
+        auto id = static_cast<SymbolId>(names.size());
+        const std::string& stored = names.emplace_back(name);
+        ids.emplace(stored, id);
+        return id;
+    }
+
+    std::optional<SymbolId> SymbolTable::find(std::string_view name) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = ids.find(name);
+        if (it == ids.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    const std::string& SymbolTable::name(SymbolId id) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        if (id >= names.size()) {
+            throw std::out_of_range("Unknown symbol id: " + std::to_string(id));
+        }
+        return names[id];
+    }
+
+    size_t SymbolTable::size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return names.size();
+    }
+
+    SymbolTable& SymbolTable::global() {
+        static SymbolTable table;
+        return table;
+    }
+
+    SymbolTable& SymbolTable::currencies() {
+        static SymbolTable table;
+        return table;
+    }
+
+    PackedQuote PackedQuote::pack(const StockQuote& quote, SymbolTable& table) {
+        SymbolId currency = SymbolTable::currencies().intern(quote.currency, std::numeric_limits<uint16_t>::max());
+
+        PackedQuote packed{};
+        packed.timestamp = quote.timestamp.time_since_epoch().count();
+        packed.price = quote.price;
+        packed.symbol = table.intern(quote.symbol);
+        packed.currency = static_cast<uint16_t>(currency);
+        if (quote.change_percent) {
+            packed.change_percent = *quote.change_percent;
+            packed.flags |= HAS_CHANGE_PERCENT;
+        }
+        return packed;
+    }
+
+    StockQuote PackedQuote::unpack(const SymbolTable& table) const {
+        StockQuote quote;
+        quote.symbol = table.name(symbol);
+        quote.price = price;
+        quote.timestamp = std::chrono::system_clock::time_point(
+            std::chrono::system_clock::duration(timestamp));
+        if (flags & HAS_CHANGE_PERCENT) {
+            quote.change_percent = change_percent;
+        }
+        quote.currency = SymbolTable::currencies().name(currency);
+        return quote;
+    }
+}
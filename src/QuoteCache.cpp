@@ -0,0 +1,177 @@
+#include "StockTracker/QuoteCache.h"
+#include "StockTracker/PriceStore.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace StockTracker {
+
+    namespace {
+        // Rings hold exact PackedQuotes but order them like the price stores do, by stored timestamp
+        int64_t storedTimestamp(const PackedQuote& quote) {
+            return toStoredTimestamp(std::chrono::system_clock::time_point(
+                std::chrono::system_clock::duration(quote.timestamp)));
+        }
+    }
+
+    QuoteCache::QuoteCache(const QuoteCacheOptions& options, NewestStored newest_stored)
+        : options(options)
+        , newestStored(std::move(newest_stored))
+    {
+        if (options.quotes_per_symbol == 0) {
+            throw std::invalid_argument("Quote cache capacity must be non-zero");
+        }
+        maxSymbols = std::max<size_t>(1, options.memory_budget_bytes / ringBytes());
+    }
+
+    size_t QuoteCache::ringBytes() const {
+        return sizeof(Ring) + options.quotes_per_symbol * sizeof(PackedQuote);
+    }
+
+    void QuoteCache::touch(Ring& ring) {
+        lru.splice(lru.begin(), lru, ring.lruPosition);
+    }
+
+    // Remembers the ring's floor in droppedFloors, then removes the ring
+    void QuoteCache::drop(std::unordered_map<std::string, Ring>::iterator it) {
+        Ring& ring = it->second;
+        int64_t floor = ring.floor;
+        if (ring.count > 0) {
+            size_t newest = (ring.next + ring.slots.size() - 1) % ring.slots.size();
+            floor = std::max(floor, storedTimestamp(ring.slots[newest]));
+        }
+        droppedFloors[it->first] = floor;
+        lru.erase(ring.lruPosition);
+        rings.erase(it);
+    }
+
+    void QuoteCache::insert(const StockQuote& quote) {
+        PackedQuote packed = PackedQuote::pack(quote);
+        int64_t timestamp = toStoredTimestamp(quote.timestamp);
+
+        // A new ring needs the database's newest row first; ask without holding the lock
+        std::optional<int64_t> seed;
+        if (newestStored) {
+            bool cached;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                cached = rings.count(quote.symbol) > 0;
+            }
+            if (!cached) {
+                seed = newestStored(quote.symbol);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto it = rings.find(quote.symbol);
+        if (it == rings.end()) {
+            if (rings.size() >= maxSymbols) {
+                drop(rings.find(lru.back()));
+                ++evictions;
+            }
+            lru.push_front(quote.symbol);
+            it = rings.emplace(quote.symbol, Ring{}).first;
+            Ring& ring = it->second;
+            ring.slots.resize(options.quotes_per_symbol);
+            ring.lruPosition = lru.begin();
+
+            // Rows the database already has, or this symbol's ring had before it was
+            // dropped, are newer than anything a new ring could cache below them
+            auto dropped = droppedFloors.find(quote.symbol);
+            if (dropped != droppedFloors.end()) {
+                ring.floor = dropped->second;
+                droppedFloors.erase(dropped);
+            }
+            if (seed) {
+                ring.floor = std::max(ring.floor, *seed);
+            }
+        }
+        else {
+            touch(it->second);
+        }
+
+        Ring& ring = it->second;
+        if (ring.count > 0) {
+            size_t newest = (ring.next + ring.slots.size() - 1) % ring.slots.size();
+            int64_t newestTimestamp = storedTimestamp(ring.slots[newest]);
+            if (timestamp < newestTimestamp) {
+                // The database orders by timestamp, so an out-of-order quote breaks the
+                // "ring holds the newest rows" invariant. Only quotes newer than everything
+                // seen so far can be cached again.
+                ring.floor = newestTimestamp;
+                ring.count = 0;
+                ring.next = 0;
+                return;
+            }
+        }
+        else if (timestamp < ring.floor) {
+            return;
+        }
+
+        ring.slots[ring.next] = packed;
+        ring.next = (ring.next + 1) % ring.slots.size();
+        ring.count = std::min(ring.count + 1, ring.slots.size());
+    }
+
+    std::optional<std::vector<StockQuote>> QuoteCache::getRecent(const std::string& symbol, int limit) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto it = rings.find(symbol);
+        if (limit < 0 || it == rings.end() || it->second.count < static_cast<size_t>(limit)) {
+            ++misses;
+            return std::nullopt;
+        }
+
+        Ring& ring = it->second;
+        touch(ring);
+        ++hits;
+
+        std::vector<StockQuote> recent;
+        recent.reserve(limit);
+        size_t slot = ring.next;
+        for (int i = 0; i < limit; ++i) {
+            slot = (slot + ring.slots.size() - 1) % ring.slots.size();
+            // At the stores' resolution, so a hit returns what a miss would
+            auto& quote = recent.emplace_back(ring.slots[slot].unpack());
+            quote.timestamp = fromStoredTimestamp(storedTimestamp(ring.slots[slot]));
+        }
+        return recent;
+    }
+
+    void QuoteCache::expire(const std::string& symbol, std::chrono::system_clock::time_point before) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto it = rings.find(symbol);
+        if (it == rings.end()) {
+            return;
+        }
+        Ring& ring = it->second;
+        int64_t cutoff = toStoredTimestamp(before);
+        for (size_t i = 0; i < ring.count; ++i) {
+            if (storedTimestamp(ring.slots[i]) < cutoff) {
+                drop(it);
+                return;
+            }
+        }
+    }
+
+    void QuoteCache::clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (!rings.empty()) {
+            drop(rings.begin());
+        }
+    }
+
+    QuoteCacheStats QuoteCache::stats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        QuoteCacheStats stats;
+        stats.hits = hits;
+        stats.misses = misses;
+        stats.evictions = evictions;
+        stats.symbols = rings.size();
+        stats.memory_bytes = rings.size() * ringBytes();
+        return stats;
+    }
+}
@@ -0,0 +1,191 @@
+#include "StockTracker/QuoteReplay.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+namespace StockTracker {
+
+    namespace {
+
+        int64_t steadyNanos() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // Longest single sleep, so stop() is noticed while waiting out a gap in the data
+        constexpr auto MAX_SLEEP = std::chrono::milliseconds(50);
+    }
+
+    HistoryQuoteSource::HistoryQuoteSource(DatabaseService& db, std::vector<std::string> symbols,
+        std::chrono::system_clock::time_point from,
+        std::chrono::system_clock::time_point to,
+        std::chrono::seconds window)
+        : db(db)
+        , symbols(std::move(symbols))
+        , windowStart(from)
+        , to(to)
+        , window(window)
+    {
+        if (window.count() <= 0) {
+            throw std::invalid_argument("Replay window must be positive");
+        }
+    }
+
+    bool HistoryQuoteSource::next(StockQuote& quote) {
+        while (position == buffer.size()) {
+            if (windowStart >= to) {
+                return false;
+            }
+            buffer.clear();
+            position = 0;
+
+            auto windowEnd = windowStart + window < to ? windowStart + window : to;
+            // scanPriceHistory streams rows in storage order; the sort below merges symbols
+            for (const auto& symbol : symbols) {
+                db.scanPriceHistory(symbol, windowStart, windowEnd,
+                    [&](const StockQuote& stored) { buffer.push_back(stored); });
+            }
+            std::stable_sort(buffer.begin(), buffer.end(),
+                [](const StockQuote& a, const StockQuote& b) { return a.timestamp < b.timestamp; });
+            windowStart = windowEnd;
+        }
+
+        quote = std::move(buffer[position++]);
+        return true;
+    }
+
+    SyntheticQuoteSource::SyntheticQuoteSource(SyntheticQuoteOptions options)
+        : options(options)
+        , rng(options.seed)
+        , noise(0.0, 1.0)
+        , start(std::chrono::system_clock::now())
+    {
+        if (options.symbols == 0 || options.interval.count() <= 0) {
+            throw std::invalid_argument("Synthetic quotes need at least one symbol and a positive interval");
+        }
+
+        names.reserve(options.symbols);
+        prices.reserve(options.symbols);
+        for (size_t i = 0; i < options.symbols; ++i) {
+            names.push_back("SYM" + std::to_string(i));
+            prices.push_back(50.0 + static_cast<double>(i % 400));
+        }
+        opens = prices;
+    }
+
+    bool SyntheticQuoteSource::next(StockQuote& quote) {
+        if (options.max_quotes > 0 && produced >= options.max_quotes) {
+            return false;
+        }
+
+        auto count = static_cast<int64_t>(names.size());
+        auto index = static_cast<size_t>(produced % names.size());
+        auto round = static_cast<int64_t>(produced / names.size());
+        auto interval = std::chrono::duration_cast<std::chrono::nanoseconds>(options.interval);
+        auto offset = interval * round + interval * static_cast<int64_t>(index) / count;
+
+        auto& price = prices[index];
+        price *= std::exp(options.volatility * noise(rng));
+
+        quote.symbol = names[index];
+        quote.price = price;
+        quote.timestamp = start + std::chrono::duration_cast<std::chrono::system_clock::duration>(offset);
+        quote.change_percent = (price / opens[index] - 1.0) * 100.0;
+        quote.currency = "USD";
+        quote.indicators = std::nullopt;
+
+        ++produced;
+        return true;
+    }
+
+    QuoteReplayer::QuoteReplayer(MessageSocket& socket, ReplayOptions options)
+        : socket(socket)
+        , options(options)
+    {
+        if (!(options.speed >= 0.0)) {
+            throw std::invalid_argument("Replay speed must not be negative");
+        }
+    }
+
+    ReplayStats QuoteReplayer::run(QuoteSource& source) {
+        ReplayStats stats;
+        auto started = std::chrono::steady_clock::now();
+
+        Message msg{};
+        msg.type = MessageType::QuoteUpdate;
+        StockQuote quote;
+        std::optional<std::chrono::system_clock::time_point> firstTimestamp;
+
+        while (!stopping && source.next(quote)) {
+            if (options.speed > 0.0) {
+                if (!firstTimestamp) {
+                    firstTimestamp = quote.timestamp;
+                }
+                auto offset = std::chrono::duration<double, std::nano>(quote.timestamp - *firstTimestamp);
+                auto due = started + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::max(offset, decltype(offset)::zero()) / options.speed);
+
+                auto now = std::chrono::steady_clock::now();
+                while (now < due && !stopping) {
+                    std::this_thread::sleep_until(std::min(due, now + MAX_SLEEP));
+                    now = std::chrono::steady_clock::now();
+                }
+                if (stopping) {
+                    break;
+                }
+                stats.max_lag = std::max(stats.max_lag,
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(now - due));
+            }
+
+            msg.symbol = quote.symbol;
+            msg.quote = std::move(quote);
+            if (options.stamp_send_time) {
+                msg.sentAt = steadyNanos();
+            }
+            socket.send(msg);
+            ++stats.sent;
+        }
+        socket.flushQuoteBatch();
+
+        stats.elapsed = std::chrono::steady_clock::now() - started;
+        return stats;
+    }
+
+    bool LatencyRecorder::record(const Message& msg) {
+        if (!msg.sentAt) {
+            return false;
+        }
+
+        auto now = steadyNanos();
+        histogram.record(static_cast<uint64_t>(std::max<int64_t>(now - *msg.sentAt, 0)), true, 0);
+        quotes.fetch_add(msg.type == MessageType::QuoteBatch && msg.quotes ? msg.quotes->size() : 1,
+            std::memory_order_relaxed);
+
+        int64_t unset = 0;
+        firstAt.compare_exchange_strong(unset, now, std::memory_order_relaxed);
+        lastAt.store(now, std::memory_order_relaxed);
+        return true;
+    }
+
+    LatencyStats LatencyRecorder::stats() const {
+        LatencyStats stats;
+        histogram.snapshot(stats.latency);
+        stats.latency.name = "replay.latency";
+        stats.quotes = quotes.load(std::memory_order_relaxed);
+        stats.elapsed = std::chrono::nanoseconds(
+            lastAt.load(std::memory_order_relaxed) - firstAt.load(std::memory_order_relaxed));
+        if (stats.elapsed.count() > 0) {
+            stats.quotes_per_second = static_cast<double>(stats.quotes)
+                / std::chrono::duration<double>(stats.elapsed).count();
+        }
+        return stats;
+    }
+
+    void LatencyRecorder::reset() {
+        histogram.reset();
+        quotes = 0;
+        firstAt = 0;
+        lastAt = 0;
+    }
+}
@@ -0,0 +1,223 @@
+#include "StockTracker/Reactor.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace StockTracker {
+
+    Reactor::Reactor(std::shared_ptr<zmq::context_t> context)
+        : context(std::move(context))
+        , wakeReceiver(*this->context, zmq::socket_type::pair)
+        , wakeSender(*this->context, zmq::socket_type::pair)
+    {
+        static std::atomic<uint64_t> instanceCount{ 0 };
+        std::string wakeEndpoint = "inproc://reactor-wake-" + std::to_string(++instanceCount);
+        wakeReceiver.set(zmq::sockopt::linger, 0);
+        wakeSender.set(zmq::sockopt::linger, 0);
+        wakeReceiver.bind(wakeEndpoint);
+        wakeSender.connect(wakeEndpoint);
+    }
+
+    void Reactor::addSocket(MessageSocket& socket, Handler handler) {
+        for (const auto& registration : sockets) {
+            if (registration.socket == &socket && !registration.removed) {
+                throw std::logic_error("Socket is already registered with the reactor");
+            }
+        }
+        sockets.push_back(Registration{ &socket, std::move(handler) });
+        socketsChanged = true;
+    }
+
+    void Reactor::removeSocket(MessageSocket& socket) {
+        // Only marked here; the entry is dropped before the next poll, since a handler
+        // further up the stack may still be running from it
+        for (auto& registration : sockets) {
+            if (registration.socket == &socket) {
+                registration.removed = true;
+                socketsChanged = true;
+            }
+        }
+    }
+
+    Reactor::TimerId Reactor::addTimer(std::chrono::milliseconds interval, Callback callback) {
+        if (interval.count() <= 0) {
+            throw std::invalid_argument("Timer interval must be positive");
+        }
+        TimerId id = nextTimerId++;
+        timers.emplace(id, Timer{ std::chrono::steady_clock::now() + interval, interval, true, std::move(callback) });
+        return id;
+    }
+
+    Reactor::TimerId Reactor::callLater(std::chrono::milliseconds delay, Callback callback) {
+        TimerId id = nextTimerId++;
+        timers.emplace(id, Timer{ std::chrono::steady_clock::now() + delay, delay, false, std::move(callback) });
+        return id;
+    }
+
+    void Reactor::cancelTimer(TimerId id) {
+        timers.erase(id);
+    }
+
+    void Reactor::post(Callback callback) {
+        std::lock_guard<std::mutex> lock(postMutex);
+        posted.push_back(std::move(callback));
+        wake();
+    }
+
+    void Reactor::stop() {
+        stopped = true;
+        std::lock_guard<std::mutex> lock(postMutex);
+        wake();
+    }
+
+    // Caller must hold postMutex. One pending wake-up is enough however many callers poke us.
+    void Reactor::wake() {
+        if (!wakePending) {
+            wakePending = true;
+            zmq::message_t signal;
+            wakeSender.send(signal, zmq::send_flags::dontwait);
+        }
+    }
+
+    void Reactor::run() {
+        while (runOnce(std::chrono::milliseconds(-1))) {}
+    }
+
+    bool Reactor::runOnce(std::chrono::milliseconds timeout) {
+        if (stopped) {
+            return false;
+        }
+        if (socketsChanged) {
+            rebuildPollItems();
+        }
+
+        zmq::poll(pollItems.data(), pollItems.size(), pollTimeout(timeout));
+
+        if (pollItems[0].revents & ZMQ_POLLIN) {
+            zmq::message_t signal;
+            while (wakeReceiver.recv(signal, zmq::recv_flags::dontwait)) {}
+            runPosted();
+        }
+
+        // pollItems[i + 1] belongs to sockets[i]; handlers may append to `sockets`
+        // but nothing is erased until the next rebuild
+        size_t count = pollItems.size() - 1;
+        for (size_t i = 0; i < count && !stopped; ++i) {
+            if (pollItems[i + 1].revents & ZMQ_POLLIN) {
+                dispatchSocket(i);
+            }
+        }
+
+        if (!stopped) {
+            runTimers();
+        }
+        return !stopped;
+    }
+
+    void Reactor::rebuildPollItems() {
+        sockets.erase(std::remove_if(sockets.begin(), sockets.end(),
+            [](const Registration& registration) { return registration.removed; }), sockets.end());
+
+        pollItems.clear();
+        pollItems.push_back({ wakeReceiver.handle(), 0, ZMQ_POLLIN, 0 });
+        for (const auto& registration : sockets) {
+            pollItems.push_back({ registration.socket->getSocket().handle(), 0, ZMQ_POLLIN, 0 });
+        }
+        socketsChanged = false;
+    }
+
+    void Reactor::dispatchSocket(size_t index) {
+        for (int burst = 0; burst < MAX_BURST; ++burst) {
+            Registration& registration = sockets[index];
+            if (registration.removed) {
+                return;
+            }
+
+            try {
+                registration.handler(*registration.socket);
+            }
+            catch (const std::exception& e) {
+                spdlog::error("Reactor socket handler threw: {}", e.what());
+            }
+
+            // zmq::poll is level-triggered, so anything left over is picked up next time
+            if (sockets[index].removed ||
+                !(sockets[index].socket->getSocket().get(zmq::sockopt::events) & ZMQ_POLLIN)) {
+                return;
+            }
+        }
+    }
+
+    void Reactor::runPosted() {
+        std::vector<Callback> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(postMutex);
+            callbacks.swap(posted);
+            wakePending = false;
+        }
+
+        for (auto& callback : callbacks) {
+            try {
+                callback();
+            }
+            catch (const std::exception& e) {
+                spdlog::error("Reactor posted callback threw: {}", e.what());
+            }
+        }
+    }
+
+    void Reactor::runTimers() {
+        auto now = std::chrono::steady_clock::now();
+
+        std::vector<TimerId> due;
+        for (const auto& [id, timer] : timers) {
+            if (timer.due <= now) {
+                due.push_back(id);
+            }
+        }
+
+        for (TimerId id : due) {
+            // An earlier callback may have cancelled this one
+            auto it = timers.find(id);
+            if (it == timers.end()) {
+                continue;
+            }
+
+            Callback callback;
+            Timer& timer = it->second;
+            if (timer.repeat) {
+                // Skip missed ticks instead of firing a burst after a stall
+                timer.due += timer.interval;
+                if (timer.due <= now) {
+                    timer.due = now + timer.interval;
+                }
+                callback = timer.callback;   // Copy: the callback may cancel its own timer
+            }
+            else {
+                callback = std::move(timer.callback);
+                timers.erase(it);
+            }
+
+            try {
+                callback();
+            }
+            catch (const std::exception& e) {
+                spdlog::error("Reactor timer threw: {}", e.what());
+            }
+        }
+    }
+
+    std::chrono::milliseconds Reactor::pollTimeout(std::chrono::milliseconds limit) const {
+        if (timers.empty()) {
+            return limit;
+        }
+
+        auto next = std::min_element(timers.begin(), timers.end(),
+            [](const auto& a, const auto& b) { return a.second.due < b.second.due; })->second.due;
+        auto untilNext = std::chrono::ceil<std::chrono::milliseconds>(next - std::chrono::steady_clock::now());
+        untilNext = std::max(untilNext, std::chrono::milliseconds(0));
+
+        return limit.count() < 0 ? untilNext : std::min(limit, untilNext);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,394 @@
+#include "StockTracker/SqlitePriceStore.h"
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace StockTracker {
+
+    namespace {
+        // PRAGMA user_version of a database whose price_history.timestamp holds stored
+        // timestamps (milliseconds). Before it, the column held system_clock ticks.
+        constexpr int MILLISECOND_TIMESTAMPS_VERSION = 1;
+
+        // Reads columns (symbol, price, timestamp, change_percent) of the current row
+        void readQuote(sqlite3_stmt* stmt, StockQuote& quote) {
+            quote.symbol = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            quote.price = sqlite3_column_double(stmt, 1);
+            quote.timestamp = fromStoredTimestamp(sqlite3_column_int64(stmt, 2));
+
+            if (sqlite3_column_type(stmt, 3) != SQLITE_NULL) {
+                quote.change_percent = sqlite3_column_double(stmt, 3);
+            }
+            else {
+                quote.change_percent = std::nullopt;
+            }
+        }
+
+        const char* const PRICE_RANGE_SQL = R"(
+        SELECT symbol, price, timestamp, change_percent
+        FROM price_history
+        WHERE symbol = ? AND timestamp >= ? AND timestamp < ?
+        ORDER BY timestamp ASC, rowid ASC
+    )";
+
+        // Owns its statement, so several cursors can be open at once
+        class SqliteCursorSource : public PriceHistoryCursor::Source {
+        public:
+            explicit SqliteCursorSource(sqlite3_stmt* stmt) : stmt(stmt) {}
+            ~SqliteCursorSource() override {
+                sqlite3_finalize(stmt);
+            }
+
+            bool next(StockQuote& quote) override {
+                int rc = sqlite3_step(stmt);
+                if (rc == SQLITE_ROW) {
+                    readQuote(stmt, quote);
+                    return true;
+                }
+                if (rc != SQLITE_DONE) {
+                    throw std::runtime_error("Failed to read price history");
+                }
+                return false;
+            }
+
+        private:
+            sqlite3_stmt* stmt;
+        };
+    }
+
+    std::vector<std::string> distinctSymbols(sqlite3* db, const char* table) {
+        using Statement = std::unique_ptr<sqlite3_stmt, decltype(&sqlite3_finalize)>;
+        auto prepare = [db](const std::string& sql) {
+            sqlite3_stmt* stmt;
+            if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+                throw std::runtime_error(std::string("Failed to prepare statement: ") + sqlite3_errmsg(db));
+            }
+            return Statement(stmt, &sqlite3_finalize);
+        };
+        Statement first = prepare(std::string("SELECT MIN(symbol) FROM ") + table);
+        Statement next = prepare(std::string("SELECT MIN(symbol) FROM ") + table + " WHERE symbol > ?");
+
+        std::vector<std::string> symbols;
+        sqlite3_stmt* stmt = first.get();
+        while (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) != SQLITE_NULL) {
+            symbols.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+            stmt = next.get();
+            sqlite3_reset(stmt);
+            sqlite3_bind_text(stmt, 1, symbols.back().c_str(), -1, SQLITE_STATIC);
+        }
+        return symbols;
+    }
+
+    SqlitePriceStore::SqlitePriceStore(sqlite3* db, bool read_only)
+        : db(db)
+        , readOnly(read_only)
+    {
+        if (!read_only) {
+            createTable();
+        }
+
+        auto prepare = [this](const char* sql, sqlite3_stmt*& stmt) {
+            if (sqlite3_prepare_v3(this->db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+                throw std::runtime_error(std::string("Failed to prepare statement: ") + sqlite3_errmsg(this->db));
+            }
+        };
+
+        try {
+            if (!read_only) {
+                prepare(R"(
+        INSERT INTO price_history (symbol, price, timestamp, change_percent)
+        VALUES (?, ?, ?, ?)
+    )", insertPriceStmt);
+
+                prepare(R"(
+        SELECT rowid, price, timestamp, change_percent
+        FROM price_history
+        WHERE symbol = ? AND timestamp < ?
+        ORDER BY timestamp ASC, rowid ASC
+        LIMIT ?
+    )", expiredStmt);
+
+                prepare("DELETE FROM price_history WHERE rowid = ?", deleteRowStmt);
+            }
+
+            prepare(R"(
+        SELECT symbol, price, timestamp, change_percent
+        FROM price_history
+        WHERE symbol = ?
+        ORDER BY timestamp DESC, rowid DESC
+        LIMIT ?
+    )", priceHistoryStmt);
+
+            prepare((std::string(PRICE_RANGE_SQL) + " LIMIT ?").c_str(), priceRangeStmt);
+
+            // Row-value comparison keeps the walk on the (symbol, timestamp) index
+            prepare(R"(
+        SELECT symbol, price, timestamp, change_percent, rowid
+        FROM price_history
+        WHERE symbol = ? AND (timestamp, rowid) < (?, ?)
+        ORDER BY timestamp DESC, rowid DESC
+        LIMIT ?
+    )", pricePageStmt);
+
+            prepare(R"(
+        SELECT price, timestamp, change_percent
+        FROM price_history
+        WHERE symbol = ? AND timestamp >= ? AND timestamp < ?
+    )", priceScanStmt);
+        }
+        catch (...) {
+            finalizeStatements();
+            throw;
+        }
+    }
+
+    void SqlitePriceStore::createTable() {
+        const char* sql = R"(
+        CREATE TABLE IF NOT EXISTS price_history (
+            symbol TEXT NOT NULL,
+            price REAL NOT NULL,
+            timestamp INTEGER NOT NULL,
+            change_percent REAL
+        );
+
+        CREATE INDEX IF NOT EXISTS idx_price_history_symbol_timestamp
+            ON price_history (symbol, timestamp);
+    )";
+
+        char* errMsg = nullptr;
+        if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+            std::string error = errMsg ? errMsg : "unknown error";
+            sqlite3_free(errMsg);
+            throw std::runtime_error("Failed to create tables: " + error);
+        }
+        migrateTimestamps();
+    }
+
+    void SqlitePriceStore::migrateTimestamps() {
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, "PRAGMA user_version", -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error(std::string("Failed to prepare statement: ") + sqlite3_errmsg(db));
+        }
+        int version = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : 0;
+        sqlite3_finalize(stmt);
+        if (version >= MILLISECOND_TIMESTAMPS_VERSION) {
+            return;
+        }
+
+        // Integer division truncates like the duration_cast in toStoredTimestamp
+        auto ticksPerMilli = std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::milliseconds(1)).count();
+        std::string sql = "BEGIN;"
+            " UPDATE price_history SET timestamp = timestamp / " + std::to_string(ticksPerMilli) + ";"
+            " PRAGMA user_version = " + std::to_string(MILLISECOND_TIMESTAMPS_VERSION) + ";"
+            " COMMIT;";
+        char* errMsg = nullptr;
+        if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+            std::string error = errMsg ? errMsg : "unknown error";
+            sqlite3_free(errMsg);
+            sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+            throw std::runtime_error("Failed to migrate price history timestamps: " + error);
+        }
+    }
+
+    SqlitePriceStore::~SqlitePriceStore() {
+        finalizeStatements();
+    }
+
+    void SqlitePriceStore::finalizeStatements() {
+        // sqlite3_finalize is a no-op on nullptr
+        for (sqlite3_stmt** stmt : { &insertPriceStmt, &priceHistoryStmt, &priceRangeStmt,
+                                     &pricePageStmt, &priceScanStmt, &expiredStmt, &deleteRowStmt }) {
+            sqlite3_finalize(*stmt);
+            *stmt = nullptr;
+        }
+    }
+
+    void SqlitePriceStore::append(const StockQuote* quotes, size_t count) {
+        if (readOnly) {
+            throw std::logic_error("Price store is read-only");
+        }
+        sqlite3_stmt* stmt = insertPriceStmt;
+        SqliteStatementReset reset(stmt);
+
+        for (size_t i = 0; i < count; ++i) {
+            const StockQuote& quote = quotes[i];
+            auto timestamp = toStoredTimestamp(quote.timestamp);
+            sqlite3_bind_text(stmt, 1, quote.symbol.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_double(stmt, 2, quote.price);
+            sqlite3_bind_int64(stmt, 3, timestamp);
+            if (quote.change_percent) {
+                sqlite3_bind_double(stmt, 4, *quote.change_percent);
+            }
+            else {
+                sqlite3_bind_null(stmt, 4);
+            }
+
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                throw std::runtime_error("Failed to save price");
+            }
+            sqlite3_reset(stmt);
+        }
+    }
+
+    std::vector<StockQuote> SqlitePriceStore::latest(const std::string& symbol, int limit) {
+        sqlite3_stmt* stmt = priceHistoryStmt;
+        SqliteStatementReset reset(stmt);
+
+        sqlite3_bind_text(stmt, 1, symbol.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 2, limit);
+
+        std::vector<StockQuote> history;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            readQuote(stmt, history.emplace_back());
+        }
+
+        return history;
+    }
+
+    std::vector<StockQuote> SqlitePriceStore::range(const std::string& symbol,
+        std::chrono::system_clock::time_point from,
+        std::chrono::system_clock::time_point to,
+        int limit) {
+        sqlite3_stmt* stmt = priceRangeStmt;
+        SqliteStatementReset reset(stmt);
+
+        sqlite3_bind_text(stmt, 1, symbol.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 2, toStoredTimestamp(from));
+        sqlite3_bind_int64(stmt, 3, toStoredTimestamp(to));
+        sqlite3_bind_int(stmt, 4, limit);
+
+        std::vector<StockQuote> history;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            readQuote(stmt, history.emplace_back());
+        }
+
+        return history;
+    }
+
+    PriceHistoryPage SqlitePriceStore::page(const std::string& symbol, int limit,
+        std::optional<HistoryPageKey> after) {
+        sqlite3_stmt* stmt = pricePageStmt;
+        SqliteStatementReset reset(stmt);
+
+        HistoryPageKey start = after.value_or(HistoryPageKey{
+            std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::max() });
+        sqlite3_bind_text(stmt, 1, symbol.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 2, start.timestamp);
+        sqlite3_bind_int64(stmt, 3, start.rowid);
+        sqlite3_bind_int(stmt, 4, limit);
+
+        PriceHistoryPage page;
+        HistoryPageKey last{};
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            readQuote(stmt, page.quotes.emplace_back());
+            last = { sqlite3_column_int64(stmt, 2), sqlite3_column_int64(stmt, 4) };
+        }
+
+        // A short page means we reached the oldest row
+        if (limit > 0 && page.quotes.size() == static_cast<size_t>(limit)) {
+            page.next = last;
+        }
+        return page;
+    }
+
+    std::unique_ptr<PriceHistoryCursor::Source> SqlitePriceStore::openCursor(const std::string& symbol,
+        std::chrono::system_clock::time_point from,
+        std::chrono::system_clock::time_point to) {
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, PRICE_RANGE_SQL, -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error("Failed to prepare statement");
+        }
+
+        sqlite3_bind_text(stmt, 1, symbol.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt, 2, toStoredTimestamp(from));
+        sqlite3_bind_int64(stmt, 3, toStoredTimestamp(to));
+
+        return std::make_unique<SqliteCursorSource>(stmt);
+    }
+
+    void SqlitePriceStore::scan(const std::string& symbol,
+        std::chrono::system_clock::time_point from,
+        std::chrono::system_clock::time_point to,
+        const std::function<void(const StockQuote&)>& visit) {
+        sqlite3_stmt* stmt = priceScanStmt;
+        SqliteStatementReset reset(stmt);
+
+        sqlite3_bind_text(stmt, 1, symbol.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 2, toStoredTimestamp(from));
+        sqlite3_bind_int64(stmt, 3, toStoredTimestamp(to));
+
+        StockQuote quote;
+        quote.symbol = symbol;
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            quote.price = sqlite3_column_double(stmt, 0);
+            quote.timestamp = fromStoredTimestamp(sqlite3_column_int64(stmt, 1));
+            if (sqlite3_column_type(stmt, 2) != SQLITE_NULL) {
+                quote.change_percent = sqlite3_column_double(stmt, 2);
+            }
+            else {
+                quote.change_percent = std::nullopt;
+            }
+            visit(quote);
+        }
+        if (rc != SQLITE_DONE) {
+            throw std::runtime_error("Failed to read price history");
+        }
+    }
+
+    std::vector<std::string> SqlitePriceStore::symbols() {
+        return distinctSymbols(db, "price_history");
+    }
+
+    size_t SqlitePriceStore::trim(const std::string& symbol, std::chrono::system_clock::time_point before,
+        size_t max_rows, const std::function<void(const std::vector<StockQuote>&)>& retire) {
+        if (readOnly) {
+            throw std::logic_error("Price store is read-only");
+        }
+
+        std::vector<StockQuote> rows;
+        std::vector<int64_t> rowids;
+        {
+            sqlite3_stmt* stmt = expiredStmt;
+            SqliteStatementReset reset(stmt);
+
+            sqlite3_bind_text(stmt, 1, symbol.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int64(stmt, 2, toStoredTimestamp(before));
+            sqlite3_bind_int64(stmt, 3, static_cast<int64_t>(std::min<size_t>(max_rows, std::numeric_limits<int64_t>::max())));
+
+            int rc;
+            while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+                rowids.push_back(sqlite3_column_int64(stmt, 0));
+                StockQuote& quote = rows.emplace_back();
+                quote.symbol = symbol;
+                quote.price = sqlite3_column_double(stmt, 1);
+                quote.timestamp = fromStoredTimestamp(sqlite3_column_int64(stmt, 2));
+                if (sqlite3_column_type(stmt, 3) != SQLITE_NULL) {
+                    quote.change_percent = sqlite3_column_double(stmt, 3);
+                }
+            }
+            if (rc != SQLITE_DONE) {
+                throw std::runtime_error("Failed to read price history");
+            }
+        }
+        if (rows.empty()) {
+            return 0;
+        }
+
+        retire(rows);
+
+        sqlite3_stmt* stmt = deleteRowStmt;
+        SqliteStatementReset reset(stmt);
+        for (int64_t rowid : rowids) {
+            sqlite3_bind_int64(stmt, 1, rowid);
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                throw std::runtime_error("Failed to delete price history");
+            }
+            sqlite3_reset(stmt);
+        }
+        return rows.size();
+    }
+}
\ No newline at end of file
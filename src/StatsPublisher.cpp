@@ -0,0 +1,23 @@
+#include "StockTracker/StatsPublisher.h"
+
+namespace StockTracker {
+
+    StatsPublisher::StatsPublisher(MessageSocket& socket, std::chrono::milliseconds interval)
+        : socket(socket)
+        , interval(interval)
+        , lastPublished(std::chrono::steady_clock::now())
+    {}
+
+    bool StatsPublisher::poll() {
+        if (std::chrono::steady_clock::now() - lastPublished < interval) {
+            return false;
+        }
+        publishNow();
+        return true;
+    }
+
+    void StatsPublisher::publishNow() {
+        lastPublished = std::chrono::steady_clock::now();
+        socket.send(Message::makeStats(Metrics::snapshot()));
+    }
+}
\ No newline at end of file
@@ -0,0 +1,855 @@
+#include "StockTracker/TickLogStore.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace StockTracker {
+
+    namespace {
+        namespace fs = std::filesystem;
+
+        constexpr char SEGMENT_MAGIC[8] = { 'S', 'T', 'T', 'I', 'C', 'K', 'S', '\0' };
+        constexpr uint32_t SEGMENT_VERSION = 2;
+        // Version 1 segments held system_clock ticks instead of stored timestamps
+        constexpr uint32_t TICKS_SEGMENT_VERSION = 1;
+        constexpr size_t ROW_SIZE = sizeof(int64_t) + 2 * sizeof(double);
+
+        // Followed by the timestamp, price and change percent columns, `capacity` entries each
+        struct SegmentHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t sorted;            // 1 while every row's timestamp >= the previous row's
+            uint64_t capacity;
+            uint64_t count;             // Rows written, bumped after the row itself
+            uint64_t first_sequence;
+            int64_t min_timestamp;
+            int64_t max_timestamp;
+            uint64_t reserved;
+        };
+        static_assert(sizeof(SegmentHeader) == 64, "Segment header layout changed");
+
+        size_t segmentSize(uint64_t capacity) {
+            return sizeof(SegmentHeader) + capacity * ROW_SIZE;
+        }
+
+        // Keeps [A-Z0-9_-] and percent-encodes everything else, so directory names are safe
+        // on any file system and "aapl" can't collide with "AAPL" where case is ignored
+        std::string encodeSymbol(const std::string& symbol) {
+            static const char HEX[] = "0123456789ABCDEF";
+            std::string name;
+            for (unsigned char c : symbol) {
+                if ((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-') {
+                    name += static_cast<char>(c);
+                }
+                else {
+                    name += '%';
+                    name += HEX[c >> 4];
+                    name += HEX[c & 0xF];
+                }
+            }
+            return name;
+        }
+
+        // Empty for directories that encodeSymbol didn't produce
+        std::optional<std::string> decodeSymbol(const std::string& name) {
+            auto hexDigit = [](char c) {
+                if (c >= '0' && c <= '9') return c - '0';
+                if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+                return -1;
+            };
+
+            std::string symbol;
+            for (size_t i = 0; i < name.size(); ++i) {
+                if (name[i] != '%') {
+                    symbol += name[i];
+                    continue;
+                }
+                if (i + 2 >= name.size()) {
+                    return std::nullopt;
+                }
+                int high = hexDigit(name[i + 1]);
+                int low = hexDigit(name[i + 2]);
+                if (high < 0 || low < 0) {
+                    return std::nullopt;
+                }
+                symbol += static_cast<char>(high * 16 + low);
+                i += 2;
+            }
+            if (symbol.empty() || encodeSymbol(symbol) != name) {
+                return std::nullopt;
+            }
+            return symbol;
+        }
+
+        // Zero-padded so segments sort by name in append order
+        std::string segmentName(size_t index) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "seg-%06zu.dat", index);
+            return name;
+        }
+
+        // Index in a segmentName, or empty for other files
+        std::optional<size_t> segmentIndex(const std::string& name) {
+            if (name.size() <= 8 || name.compare(0, 4, "seg-") != 0
+                || name.compare(name.size() - 4, 4, ".dat") != 0) {
+                return std::nullopt;
+            }
+            size_t index = 0;
+            for (size_t i = 4; i < name.size() - 4; ++i) {
+                if (name[i] < '0' || name[i] > '9') {
+                    return std::nullopt;
+                }
+                index = index * 10 + static_cast<size_t>(name[i] - '0');
+            }
+            return index;
+        }
+
+        uint64_t clampLimit(uint64_t available, int limit) {
+            if (limit < 0) {
+                return available;
+            }
+            return std::min<uint64_t>(available, static_cast<uint64_t>(limit));
+        }
+
+        // First index in [0, count) for which `before` is false; `before` must be monotone
+        template <typename Predicate>
+        uint64_t partitionPoint(uint64_t count, Predicate before) {
+            uint64_t first = 0;
+            while (count > 0) {
+                uint64_t half = count / 2;
+                if (before(first + half)) {
+                    first += half + 1;
+                    count -= half + 1;
+                }
+                else {
+                    count = half;
+                }
+            }
+            return first;
+        }
+
+        // A whole file mapped read-write
+        class MappedFile {
+        public:
+            // With `create`, replaces the file with one of `size` bytes. Otherwise maps the
+            // existing file at its current size.
+            MappedFile(const fs::path& path, bool create, size_t size = 0);
+            ~MappedFile() {
+                close();
+            }
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            char* data() const { return base; }
+            size_t size() const { return length; }
+
+            // Write dirty pages to disk and wait for them
+            void flush();
+
+        private:
+            char* base{ nullptr };
+            size_t length{ 0 };
+#ifdef _WIN32
+            HANDLE file{ INVALID_HANDLE_VALUE };
+            HANDLE mapping{ nullptr };
+#else
+            int fd{ -1 };
+#endif
+
+            void close();
+        };
+
+        MappedFile::MappedFile(const fs::path& path, bool create, size_t size)
+            : length(size)
+        {
+            auto fail = [&](const char* what) {
+                close();
+                throw std::runtime_error(std::string(what) + ": " + path.string());
+            };
+
+#ifdef _WIN32
+            file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) {
+                fail("Failed to open tick log segment");
+            }
+            if (!create) {
+                LARGE_INTEGER fileSize;
+                if (!GetFileSizeEx(file, &fileSize)) {
+                    fail("Failed to read tick log segment size");
+                }
+                length = static_cast<size_t>(fileSize.QuadPart);
+            }
+            if (length == 0) {
+                fail("Empty tick log segment");
+            }
+
+            // A mapping larger than the file extends it with zeros
+            mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE,
+                static_cast<DWORD>(static_cast<uint64_t>(length) >> 32),
+                static_cast<DWORD>(length & 0xFFFFFFFF), nullptr);
+            if (!mapping) {
+                fail("Failed to map tick log segment");
+            }
+            base = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, length));
+            if (!base) {
+                fail("Failed to map tick log segment");
+            }
+#else
+            fd = ::open(path.c_str(), O_RDWR | (create ? O_CREAT | O_TRUNC : 0), 0644);
+            if (fd < 0) {
+                fail("Failed to open tick log segment");
+            }
+            if (create) {
+                if (::ftruncate(fd, static_cast<off_t>(length)) != 0) {
+                    fail("Failed to size tick log segment");
+                }
+            }
+            else {
+                struct stat info;
+                if (::fstat(fd, &info) != 0) {
+                    fail("Failed to read tick log segment size");
+                }
+                length = static_cast<size_t>(info.st_size);
+            }
+            if (length == 0) {
+                fail("Empty tick log segment");
+            }
+
+            void* mapped = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (mapped == MAP_FAILED) {
+                fail("Failed to map tick log segment");
+            }
+            base = static_cast<char*>(mapped);
+#endif
+        }
+
+        void MappedFile::flush() {
+#ifdef _WIN32
+            if (!FlushViewOfFile(base, length) || !FlushFileBuffers(file)) {
+                throw std::runtime_error("Failed to flush tick log segment");
+            }
+#else
+            if (::msync(base, length, MS_SYNC) != 0) {
+                throw std::runtime_error("Failed to flush tick log segment");
+            }
+#endif
+        }
+
+        void MappedFile::close() {
+#ifdef _WIN32
+            if (base) {
+                UnmapViewOfFile(base);
+            }
+            if (mapping) {
+                CloseHandle(mapping);
+            }
+            if (file != INVALID_HANDLE_VALUE) {
+                CloseHandle(file);
+            }
+            mapping = nullptr;
+            file = INVALID_HANDLE_VALUE;
+#else
+            if (base) {
+                ::munmap(base, length);
+            }
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            fd = -1;
+#endif
+            base = nullptr;
+        }
+    }
+
+    class TickLogStore::Segment {
+    public:
+        // A new, empty segment
+        Segment(const fs::path& path, uint64_t capacity, uint64_t firstSequence)
+            : path(path)
+            , file(path, true, segmentSize(capacity))
+        {
+            header = reinterpret_cast<SegmentHeader*>(file.data());
+            std::memcpy(header->magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+            header->version = SEGMENT_VERSION;
+            header->sorted = 1;
+            header->capacity = capacity;
+            header->count = 0;
+            header->first_sequence = firstSequence;
+            header->min_timestamp = 0;
+            header->max_timestamp = 0;
+            header->reserved = 0;
+            bindColumns();
+            dirty = true;
+        }
+
+        // An existing segment
+        explicit Segment(const fs::path& path)
+            : path(path)
+            , file(path, false)
+        {
+            header = reinterpret_cast<SegmentHeader*>(file.data());
+            if (file.size() < sizeof(SegmentHeader)
+                || std::memcmp(header->magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0
+                || (header->version != SEGMENT_VERSION && header->version != TICKS_SEGMENT_VERSION)
+                || header->capacity != (file.size() - sizeof(SegmentHeader)) / ROW_SIZE
+                || file.size() != segmentSize(header->capacity)
+                || header->count > header->capacity
+                || header->first_sequence == 0) {
+                throw std::runtime_error("Corrupt tick log segment: " + path.string());
+            }
+            bindColumns();
+            if (header->version == TICKS_SEGMENT_VERSION) {
+                convertTicks();
+            }
+        }
+
+        uint64_t count() const { return header->count; }
+        bool full() const { return header->count == header->capacity; }
+        // Position of row 0 among all of the symbol's rows
+        uint64_t firstPosition() const { return header->first_sequence - 1; }
+
+        void push(int64_t timestamp, double price, const std::optional<double>& changePercent) {
+            uint64_t row = header->count;
+            timestamps[row] = timestamp;
+            prices[row] = price;
+            changePercents[row] = changePercent.value_or(std::numeric_limits<double>::quiet_NaN());
+
+            if (row == 0) {
+                header->min_timestamp = timestamp;
+                header->max_timestamp = timestamp;
+            }
+            else {
+                if (timestamp < timestamps[row - 1]) {
+                    header->sorted = 0;
+                }
+                header->min_timestamp = std::min(header->min_timestamp, timestamp);
+                header->max_timestamp = std::max(header->max_timestamp, timestamp);
+            }
+            header->count = row + 1;
+            dirty = true;
+        }
+
+        fs::path path;
+        MappedFile file;
+        SegmentHeader* header{ nullptr };
+        int64_t* timestamps{ nullptr };
+        double* prices{ nullptr };
+        double* changePercents{ nullptr };
+        bool dirty{ false };    // Written since the last sync()
+
+    private:
+        // Rewrites a version 1 segment's timestamps as stored timestamps. Truncating keeps
+        // the rows in the same order, so `sorted` still holds.
+        void convertTicks() {
+            auto ticksPerMilli = std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                std::chrono::milliseconds(1)).count();
+            for (uint64_t row = 0; row < header->count; ++row) {
+                timestamps[row] /= ticksPerMilli;
+            }
+            header->min_timestamp /= ticksPerMilli;
+            header->max_timestamp /= ticksPerMilli;
+            header->version = SEGMENT_VERSION;
+            dirty = true;
+        }
+
+        void bindColumns() {
+            char* columns = file.data() + sizeof(SegmentHeader);
+            timestamps = reinterpret_cast<int64_t*>(columns);
+            prices = reinterpret_cast<double*>(columns + header->capacity * sizeof(int64_t));
+            changePercents = reinterpret_cast<double*>(columns + header->capacity * (sizeof(int64_t) + sizeof(double)));
+        }
+    };
+
+    // Rows are addressed by position (sequence - 1) in append order, or by rank in
+    // (timestamp, sequence) order. Positions start at `base`, after the rows trim() dropped;
+    // ranks start at 0. The two differ only by `base` while the log is ordered.
+    struct TickLogStore::SymbolLog {
+        std::string symbol;
+        fs::path directory;
+        std::vector<std::unique_ptr<Segment>> segments;
+        size_t nextSegment{ 0 };        // Index in the name of the next segment file
+        uint64_t base{ 0 };
+        uint64_t size{ 0 };
+        bool ordered{ true };           // Timestamps never decrease across the whole log
+        int64_t lastTimestamp{ 0 };
+
+        std::pair<const Segment*, size_t> locate(uint64_t position) const {
+            auto it = std::upper_bound(segments.begin(), segments.end(), position,
+                [](uint64_t value, const std::unique_ptr<Segment>& segment) { return value < segment->firstPosition(); });
+            const Segment* segment = std::prev(it)->get();
+            return { segment, static_cast<size_t>(position - segment->firstPosition()) };
+        }
+
+        int64_t timestampAt(uint64_t position) const {
+            auto [segment, row] = locate(position);
+            return segment->timestamps[row];
+        }
+
+        HistoryPageKey keyAt(uint64_t position) const {
+            return { timestampAt(position), static_cast<int64_t>(position + 1) };
+        }
+
+        void read(uint64_t position, StockQuote& quote) const {
+            auto [segment, row] = locate(position);
+            quote.symbol = symbol;
+            quote.price = segment->prices[row];
+            quote.timestamp = fromStoredTimestamp(segment->timestamps[row]);
+            double changePercent = segment->changePercents[row];
+            quote.change_percent = std::isnan(changePercent) ? std::nullopt : std::optional<double>(changePercent);
+        }
+
+        // Position of every rank. Empty when the log is ordered and positions follow from
+        // ranks, otherwise sorted from scratch on every call.
+        std::vector<uint64_t> order() const {
+            std::vector<uint64_t> positions;
+            if (ordered) {
+                return positions;
+            }
+
+            std::vector<std::pair<int64_t, uint64_t>> keys;
+            keys.reserve(size);
+            for (const auto& segment : segments) {
+                for (uint64_t row = 0; row < segment->count(); ++row) {
+                    keys.emplace_back(segment->timestamps[row], segment->firstPosition() + row);
+                }
+            }
+            std::sort(keys.begin(), keys.end());
+
+            positions.reserve(keys.size());
+            for (const auto& key : keys) {
+                positions.push_back(key.second);
+            }
+            return positions;
+        }
+
+        uint64_t positionOf(const std::vector<uint64_t>& order, uint64_t rank) const {
+            return order.empty() ? base + rank : order[rank];
+        }
+
+        // Recompute `ordered` from the segment headers, as when the log was loaded
+        void checkOrder() {
+            ordered = true;
+            int64_t previous = 0;
+            bool first = true;
+            for (const auto& segment : segments) {
+                const SegmentHeader& header = *segment->header;
+                if (header.count == 0) {
+                    continue;
+                }
+                if (!header.sorted || (!first && header.min_timestamp < previous)) {
+                    ordered = false;
+                }
+                previous = segment->timestamps[header.count - 1];
+                first = false;
+            }
+        }
+
+        // Ranks [first, last) of the rows with stored timestamp in [from, to)
+        std::pair<uint64_t, uint64_t> ranks(const std::vector<uint64_t>& order, int64_t from, int64_t to) const {
+            uint64_t first = partitionPoint(size, [&](uint64_t rank) { return timestampAt(positionOf(order, rank)) < from; });
+            uint64_t last = partitionPoint(size, [&](uint64_t rank) { return timestampAt(positionOf(order, rank)) < to; });
+            return { first, std::max(first, last) };
+        }
+    };
+
+    // Streams ranks [next, end) as of when it was opened, skipping rows trimmed since
+    class TickLogStore::Cursor : public PriceHistoryCursor::Source {
+    public:
+        Cursor(const TickLogStore& store, const SymbolLog* log, std::vector<uint64_t> order,
+            uint64_t first, uint64_t last)
+            : store(store)
+            , log(log)
+            , order(std::move(order))
+            , base(log ? log->base : 0)
+            , rank(first)
+            , end(last)
+        {}
+
+        bool next(StockQuote& quote) override {
+            if (!log) {
+                return false;
+            }
+            std::shared_lock<std::shared_mutex> lock(store.mutex);
+            while (rank < end) {
+                uint64_t position = order.empty() ? base + rank : order[rank];
+                ++rank;
+                if (position >= log->base) {
+                    log->read(position, quote);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+        const TickLogStore& store;
+        const SymbolLog* log;
+        std::vector<uint64_t> order;
+        uint64_t base;      // The log's base when the ranks were taken
+        uint64_t rank;
+        uint64_t end;
+    };
+
+    TickLogStore::TickLogStore(const TickLogOptions& options)
+        : options(options)
+    {
+        if (options.directory.empty()) {
+            throw std::invalid_argument("Tick log directory must not be empty");
+        }
+        if (options.ticks_per_segment == 0) {
+            throw std::invalid_argument("ticks_per_segment must be positive");
+        }
+        load();
+    }
+
+    TickLogStore::~TickLogStore() = default;
+
+    void TickLogStore::load() {
+        fs::create_directories(options.directory);
+        for (const auto& entry : fs::directory_iterator(options.directory)) {
+            if (!entry.is_directory()) {
+                continue;
+            }
+            auto symbol = decodeSymbol(entry.path().filename().string());
+            if (!symbol) {
+                continue;
+            }
+
+            std::vector<std::pair<size_t, fs::path>> files;
+            for (const auto& file : fs::directory_iterator(entry.path())) {
+                if (auto index = segmentIndex(file.path().filename().string())) {
+                    files.emplace_back(*index, file.path());
+                }
+            }
+            std::sort(files.begin(), files.end());
+
+            auto log = std::make_unique<SymbolLog>();
+            log->symbol = *symbol;
+            log->directory = entry.path();
+            for (const auto& [index, path] : files) {
+                auto segment = std::make_unique<Segment>(path);
+                const SegmentHeader& header = *segment->header;
+                // The oldest segments may have been trimmed
+                if (log->segments.empty()) {
+                    log->base = header.first_sequence - 1;
+                }
+                if (header.first_sequence != log->base + log->size + 1) {
+                    throw std::runtime_error("Tick log segment out of sequence: " + path.string());
+                }
+                if (header.count > 0) {
+                    log->lastTimestamp = segment->timestamps[header.count - 1];
+                }
+                log->size += header.count;
+                log->nextSegment = index + 1;
+                log->segments.push_back(std::move(segment));
+            }
+            log->checkOrder();
+            logs.emplace(*symbol, std::move(log));
+        }
+    }
+
+    const TickLogStore::SymbolLog* TickLogStore::find(const std::string& symbol) const {
+        auto it = logs.find(symbol);
+        return it == logs.end() ? nullptr : it->second.get();
+    }
+
+    TickLogStore::SymbolLog& TickLogStore::open(const std::string& symbol) {
+        auto it = logs.find(symbol);
+        if (it != logs.end()) {
+            return *it->second;
+        }
+        if (symbol.empty()) {
+            throw std::invalid_argument("Symbol must not be empty");
+        }
+
+        auto log = std::make_unique<SymbolLog>();
+        log->symbol = symbol;
+        log->directory = fs::path(options.directory) / encodeSymbol(symbol);
+        fs::create_directories(log->directory);
+        return *logs.emplace(symbol, std::move(log)).first->second;
+    }
+
+    void TickLogStore::append(const StockQuote* quotes, size_t count) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        SymbolLog* log = nullptr;
+        for (size_t i = 0; i < count; ++i) {
+            const StockQuote& quote = quotes[i];
+            if (!log || quote.symbol != log->symbol) {
+                log = &open(quote.symbol);
+            }
+
+            if (log->segments.empty() || log->segments.back()->full()) {
+                auto path = log->directory / segmentName(log->nextSegment++);
+                log->segments.push_back(std::make_unique<Segment>(path, options.ticks_per_segment,
+                    log->base + log->size + 1));
+            }
+
+            int64_t timestamp = toStoredTimestamp(quote.timestamp);
+            if (log->size > 0 && timestamp < log->lastTimestamp) {
+                log->ordered = false;
+            }
+            log->segments.back()->push(timestamp, quote.price, quote.change_percent);
+            log->lastTimestamp = timestamp;
+            ++log->size;
+        }
+    }
+
+    std::vector<StockQuote> TickLogStore::latest(const std::string& symbol, int limit) {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        std::vector<StockQuote> history;
+        const SymbolLog* log = find(symbol);
+        if (!log) {
+            return history;
+        }
+
+        auto order = log->order();
+        uint64_t count = clampLimit(log->size, limit);
+        history.reserve(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            log->read(log->positionOf(order, log->size - 1 - i), history.emplace_back());
+        }
+        return history;
+    }
+
+    std::vector<StockQuote> TickLogStore::range(const std::string& symbol,
+        std::chrono::system_clock::time_point from,
+        std::chrono::system_clock::time_point to,
+        int limit) {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        std::vector<StockQuote> history;
+        const SymbolLog* log = find(symbol);
+        if (!log) {
+            return history;
+        }
+
+        auto order = log->order();
+        auto [first, last] = log->ranks(order, toStoredTimestamp(from), toStoredTimestamp(to));
+        last = first + clampLimit(last - first, limit);
+        history.reserve(last - first);
+        for (uint64_t rank = first; rank < last; ++rank) {
+            log->read(log->positionOf(order, rank), history.emplace_back());
+        }
+        return history;
+    }
+
+    PriceHistoryPage TickLogStore::page(const std::string& symbol, int limit,
+        std::optional<HistoryPageKey> after) {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        PriceHistoryPage page;
+        const SymbolLog* log = find(symbol);
+        if (!log) {
+            return page;
+        }
+
+        HistoryPageKey start = after.value_or(HistoryPageKey{
+            std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::max() });
+        auto order = log->order();
+        uint64_t end = partitionPoint(log->size, [&](uint64_t rank) {
+            HistoryPageKey key = log->keyAt(log->positionOf(order, rank));
+            return std::tie(key.timestamp, key.rowid) < std::tie(start.timestamp, start.rowid);
+        });
+
+        uint64_t count = clampLimit(end, limit);
+        HistoryPageKey last{};
+        page.quotes.reserve(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            uint64_t position = log->positionOf(order, end - 1 - i);
+            log->read(position, page.quotes.emplace_back());
+            last = log->keyAt(position);
+        }
+
+        // A short page means we reached the oldest row
+        if (limit > 0 && page.quotes.size() == static_cast<size_t>(limit)) {
+            page.next = last;
+        }
+        return page;
+    }
+
+    std::unique_ptr<PriceHistoryCursor::Source> TickLogStore::openCursor(const std::string& symbol,
+        std::chrono::system_clock::time_point from,
+        std::chrono::system_clock::time_point to) {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        const SymbolLog* log = find(symbol);
+        if (!log) {
+            return std::make_unique<Cursor>(*this, nullptr, std::vector<uint64_t>{}, 0, 0);
+        }
+
+        auto order = log->order();
+        auto [first, last] = log->ranks(order, toStoredTimestamp(from), toStoredTimestamp(to));
+        return std::make_unique<Cursor>(*this, log, std::move(order), first, last);
+    }
+
+    void TickLogStore::scanColumns(const std::string& symbol,
+        std::chrono::system_clock::time_point from,
+        std::chrono::system_clock::time_point to,
+        const std::function<void(const TickColumns&)>& visit) {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        const SymbolLog* log = find(symbol);
+        if (!log) {
+            return;
+        }
+
+        int64_t low = toStoredTimestamp(from);
+        int64_t high = toStoredTimestamp(to);
+        auto inRange = [&](int64_t timestamp) { return timestamp >= low && timestamp < high; };
+
+        for (const auto& segment : log->segments) {
+            const SegmentHeader& header = *segment->header;
+            if (header.count == 0 || header.max_timestamp < low || header.min_timestamp >= high) {
+                if (log->ordered && header.count > 0 && header.min_timestamp >= high) {
+                    break;
+                }
+                continue;
+            }
+
+            const int64_t* timestamps = segment->timestamps;
+            size_t count = static_cast<size_t>(header.count);
+            auto emit = [&](size_t first, size_t last) {
+                if (first < last) {
+                    visit(TickColumns{ timestamps + first, segment->prices + first, segment->changePercents + first,
+                        last - first, header.first_sequence + first });
+                }
+            };
+
+            if (header.sorted) {
+                emit(std::lower_bound(timestamps, timestamps + count, low) - timestamps,
+                    std::lower_bound(timestamps, timestamps + count, high) - timestamps);
+                continue;
+            }
+
+            // Out-of-order segment: every maximal run of matching rows
+            size_t row = 0;
+            while (row < count) {
+                while (row < count && !inRange(timestamps[row])) {
+                    ++row;
+                }
+                size_t first = row;
+                while (row < count && inRange(timestamps[row])) {
+                    ++row;
+                }
+                emit(first, row);
+            }
+        }
+    }
+
+    void TickLogStore::scan(const std::string& symbol,
+        std::chrono::system_clock::time_point from,
+        std::chrono::system_clock::time_point to,
+        const std::function<void(const StockQuote&)>& visit) {
+        StockQuote quote;
+        quote.symbol = symbol;
+        scanColumns(symbol, from, to, [&](const TickColumns& columns) {
+            for (size_t i = 0; i < columns.count; ++i) {
+                quote.price = columns.prices[i];
+                quote.timestamp = fromStoredTimestamp(columns.timestamps[i]);
+                double changePercent = columns.change_percents[i];
+                quote.change_percent = std::isnan(changePercent) ? std::nullopt : std::optional<double>(changePercent);
+                visit(quote);
+            }
+        });
+    }
+
+    std::vector<std::string> TickLogStore::symbols() {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        std::vector<std::string> symbols;
+        symbols.reserve(logs.size());
+        for (const auto& entry : logs) {
+            if (entry.second->size > 0) {
+                symbols.push_back(entry.first);
+            }
+        }
+        return symbols;
+    }
+
+    size_t TickLogStore::trim(const std::string& symbol, std::chrono::system_clock::time_point before,
+        size_t max_rows, const std::function<void(const std::vector<StockQuote>&)>& retire) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto it = logs.find(symbol);
+        if (it == logs.end()) {
+            return 0;
+        }
+        SymbolLog& log = *it->second;
+
+        int64_t cutoff = toStoredTimestamp(before);
+        size_t drop = 0;
+        uint64_t rows = 0;
+        while (rows < max_rows && drop + 1 < log.segments.size()
+            && log.segments[drop]->header->max_timestamp < cutoff) {
+            rows += log.segments[drop]->count();
+            ++drop;
+        }
+        if (rows == 0) {
+            return 0;
+        }
+
+        std::vector<StockQuote> retired;
+        retired.reserve(static_cast<size_t>(rows));
+        for (size_t i = 0; i < drop; ++i) {
+            const Segment& segment = *log.segments[i];
+            for (uint64_t row = 0; row < segment.count(); ++row) {
+                StockQuote& quote = retired.emplace_back();
+                quote.symbol = symbol;
+                quote.price = segment.prices[row];
+                quote.timestamp = fromStoredTimestamp(segment.timestamps[row]);
+                double changePercent = segment.changePercents[row];
+                quote.change_percent = std::isnan(changePercent) ? std::nullopt : std::optional<double>(changePercent);
+            }
+        }
+        retire(retired);
+
+        // Unmapped before they are deleted, oldest first, so a failure leaves the files on
+        // disk still in sequence
+        std::vector<fs::path> paths;
+        for (size_t i = 0; i < drop; ++i) {
+            paths.push_back(log.segments[i]->path);
+        }
+        log.segments.erase(log.segments.begin(), log.segments.begin() + static_cast<std::ptrdiff_t>(drop));
+        log.base += rows;
+        log.size -= rows;
+        log.checkOrder();
+
+        for (const auto& path : paths) {
+            std::error_code error;
+            if (!fs::remove(path, error) && error) {
+                throw std::runtime_error("Failed to delete tick log segment: " + path.string());
+            }
+        }
+        return static_cast<size_t>(rows);
+    }
+
+    void TickLogStore::sync() {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        for (auto& entry : logs) {
+            for (auto& segment : entry.second->segments) {
+                if (segment->dirty) {
+                    segment->file.flush();
+                    segment->dirty = false;
+                }
+            }
+        }
+    }
+}
@@ -8,28 +8,71 @@ namespace StockTracker {
 			price_val,
 			std::chrono::system_clock::now(),
 			std::nullopt,
-			"USD"
+			"USD",
+			std::nullopt
 		};
 	}
 
+	namespace {
+		int64_t toEpochMillis(std::chrono::system_clock::time_point time) {
+			return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+		}
+
+		std::chrono::system_clock::time_point fromEpochMillis(int64_t millis) {
+			return std::chrono::system_clock::time_point(std::chrono::milliseconds(millis));
+		}
+
+		void putOptional(json& j, const char* key, const std::optional<double>& value) {
+			if (value) {
+				j[key] = *value;
+			}
+		}
+
+		void getOptional(const json& j, const char* key, std::optional<double>& value) {
+			if (j.contains(key) && !j[key].is_null()) {
+				value = j[key].get<double>();
+			}
+			else {
+				value = std::nullopt;
+			}
+		}
+	}
+
+	void to_json(json& j, const QuoteIndicators& indicators) {
+		j = json::object();
+		putOptional(j, "sma", indicators.sma);
+		putOptional(j, "ema", indicators.ema);
+		putOptional(j, "vwap", indicators.vwap);
+		putOptional(j, "volatility", indicators.volatility);
+	}
+
+	void from_json(const json& j, QuoteIndicators& indicators) {
+		getOptional(j, "sma", indicators.sma);
+		getOptional(j, "ema", indicators.ema);
+		getOptional(j, "vwap", indicators.vwap);
+		getOptional(j, "volatility", indicators.volatility);
+	}
+
 	void to_json(json& j, const StockQuote& quote) {
 		j = json{
 			{"symbol", quote.symbol},
 			{"price", quote.price},
-			{"timestamp", quote.timestamp.time_since_epoch().count()},
+			{"timestamp", toEpochMillis(quote.timestamp)},
 			{"currency", quote.currency}
 		};
 
 		if (quote.change_percent.has_value()) {
 			j["change_percent"] = quote.change_percent.value();
 		}
+		if (quote.indicators) {
+			j["indicators"] = *quote.indicators;
+		}
 	}
 
 	void from_json(const json& j, StockQuote& quote) {
 		j.at("symbol").get_to(quote.symbol);
 		j.at("price").get_to(quote.price);
-		auto ts = j.at("timestamp").get<int64_t>();
-		quote.timestamp = std::chrono::system_clock::time_point(std::chrono::milliseconds(ts));
+		quote.timestamp = fromEpochMillis(j.at("timestamp").get<int64_t>());
 
 		// fallback to USD
 		quote.currency = j.value("currency", "USD");
@@ -41,6 +84,51 @@ namespace StockTracker {
 		else {
 			quote.change_percent = std::nullopt;
 		}
+
+		if (j.contains("indicators") && !j["indicators"].is_null()) {
+			quote.indicators = j["indicators"].get<QuoteIndicators>();
+		}
+		else {
+			quote.indicators = std::nullopt;
+		}
+	}
+
+	void to_json(json& j, const OhlcvBar& bar) {
+		j = json{
+			{"open_time", toEpochMillis(bar.open_time)},
+			{"interval", bar.interval.count()},
+			{"open", bar.open},
+			{"high", bar.high},
+			{"low", bar.low},
+			{"close", bar.close},
+			{"volume", bar.volume}
+		};
+	}
+
+	void from_json(const json& j, OhlcvBar& bar) {
+		bar.open_time = fromEpochMillis(j.at("open_time").get<int64_t>());
+		bar.interval = std::chrono::seconds(j.at("interval").get<int64_t>());
+		j.at("open").get_to(bar.open);
+		j.at("high").get_to(bar.high);
+		j.at("low").get_to(bar.low);
+		j.at("close").get_to(bar.close);
+		bar.volume = j.value("volume", uint64_t{ 0 });
+	}
+
+	void to_json(json& j, const BarQuery& query) {
+		j = json{
+			{"interval", query.interval.count()},
+			{"from", toEpochMillis(query.from)},
+			{"to", toEpochMillis(query.to)},
+			{"limit", query.limit}
+		};
+	}
+
+	void from_json(const json& j, BarQuery& query) {
+		query.interval = std::chrono::seconds(j.at("interval").get<int64_t>());
+		query.from = fromEpochMillis(j.at("from").get<int64_t>());
+		query.to = fromEpochMillis(j.at("to").get<int64_t>());
+		query.limit = j.value("limit", -1);
 	}
 	
 }
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "RateServerStub.h"
+#include "StockTracker/AsyncCurrencyService.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace StockTracker;
+using namespace std::chrono_literals;
+
+TEST(AsyncCurrencyServiceTest, ConvertsConcurrentRequests) {
+    Tests::RateServerStub stub;
+    AsyncCurrencyService currency(stub.endpoint);
+
+    std::vector<std::future<double>> results;
+    for (int i = 0; i < 20; ++i) {
+        results.push_back(currency.convertAsync(static_cast<double>(i), i % 2 ? "EUR" : "GBP"));
+    }
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_DOUBLE_EQ(results[i].get(), i * (i % 2 ? 0.92 : 0.79));
+    }
+    EXPECT_EQ(currency.inFlight(), 0u);
+}
+
+TEST(AsyncCurrencyServiceTest, ServiceErrorFailsTheFuture) {
+    Tests::RateServerStub stub;
+    stub.removeRate("CAD");
+    AsyncCurrencyService currency(stub.endpoint);
+    auto result = currency.convertAsync(1.0, "CAD");
+    EXPECT_THROW(result.get(), std::runtime_error);
+}
+
+TEST(AsyncCurrencyServiceTest, UnansweredRequestTimesOut) {
+    // Nothing listens here, so the request is never answered
+    AsyncCurrencyService currency("tcp://127.0.0.1:1", 2000ms);
+    auto started = std::chrono::steady_clock::now();
+    auto result = currency.convertAsync(1.0, "EUR", 50ms);
+    EXPECT_THROW(result.get(), std::runtime_error);
+    EXPECT_LT(std::chrono::steady_clock::now() - started, 1500ms);
+}
+
+// Callbacks run during shutdown must be able to call back into the service
+TEST(AsyncCurrencyServiceTest, ShutdownCallbacksMayResubmit) {
+    Tests::RateServerStub stub;
+    auto currency = std::make_unique<AsyncCurrencyService>(stub.endpoint);
+    AsyncCurrencyService* service = currency.get();   // reset() clears `currency` before destroying it
+
+    // Hold the I/O thread in a callback so the requests below are still queued at shutdown
+    std::promise<void> entered;
+    std::atomic<bool> release{ false };
+    currency->convertAsync(1.0, "EUR", [&](double, std::exception_ptr) {
+        entered.set_value();
+        while (!release) {
+            std::this_thread::sleep_for(1ms);
+        }
+    });
+    entered.get_future().wait();
+
+    std::atomic<int> failed{ 0 };
+    std::atomic<int> refused{ 0 };
+    for (int i = 0; i < 50; ++i) {
+        currency->convertAsync(1.0, "EUR", [&](double, std::exception_ptr error) {
+            if (error) {
+                ++failed;
+            }
+            try {
+                service->convertAsync(1.0, "EUR", [](double, std::exception_ptr) {});
+            }
+            catch (const std::logic_error&) {
+                ++refused;
+            }
+        });
+    }
+
+    std::thread releaser([&] {
+        std::this_thread::sleep_for(50ms);
+        release = true;
+    });
+    currency.reset();
+    releaser.join();
+
+    EXPECT_EQ(failed, 50);
+    EXPECT_EQ(refused, 50);
+}
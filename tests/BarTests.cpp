@@ -0,0 +1,159 @@
+#include "TestData.h"
+#include "StockTracker/DatabaseService.h"
+#include <gtest/gtest.h>
+#include <tuple>
+
+using namespace StockTracker;
+using namespace std::chrono_literals;
+
+namespace {
+
+    auto fields(const OhlcvBar& bar) {
+        return std::make_tuple(bar.open_time, bar.interval, bar.open, bar.high, bar.low, bar.close, bar.volume);
+    }
+
+    OhlcvBar bar(int64_t openMillis, std::chrono::seconds interval,
+        double open, double high, double low, double close, uint64_t volume) {
+        return OhlcvBar{ Tests::atBar(openMillis), interval, open, high, low, close, volume };
+    }
+
+    void expectSameBars(const std::vector<OhlcvBar>& expected, const std::vector<OhlcvBar>& actual) {
+        ASSERT_EQ(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_EQ(fields(expected[i]), fields(actual[i])) << "bar " << i;
+        }
+    }
+
+    std::vector<OhlcvBar> barsOf(DatabaseService& db, std::chrono::seconds interval, int limit = -1) {
+        BarQuery query;
+        query.interval = interval;
+        query.from = Tests::atBar(0);
+        query.to = Tests::atBar(24 * 3600 * 1000);
+        query.limit = limit;
+        return db.getBars("AAPL", query);
+    }
+
+    void save(DatabaseService& db, double price, int64_t millis) {
+        db.savePrice(Tests::makeQuote("AAPL", price, Tests::atBar(millis)));
+    }
+}
+
+TEST(BarTest, BucketsStartOnTheInterval) {
+    auto minute = Tests::atBar(60'000);
+    EXPECT_EQ(BarAggregator::bucketStart(minute, 1min), minute);
+    EXPECT_EQ(BarAggregator::bucketStart(minute - 1ns, 1min), minute - 1min);
+    EXPECT_EQ(BarAggregator::bucketStart(minute + 59'999ms, 1min), minute);
+    EXPECT_EQ(BarAggregator::bucketStart(minute + 59'999ms, 1h), Tests::atBar(0));
+
+    // Daily bars start at midnight UTC, also before the epoch
+    std::chrono::system_clock::time_point epoch;
+    EXPECT_EQ(BarAggregator::bucketStart(epoch + 25h, 24h), epoch + 24h);
+    EXPECT_EQ(BarAggregator::bucketStart(epoch - 1h, 24h), epoch - 24h);
+    EXPECT_EQ(BarAggregator::bucketStart(epoch - 24h, 24h), epoch - 24h);
+}
+
+TEST(BarTest, TicksOnABoundaryOpenTheNextBar) {
+    DatabaseService db(Tests::tempDbPath("bars-boundaries"));
+    db.enableBars(BarAggregatorOptions{ { 1min, 1h } });
+    save(db, 10.0, 0);
+    save(db, 12.0, 30'000);
+    save(db, 11.0, 59'999);
+    save(db, 20.0, 60'000);
+    save(db, 18.0, 3'600'000);
+
+    expectSameBars({
+        bar(0, 1min, 10.0, 12.0, 10.0, 11.0, 3),
+        bar(60'000, 1min, 20.0, 20.0, 20.0, 20.0, 1),
+        bar(3'600'000, 1min, 18.0, 18.0, 18.0, 18.0, 1) }, barsOf(db, 1min));
+    expectSameBars({
+        bar(0, 1h, 10.0, 20.0, 10.0, 20.0, 4),
+        bar(3'600'000, 1h, 18.0, 18.0, 18.0, 18.0, 1) }, barsOf(db, 1h));
+    expectSameBars({ bar(0, 1min, 10.0, 12.0, 10.0, 11.0, 3) }, barsOf(db, 1min, 1));
+}
+
+TEST(BarTest, StoredBarsMergeWithOpenBars) {
+    auto path = Tests::tempDbPath("bars-merge");
+    {
+        DatabaseService db(path);
+        db.enableBars(BarAggregatorOptions{ { 1min } });
+        save(db, 10.0, 1'000);
+        save(db, 15.0, 2'000);
+        // Writes the open bar; the aggregator starts a new delta for the same bar
+        db.flush();
+
+        save(db, 8.0, 3'000);
+        save(db, 9.0, 4'000);
+        auto expected = bar(0, 1min, 10.0, 15.0, 8.0, 9.0, 4);
+        expectSameBars({ expected }, barsOf(db, 1min));
+
+        db.flush();
+        expectSameBars({ expected }, barsOf(db, 1min));
+    }
+
+    // Both deltas were upserted into one row
+    DatabaseService reopened(path);
+    reopened.enableBars(BarAggregatorOptions{ { 1min } });
+    expectSameBars({ bar(0, 1min, 10.0, 15.0, 8.0, 9.0, 4) }, barsOf(reopened, 1min));
+}
+
+TEST(BarTest, LateTicksLandInClosedBars) {
+    DatabaseService db(Tests::tempDbPath("bars-late"));
+    db.enableBars(BarAggregatorOptions{ { 1min } });
+    save(db, 10.0, 10'000);
+    save(db, 11.0, 20'000);
+    save(db, 30.0, 70'000);     // Closes and writes the first bar
+
+    // Before the first bar's open, between its ticks, and after its close
+    save(db, 5.0, 1'000);
+    save(db, 40.0, 15'000);
+    save(db, 12.0, 50'000);
+    auto expected = std::vector<OhlcvBar>{
+        bar(0, 1min, 5.0, 40.0, 5.0, 12.0, 5),
+        bar(60'000, 1min, 30.0, 30.0, 30.0, 30.0, 1) };
+    expectSameBars(expected, barsOf(db, 1min));
+
+    db.flush();
+    expectSameBars(expected, barsOf(db, 1min));
+}
+
+TEST(BarTest, RebuildCoversTicksStoredBeforeBarsWereEnabled) {
+    DatabaseService db(Tests::tempDbPath("bars-rebuild"));
+    save(db, 10.0, 10'000);
+    save(db, 14.0, 20'000);
+    save(db, 12.0, 70'000);
+
+    db.enableBars(BarAggregatorOptions{ { 1min, 1h } });
+    save(db, 13.0, 80'000);
+    expectSameBars({ bar(60'000, 1min, 13.0, 13.0, 13.0, 13.0, 1) }, barsOf(db, 1min));
+
+    // Any part of a bar rebuilds all of it, including the tick saved with bars enabled
+    db.rebuildBars("AAPL", Tests::atBar(15'000), Tests::atBar(61'000));
+    expectSameBars({
+        bar(0, 1min, 10.0, 14.0, 10.0, 14.0, 2),
+        bar(60'000, 1min, 12.0, 13.0, 12.0, 13.0, 2) }, barsOf(db, 1min));
+    expectSameBars({ bar(0, 1h, 10.0, 14.0, 10.0, 13.0, 4) }, barsOf(db, 1h));
+
+    // Rebuilding again doesn't count the ticks twice
+    db.rebuildBars("AAPL", Tests::atBar(0), Tests::atBar(3'600'000));
+    expectSameBars({ bar(0, 1h, 10.0, 14.0, 10.0, 13.0, 4) }, barsOf(db, 1h));
+
+    // Later ticks carry on from the rebuilt bars
+    save(db, 20.0, 90'000);
+    expectSameBars({ bar(0, 1h, 10.0, 20.0, 10.0, 20.0, 5) }, barsOf(db, 1h));
+}
+
+TEST(BarTest, IntervalsThatArentKeptAreRejected) {
+    DatabaseService db(Tests::tempDbPath("bars-intervals"));
+    db.enableBars(BarAggregatorOptions{ { 1min } });
+    EXPECT_THROW(barsOf(db, 5min), std::invalid_argument);
+
+    // A retention tier keeps its interval too
+    RetentionOptions retention;
+    retention.tiers = { { 1h, 0h } };
+    db.enableRetention(retention);
+    EXPECT_NO_THROW(barsOf(db, 1h));
+    EXPECT_THROW(barsOf(db, 5min), std::invalid_argument);
+
+    DatabaseService disabled(Tests::tempDbPath("bars-disabled"));
+    EXPECT_THROW(disabled.rebuildBars("AAPL", Tests::atBar(0), Tests::atBar(1)), std::logic_error);
+}
@@ -0,0 +1,387 @@
+#include "StockTracker/BinaryCodec.h"
+#include "StockTracker/HistoryCodec.h"
+#include "StockTracker/Messages.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+
+using namespace StockTracker;
+using namespace std::chrono;
+
+namespace {
+
+    // Whole milliseconds, the resolution every time field travels at
+    system_clock::time_point epochMillis(int64_t millis) {
+        return system_clock::time_point(milliseconds(millis));
+    }
+
+    // With a sub-millisecond part, which the wire drops
+    StockQuote makeQuote(const std::string& symbol, double price, int64_t millis) {
+        return StockQuote{ symbol, price, epochMillis(millis) + microseconds(250), std::nullopt, "USD", std::nullopt };
+    }
+
+    system_clock::time_point wireTimestamp(const StockQuote& quote) {
+        return time_point_cast<milliseconds>(quote.timestamp);
+    }
+
+    std::vector<StockQuote> history(size_t rows) {
+        std::vector<StockQuote> quotes;
+        for (size_t i = 0; i < rows; ++i) {
+            auto quote = makeQuote("AAPL", 180.0 + 0.25 * static_cast<double>(i % 7), 1'700'000'000'000 + 1000 * static_cast<int64_t>(i));
+            if (i % 3 != 0) {
+                quote.change_percent = 0.125 * static_cast<double>(i);
+            }
+            quotes.push_back(quote);
+        }
+        return quotes;
+    }
+
+    // One message per MessageType with every field that type uses, plus a columnar history
+    std::vector<Message> sampleMessages() {
+        std::vector<Message> messages;
+        messages.push_back(Message::makeSubscribe("AAPL"));
+        messages.push_back(Message::makeUnsubscribe("MSFT"));
+        messages.push_back(Message::makeQuery("NVDA"));
+
+        auto quote = makeQuote("AAPL", 189.5, 1'700'000'000'123);
+        quote.change_percent = -0.75;
+        quote.indicators = QuoteIndicators{ 188.25, std::nullopt, 189.0, 0.0125 };
+        auto update = Message::makeQuoteUpdate(quote);
+        update.sentAt = 123'456'789;
+        messages.push_back(update);
+
+        messages.push_back(Message::makeSubscriptionsList({ "AAPL", "MSFT", "" }, 7));
+        messages.push_back(Message::makeRequestSubscriptions(5));
+        messages.push_back(Message::makeRequestPriceHistory("AAPL", HistoryEncoding::Columnar, epochMillis(1'700'000'000'000)));
+        messages.push_back(Message::makePriceHistory("AAPL", history(5)));
+        messages.push_back(Message::makePriceHistory("AAPL", history(40), HistoryEncoding::Columnar, epochMillis(1'699'999'999'000)));
+        messages.push_back(Message::makeSetCurrency("EUR"));
+        messages.push_back(Message::makeError("Symbol not found: ZZZZ"));
+
+        auto batch = Message::makeQuoteBatch({ makeQuote("AAPL", 1.5, 10), makeQuote("MSFT", 2.5, 20), makeQuote("NVDA", 3.5, 30) });
+        batch.sentAt = -1;
+        messages.push_back(batch);
+
+        MetricsSnapshot snapshot;
+        snapshot.taken_at = epochMillis(1'700'000'000'500);
+        snapshot.metrics.push_back(MetricStats{ "socket.send.quote_update", 1000, 2, 64000, 900, 800, 1500, 4000, 9000, 250000 });
+        snapshot.metrics.push_back(MetricStats{ "db.save_price", 1, 0, 0, 0, 0, 0, 0, 0, 0 });
+        messages.push_back(Message::makeStats(snapshot));
+
+        messages.push_back(Message::makeRequestBars("AAPL", BarQuery{ seconds(300), epochMillis(1'700'000'000'000), epochMillis(1'700'003'600'000), 12 }));
+        messages.push_back(Message::makeBarHistory("AAPL", {
+            OhlcvBar{ epochMillis(1'700'000'000'000), seconds(60), 10.0, 12.5, 9.75, 11.0, 42 },
+            OhlcvBar{ epochMillis(1'700'000'060'000), seconds(60), 11.0, 11.0, 11.0, 11.0, 1 } }));
+        messages.push_back(Message::makeSubscriptionsDelta(SubscriptionDelta{ 9, false, { "NVDA" }, { "MSFT", "TSLA" } }));
+        return messages;
+    }
+
+    void expectSameQuote(const StockQuote& sent, const StockQuote& received) {
+        EXPECT_EQ(sent.symbol, received.symbol);
+        EXPECT_EQ(sent.price, received.price);
+        EXPECT_EQ(wireTimestamp(sent), received.timestamp);
+        EXPECT_EQ(sent.change_percent, received.change_percent);
+        EXPECT_EQ(sent.currency, received.currency);
+        ASSERT_EQ(sent.indicators.has_value(), received.indicators.has_value());
+        if (sent.indicators) {
+            EXPECT_EQ(sent.indicators->sma, received.indicators->sma);
+            EXPECT_EQ(sent.indicators->ema, received.indicators->ema);
+            EXPECT_EQ(sent.indicators->vwap, received.indicators->vwap);
+            EXPECT_EQ(sent.indicators->volatility, received.indicators->volatility);
+        }
+    }
+
+    void expectSameQuotes(const std::optional<std::vector<StockQuote>>& sent, const std::optional<std::vector<StockQuote>>& received) {
+        ASSERT_EQ(sent.has_value(), received.has_value());
+        if (sent) {
+            ASSERT_EQ(sent->size(), received->size());
+            for (size_t i = 0; i < sent->size(); ++i) {
+                expectSameQuote((*sent)[i], (*received)[i]);
+            }
+        }
+    }
+
+    void expectSameMessage(const Message& sent, const Message& received) {
+        EXPECT_EQ(sent.type, received.type);
+        EXPECT_EQ(sent.symbol, received.symbol);
+        EXPECT_EQ(sent.currency, received.currency);
+        ASSERT_EQ(sent.quote.has_value(), received.quote.has_value());
+        if (sent.quote) {
+            expectSameQuote(*sent.quote, *received.quote);
+        }
+        EXPECT_EQ(sent.error, received.error);
+        expectSameQuotes(sent.priceHistory, received.priceHistory);
+        EXPECT_EQ(sent.subscriptions, received.subscriptions);
+        expectSameQuotes(sent.quotes, received.quotes);
+
+        ASSERT_EQ(sent.stats.has_value(), received.stats.has_value());
+        if (sent.stats) {
+            EXPECT_EQ(sent.stats->taken_at, received.stats->taken_at);
+            ASSERT_EQ(sent.stats->metrics.size(), received.stats->metrics.size());
+            for (size_t i = 0; i < sent.stats->metrics.size(); ++i) {
+                const auto& a = sent.stats->metrics[i];
+                const auto& b = received.stats->metrics[i];
+                EXPECT_EQ(a.name, b.name);
+                EXPECT_EQ(a.count, b.count);
+                EXPECT_EQ(a.errors, b.errors);
+                EXPECT_EQ(a.bytes, b.bytes);
+                EXPECT_EQ(a.mean_ns, b.mean_ns);
+                EXPECT_EQ(a.p50_ns, b.p50_ns);
+                EXPECT_EQ(a.p90_ns, b.p90_ns);
+                EXPECT_EQ(a.p99_ns, b.p99_ns);
+                EXPECT_EQ(a.p999_ns, b.p999_ns);
+                EXPECT_EQ(a.max_ns, b.max_ns);
+            }
+        }
+
+        ASSERT_EQ(sent.barQuery.has_value(), received.barQuery.has_value());
+        if (sent.barQuery) {
+            EXPECT_EQ(sent.barQuery->interval, received.barQuery->interval);
+            EXPECT_EQ(sent.barQuery->from, received.barQuery->from);
+            EXPECT_EQ(sent.barQuery->to, received.barQuery->to);
+            EXPECT_EQ(sent.barQuery->limit, received.barQuery->limit);
+        }
+
+        ASSERT_EQ(sent.bars.has_value(), received.bars.has_value());
+        if (sent.bars) {
+            ASSERT_EQ(sent.bars->size(), received.bars->size());
+            for (size_t i = 0; i < sent.bars->size(); ++i) {
+                const auto& a = (*sent.bars)[i];
+                const auto& b = (*received.bars)[i];
+                EXPECT_EQ(a.open_time, b.open_time);
+                EXPECT_EQ(a.interval, b.interval);
+                EXPECT_EQ(a.open, b.open);
+                EXPECT_EQ(a.high, b.high);
+                EXPECT_EQ(a.low, b.low);
+                EXPECT_EQ(a.close, b.close);
+                EXPECT_EQ(a.volume, b.volume);
+            }
+        }
+
+        EXPECT_EQ(sent.historyEncoding, received.historyEncoding);
+        EXPECT_EQ(sent.sentAt, received.sentAt);
+        EXPECT_EQ(sent.since, received.since);
+        EXPECT_EQ(sent.subscriptionsVersion, received.subscriptionsVersion);
+        EXPECT_EQ(sent.removedSubscriptions, received.removedSubscriptions);
+    }
+
+    std::string binaryFrame(const Message& msg) {
+        std::string frame;
+        to_binary(frame, msg);
+        return frame;
+    }
+
+    Message fromBinary(const std::string& frame) {
+        Message msg{};
+        from_binary(frame.data(), frame.size(), msg);
+        return msg;
+    }
+
+    // Minimal valid binary frame header: format, type, then `fields`
+    std::string frameHeader(MessageType type, uint64_t fields) {
+        std::string frame;
+        frame += static_cast<char>(BINARY_FORMAT_V1);
+        frame += static_cast<char>(type);
+        for (; fields >= 0x80; fields >>= 7) {
+            frame += static_cast<char>(fields | 0x80);
+        }
+        frame += static_cast<char>(fields);
+        return frame;
+    }
+}
+
+TEST(CodecTest, SamplesCoverEveryMessageType) {
+    std::set<MessageType> types;
+    for (const auto& msg : sampleMessages()) {
+        types.insert(msg.type);
+    }
+    EXPECT_EQ(types.size(), MESSAGE_TYPE_COUNT);
+}
+
+TEST(CodecTest, JsonRoundTrip) {
+    for (const auto& sent : sampleMessages()) {
+        SCOPED_TRACE(json(sent.type).get<std::string>());
+        json j = sent;
+        auto received = json::parse(j.dump()).get<Message>();
+        expectSameMessage(sent, received);
+    }
+}
+
+TEST(CodecTest, BinaryRoundTrip) {
+    for (const auto& sent : sampleMessages()) {
+        SCOPED_TRACE(json(sent.type).get<std::string>());
+        auto frame = binaryFrame(sent);
+        ASSERT_TRUE(isBinaryFrame(frame.data(), frame.size()));
+        expectSameMessage(sent, fromBinary(frame));
+    }
+}
+
+TEST(CodecTest, QuoteTimestampsTravelAsMilliseconds) {
+    auto now = system_clock::now();
+    auto quote = Message::makeQuoteUpdate(StockQuote{ "AAPL", 1.0, now, std::nullopt, "USD", std::nullopt });
+    auto expected = time_point_cast<milliseconds>(now);
+
+    EXPECT_EQ(json(quote).at("quote").at("timestamp").get<int64_t>(), expected.time_since_epoch().count());
+    EXPECT_EQ(json::parse(json(quote).dump()).get<Message>().quote->timestamp, expected);
+    EXPECT_EQ(fromBinary(binaryFrame(quote)).quote->timestamp, expected);
+
+    std::vector<StockQuote> rows{ *quote.quote, *quote.quote };
+    rows[1].timestamp += seconds(1);
+    auto columnar = fromBinary(binaryFrame(Message::makePriceHistory("AAPL", rows, HistoryEncoding::Columnar)));
+    ASSERT_TRUE(columnar.priceHistory);
+    EXPECT_EQ(columnar.priceHistory->at(0).timestamp, expected);
+    EXPECT_EQ(columnar.priceHistory->at(1).timestamp, expected + seconds(1));
+}
+
+TEST(CodecTest, JsonFramesAreNotBinary) {
+    for (const auto& sent : sampleMessages()) {
+        auto text = json(sent).dump();
+        EXPECT_FALSE(isBinaryFrame(text.data(), text.size()));
+    }
+    EXPECT_FALSE(isBinaryFrame("", 0));
+}
+
+// A Message reused across receives must not keep fields from the previous one
+TEST(CodecTest, ReusedMessageDropsAbsentFields) {
+    auto messages = sampleMessages();
+    Message binary{};
+    Message text{};
+    for (size_t round = 0; round < 2; ++round) {
+        for (const auto& sent : messages) {
+            SCOPED_TRACE(json(sent.type).get<std::string>());
+            auto frame = binaryFrame(sent);
+            from_binary(frame.data(), frame.size(), binary);
+            expectSameMessage(sent, binary);
+
+            from_json(json::parse(json(sent).dump()), text);
+            expectSameMessage(sent, text);
+        }
+        std::reverse(messages.begin(), messages.end());
+    }
+}
+
+TEST(CodecTest, BinaryRejectsTruncatedFrames) {
+    for (const auto& sent : sampleMessages()) {
+        SCOPED_TRACE(json(sent.type).get<std::string>());
+        auto frame = binaryFrame(sent);
+        for (size_t size = 0; size < frame.size(); ++size) {
+            Message msg{};
+            EXPECT_THROW(from_binary(frame.data(), size, msg), std::runtime_error) << "prefix of " << size << " bytes";
+        }
+    }
+}
+
+TEST(CodecTest, JsonRejectsTruncatedFrames) {
+    for (const auto& sent : sampleMessages()) {
+        SCOPED_TRACE(json(sent.type).get<std::string>());
+        auto text = json(sent).dump();
+        for (size_t size = 0; size < text.size(); ++size) {
+            EXPECT_THROW(json::parse(text.substr(0, size)), json::parse_error) << "prefix of " << size << " bytes";
+        }
+    }
+}
+
+TEST(CodecTest, BinaryRejectsUnknownFormat) {
+    auto frame = binaryFrame(Message::makeSubscribe("AAPL"));
+    frame[0] = static_cast<char>(BINARY_FORMAT_V1 + 1);
+    EXPECT_THROW(fromBinary(frame), std::runtime_error);
+}
+
+TEST(CodecTest, BinaryRejectsUnknownMessageType) {
+    auto frame = binaryFrame(Message::makeSubscribe("AAPL"));
+    frame[1] = static_cast<char>(MESSAGE_TYPE_COUNT);
+    EXPECT_THROW(fromBinary(frame), std::runtime_error);
+
+    frame[1] = static_cast<char>(MESSAGE_TYPE_COUNT - 1);
+    EXPECT_EQ(fromBinary(frame).type, static_cast<MessageType>(MESSAGE_TYPE_COUNT - 1));
+}
+
+TEST(CodecTest, BinaryRejectsOverlongVarint) {
+    std::string frame = frameHeader(MessageType::Subscribe, 0).substr(0, 2);
+    frame.append(10, static_cast<char>(0x80));
+    frame += '\0';
+    EXPECT_THROW(fromBinary(frame), std::runtime_error);
+}
+
+TEST(CodecTest, BinaryRejectsOversizedCounts) {
+    // Subscriptions claiming more entries than the frame has bytes left
+    std::string frame = frameHeader(MessageType::SubscriptionsList, 1 << 3);
+    frame += '\0';  // symbol
+    frame += '\0';  // currency
+    frame += static_cast<char>(0x7F);
+    frame.append(10, '\0');
+    EXPECT_THROW(fromBinary(frame), std::runtime_error);
+
+    // A string longer than the frame
+    frame = frameHeader(MessageType::Subscribe, 0);
+    frame += static_cast<char>(0x20);
+    frame += "AAPL";
+    EXPECT_THROW(fromBinary(frame), std::runtime_error);
+
+    // A huge count must fail before anything is allocated for it
+    frame = frameHeader(MessageType::QuoteBatch, 1 << 4);
+    frame += '\0';
+    frame += '\0';
+    frame.append(9, static_cast<char>(0xFF));
+    frame += static_cast<char>(0x01);
+    EXPECT_THROW(fromBinary(frame), std::runtime_error);
+}
+
+TEST(CodecTest, BinaryRejectsUnknownHistoryEncoding) {
+    auto frame = binaryFrame(Message::makeRequestPriceHistory("AAPL", HistoryEncoding::Columnar));
+    ASSERT_EQ(frame.back(), static_cast<char>(HistoryEncoding::Columnar));
+    frame.back() = static_cast<char>(0x7F);
+    EXPECT_THROW(fromBinary(frame), std::runtime_error);
+}
+
+TEST(CodecTest, BinaryRejectsCorruptPackedHistory) {
+    std::string block;
+    encodeHistory(block, history(40));
+
+    // The frame itself is intact, only the block inside it is cut short
+    std::string frame = frameHeader(MessageType::PriceHistoryResponse, (1 << 8) | (1 << 9));
+    frame += '\0';
+    frame += '\0';
+    frame += static_cast<char>(HistoryEncoding::Columnar);
+    frame += static_cast<char>(8);
+    frame += block.substr(0, 8);
+    EXPECT_THROW(fromBinary(frame), std::runtime_error);
+}
+
+TEST(CodecTest, JsonRejectsMalformedMessages) {
+    EXPECT_THROW(json::parse(R"({"symbol":"AAPL"})").get<Message>(), json::exception);
+    EXPECT_THROW(json::parse(R"({"type":"subscribe"})").get<Message>(), json::exception);
+    EXPECT_THROW(json::parse(R"({"type":"quote_update","symbol":"AAPL","quote":{"symbol":"AAPL"}})").get<Message>(), json::exception);
+    EXPECT_THROW(json::parse(R"({"type":"subscriptions_list","symbol":"","subscriptions":"AAPL"})").get<Message>(), json::exception);
+    EXPECT_THROW(json::parse(R"({"type":"price_history_response","symbol":"AAPL","historyEncoding":"columnar","packedHistory":"abc"})").get<Message>(), std::runtime_error);
+    EXPECT_THROW(json::parse(R"({"type":"price_history_response","symbol":"AAPL","historyEncoding":"columnar","packedHistory":"////"})").get<Message>(), std::runtime_error);
+}
+
+TEST(CodecTest, BinaryRejectsUnknownBits) {
+    // An unknown bit in "fields"
+    std::string frame = frameHeader(MessageType::Subscribe, uint64_t(1) << 14);
+    frame += '\0';
+    frame += '\0';
+    EXPECT_THROW(fromBinary(frame), std::runtime_error);
+
+    auto quote = makeQuote("AAPL", 1.0, 1000);
+    quote.indicators = QuoteIndicators{ 1.0, std::nullopt, std::nullopt, std::nullopt };
+    auto valid = binaryFrame(Message::makeQuoteUpdate(quote));
+    ASSERT_NO_THROW(fromBinary(valid));
+
+    // Header (3 bytes), frame symbol "AAPL" and empty currency, then the quote's symbol, price
+    // and timestamp; its flags come next
+    size_t flagsAt = 3 + 5 + 1 + 5 + 8 + 8;
+    ASSERT_EQ(valid[flagsAt], 0x02);
+    frame = valid;
+    frame[flagsAt] |= 0x04;
+    EXPECT_THROW(fromBinary(frame), std::runtime_error);
+
+    // The indicators byte is right after the quote's currency
+    size_t indicatorsAt = flagsAt + 1 + 4;
+    ASSERT_EQ(valid[indicatorsAt], 0x01);
+    frame = valid;
+    frame[indicatorsAt] |= 0x10;
+    EXPECT_THROW(fromBinary(frame), std::runtime_error);
+}
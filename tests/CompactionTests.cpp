@@ -0,0 +1,227 @@
+#include "TestData.h"
+#include "StockTracker/DatabaseService.h"
+#include "StockTracker/TickLogStore.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+using namespace StockTracker;
+using namespace std::chrono_literals;
+
+namespace {
+
+    const std::chrono::hours RAW_TICKS{ 24 };
+
+    // Start of an hour well past the raw tick retention
+    std::chrono::system_clock::time_point expiredHour(std::chrono::hours age = 72h) {
+        return BarAggregator::bucketStart(std::chrono::system_clock::now() - age, 1h);
+    }
+
+    // `count` ticks 10 seconds apart from `start`, with prices that move up and down
+    std::vector<StockQuote> ticksFrom(std::chrono::system_clock::time_point start, int count) {
+        std::vector<StockQuote> quotes;
+        for (int i = 0; i < count; ++i) {
+            quotes.push_back(Tests::makeQuote("AAPL", 100.0 + (i * 7) % 13, start + std::chrono::seconds(10 * i)));
+        }
+        return quotes;
+    }
+
+    // Bars built by hand from the ticks they should roll up
+    std::vector<OhlcvBar> expectedBars(const std::vector<StockQuote>& quotes, std::chrono::seconds interval) {
+        std::map<std::chrono::system_clock::time_point, OhlcvBar> bars;
+        for (const auto& quote : quotes) {
+            auto start = BarAggregator::bucketStart(quote.timestamp, interval);
+            auto it = bars.find(start);
+            if (it == bars.end()) {
+                bars.emplace(start, OhlcvBar{ start, interval, quote.price, quote.price, quote.price, quote.price, 1 });
+                continue;
+            }
+            OhlcvBar& bar = it->second;
+            bar.high = std::max(bar.high, quote.price);
+            bar.low = std::min(bar.low, quote.price);
+            bar.close = quote.price;
+            ++bar.volume;
+        }
+
+        std::vector<OhlcvBar> result;
+        for (const auto& entry : bars) {
+            result.push_back(entry.second);
+        }
+        return result;
+    }
+
+    void expectSameBars(const std::vector<OhlcvBar>& expected, const std::vector<OhlcvBar>& actual) {
+        auto fields = [](const OhlcvBar& bar) {
+            return std::make_tuple(bar.open_time, bar.interval, bar.open, bar.high, bar.low, bar.close, bar.volume);
+        };
+        ASSERT_EQ(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_EQ(fields(expected[i]), fields(actual[i])) << "bar " << i;
+        }
+    }
+
+    std::vector<OhlcvBar> barsIn(DatabaseService& db, std::chrono::seconds interval,
+        std::chrono::system_clock::time_point from, std::chrono::system_clock::time_point to) {
+        BarQuery query;
+        query.interval = interval;
+        query.from = from;
+        query.to = to;
+        return db.getBars("AAPL", query);
+    }
+
+    RetentionOptions retention(std::vector<RetentionTier> tiers, size_t batch_size = 1000) {
+        RetentionOptions options;
+        options.raw_ticks = RAW_TICKS;
+        options.tiers = std::move(tiers);
+        options.batch_size = batch_size;
+        return options;
+    }
+
+    void save(DatabaseService& db, const std::vector<StockQuote>& quotes) {
+        for (const auto& quote : quotes) {
+            db.savePrice(quote);
+        }
+    }
+}
+
+TEST(CompactionTest, RolledUpBarsMatchTheRemovedTicks) {
+    for (bool tickLog : { false, true }) {
+        SCOPED_TRACE(tickLog ? "tick log" : "sqlite");
+        auto path = Tests::tempDbPath("compact-rollup");
+        std::unique_ptr<PriceStore> store;
+        if (tickLog) {
+            // Whole segments of expired ticks, so the tick log can drop all of them
+            store = std::make_unique<TickLogStore>(TickLogOptions{ Tests::tempDirPath("compact-rollup-ticks"), 10 });
+        }
+        DatabaseService db(path, std::move(store));
+        db.enableRetention(retention({ { 1min, 0h }, { 1h, 0h } }));
+
+        auto hour = expiredHour();
+        auto expired = ticksFrom(hour, 30);
+        auto recent = ticksFrom(std::chrono::system_clock::now() - 1h, 5);
+        save(db, expired);
+        save(db, recent);
+
+        auto stats = db.compact();
+        EXPECT_TRUE(stats.complete);
+        EXPECT_EQ(stats.ticks_removed, expired.size());
+        EXPECT_EQ(stats.bars_written, expectedBars(expired, 1min).size() + 1);
+
+        expectSameBars(expectedBars(expired, 1min), barsIn(db, 1min, hour, hour + 1h));
+        expectSameBars(expectedBars(expired, 1h), barsIn(db, 1h, hour, hour + 1h));
+        EXPECT_EQ(db.getPriceHistory("AAPL", 100).size(), recent.size());
+        EXPECT_TRUE(db.getPriceHistoryRange("AAPL", hour, hour + 1h).empty());
+
+        // Nothing is left to roll up twice
+        auto again = db.compact();
+        EXPECT_EQ(again.ticks_removed, 0u);
+        EXPECT_EQ(again.bars_written, 0u);
+        expectSameBars(expectedBars(expired, 1h), barsIn(db, 1h, hour, hour + 1h));
+    }
+}
+
+TEST(CompactionTest, RawTicksAreCutAtTheRetentionBoundary) {
+    DatabaseService db(Tests::tempDbPath("compact-boundary"));
+    db.enableRetention(retention({ { 1min, 0h } }));
+
+    auto cutoff = std::chrono::system_clock::now() - RAW_TICKS;
+    auto before = Tests::makeQuote("AAPL", 1.0, cutoff - 5s);
+    auto after = Tests::makeQuote("AAPL", 2.0, cutoff + 5s);
+    save(db, { before, after });
+
+    EXPECT_EQ(db.compact().ticks_removed, 1u);
+    auto history = db.getPriceHistory("AAPL", 10);
+    ASSERT_EQ(history.size(), 1u);
+    EXPECT_EQ(history[0].price, after.price);
+
+    // Only the expired tick was rolled up
+    expectSameBars(expectedBars({ before }, 1min), barsIn(db, 1min, cutoff - 1h, cutoff + 1h));
+}
+
+TEST(CompactionTest, StoppedCompactionResumes) {
+    DatabaseService db(Tests::tempDbPath("compact-resume"));
+    db.enableRetention(retention({ { 1min, 0h } }, 10));
+    auto hour = expiredHour();
+    auto expired = ticksFrom(hour, 35);
+    save(db, expired);
+
+    size_t calls = 0;
+    auto first = db.compact([&](const CompactionStats& stats) {
+        ++calls;
+        EXPECT_EQ(stats.ticks_removed, 10u);
+        return false;
+    });
+    EXPECT_EQ(calls, 1u);
+    EXPECT_FALSE(first.complete);
+    EXPECT_EQ(first.batches, 1u);
+    EXPECT_EQ(first.ticks_removed, 10u);
+    EXPECT_EQ(db.getPriceHistory("AAPL", 100).size(), 25u);
+
+    auto second = db.compact();
+    EXPECT_TRUE(second.complete);
+    EXPECT_EQ(second.ticks_removed, 25u);
+    EXPECT_EQ(second.batches, 3u);
+    EXPECT_TRUE(db.getPriceHistory("AAPL", 100).empty());
+
+    // Bars split across batches and calls merge into the same rollup
+    expectSameBars(expectedBars(expired, 1min), barsIn(db, 1min, hour, hour + 1h));
+}
+
+TEST(CompactionTest, BarsExpireAfterTheirTierKeepTime) {
+    DatabaseService db(Tests::tempDbPath("compact-tier-keep"));
+    db.enableRetention(retention({ { 1min, 48h }, { 1h, 0h } }));
+
+    auto oldHour = expiredHour(72h);
+    auto keptHour = expiredHour(30h);
+    auto old = ticksFrom(oldHour, 12);
+    auto kept = ticksFrom(keptHour, 12);
+    save(db, old);
+    save(db, kept);
+
+    auto stats = db.compact();
+    EXPECT_TRUE(stats.complete);
+    EXPECT_EQ(stats.ticks_removed, old.size() + kept.size());
+    EXPECT_EQ(stats.bars_removed, expectedBars(old, 1min).size());
+
+    auto now = std::chrono::system_clock::now();
+    expectSameBars(expectedBars(kept, 1min), barsIn(db, 1min, oldHour - 1h, now));
+    // The hourly tier keeps both
+    auto hourly = expectedBars(old, 1h);
+    auto keptHourly = expectedBars(kept, 1h);
+    hourly.insert(hourly.end(), keptHourly.begin(), keptHourly.end());
+    expectSameBars(hourly, barsIn(db, 1h, oldHour - 1h, now));
+}
+
+TEST(CompactionTest, CacheStopsServingCompactedTicks) {
+    DatabaseService db(Tests::tempDbPath("compact-cache"));
+    db.enableCache();
+    db.enableRetention(retention({ { 1min, 0h } }));
+
+    auto hour = expiredHour();
+    auto recent = ticksFrom(std::chrono::system_clock::now() - 1h, 3);
+    save(db, ticksFrom(hour, 4));
+    save(db, recent);
+    ASSERT_EQ(db.getPriceHistory("AAPL", 7).size(), 7u);
+    auto before = *db.cacheStats();
+    ASSERT_GT(before.hits, 0u);
+
+    db.compact();
+
+    // Answered by the store, not the ring that still held the expired ticks
+    auto history = db.getPriceHistory("AAPL", 7);
+    EXPECT_EQ(db.cacheStats()->hits, before.hits);
+    ASSERT_EQ(history.size(), recent.size());
+    for (const auto& quote : history) {
+        EXPECT_GE(quote.timestamp, recent.front().timestamp - 1ms);
+    }
+    EXPECT_EQ(db.getPriceHistorySince("AAPL", hour - 1h, 10).size(), recent.size());
+
+    // The next write starts a new ring, which serves what it holds
+    auto next = Tests::makeQuote("AAPL", 99.0, std::chrono::system_clock::now());
+    db.savePrice(next);
+    auto newest = db.getPriceHistory("AAPL", 1);
+    ASSERT_EQ(newest.size(), 1u);
+    EXPECT_EQ(newest[0].price, next.price);
+    EXPECT_GT(db.cacheStats()->hits, before.hits);
+}
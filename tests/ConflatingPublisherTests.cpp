@@ -0,0 +1,83 @@
+#include "TestData.h"
+#include "StockTracker/ConflatingPublisher.h"
+#include <gtest/gtest.h>
+#include <map>
+
+using namespace StockTracker;
+using namespace std::chrono_literals;
+
+namespace {
+
+    // Publisher and a subscriber that reads nothing until drain() is called
+    struct SlowSubscriber {
+        std::shared_ptr<zmq::context_t> context = std::make_shared<zmq::context_t>(1);
+        ConflatingPublisher publisher{ 1024, 1, context };
+        MessageSocket subscriber{ zmq::socket_type::sub, context };
+
+        SlowSubscriber() {
+            publisher.bind("inproc://conflating-publisher-test");
+            subscriber.getSocket().set(zmq::sockopt::rcvhwm, 1);
+            subscriber.setSubscribe();
+            subscriber.connect("inproc://conflating-publisher-test");
+
+            // Wait for the subscription to reach the XPUB, so nothing published below is lost
+            zmq::pollitem_t item{ publisher.getSocket().getSocket().handle(), 0, ZMQ_POLLIN, 0 };
+            zmq::poll(&item, 1, 1000ms);
+        }
+
+        std::vector<Message> drain() {
+            std::vector<Message> received;
+            Message msg{};
+            while (true) {
+                if (subscriber.receive(msg, true)) {
+                    received.push_back(msg);
+                    continue;
+                }
+                // inproc: whatever was sent is readable already
+                if (publisher.stats().pending == 0) {
+                    break;
+                }
+                publisher.pump();
+            }
+            return received;
+        }
+    };
+}
+
+TEST(ConflatingPublisherTest, BacklogKeepsPublishOrder) {
+    SlowSubscriber fixture;
+    const std::vector<std::string> symbols{ "AAPL", "MSFT", "NVDA", "TSLA", "AMZN", "META", "GOOG" };
+
+    // Every tenth message is a control message; prices count up, so a later quote is newer
+    std::map<std::string, double> publishedBefore;          // Newest quote price per symbol so far
+    std::vector<std::map<std::string, double>> expected;    // publishedBefore at each control message
+    for (int i = 0; i < 1000; ++i) {
+        if (i % 10 == 9) {
+            expected.push_back(publishedBefore);
+            fixture.publisher.publish(Message::makeError(std::to_string(expected.size() - 1)));
+        }
+        else {
+            const auto& symbol = symbols[static_cast<size_t>(i) % symbols.size()];
+            fixture.publisher.publish(Message::makeQuoteUpdate(Tests::makeQuote(symbol, i, Tests::at(i))));
+            publishedBefore[symbol] = i;
+        }
+    }
+    ASSERT_GT(fixture.publisher.stats().conflated, 0u) << "No backlog built up";
+
+    std::map<std::string, double> receivedBefore;
+    size_t controls = 0;
+    for (const auto& msg : fixture.drain()) {
+        if (msg.type == MessageType::QuoteUpdate) {
+            receivedBefore[msg.symbol] = msg.quote->price;
+            continue;
+        }
+        ASSERT_EQ(msg.error, std::to_string(controls));
+        for (const auto& [symbol, price] : expected[controls]) {
+            EXPECT_GE(receivedBefore[symbol], price) << symbol << " behind control message " << controls;
+        }
+        ++controls;
+    }
+    EXPECT_EQ(controls, expected.size());
+    EXPECT_EQ(receivedBefore, publishedBefore);
+    EXPECT_EQ(fixture.publisher.stats().dropped, 0u);
+}
@@ -0,0 +1,208 @@
+#include "RateServerStub.h"
+#include "StockTracker/Coroutines.h"
+#include <gtest/gtest.h>
+#include <functional>
+#include <stdexcept>
+
+// Only built when the compiler supports coroutines (see tests/CMakeLists.txt)
+#if defined(__cpp_impl_coroutine)
+
+using namespace StockTracker;
+using namespace std::chrono_literals;
+
+namespace {
+
+    // Runs the reactor on this thread until `done` or a generous deadline
+    void runUntil(Reactor& reactor, const std::function<bool()>& done) {
+        auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (!done() && std::chrono::steady_clock::now() < deadline) {
+            reactor.runOnce(10ms);
+        }
+    }
+
+    // Let the reactor dispatch whatever else is due for a while
+    void runFor(Reactor& reactor, std::chrono::milliseconds duration) {
+        auto deadline = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < deadline) {
+            reactor.runOnce(5ms);
+        }
+    }
+
+    struct ConvertResult {
+        bool done{ false };
+        double converted{ 0.0 };
+        std::string error;
+    };
+
+    Task convertOnce(Reactor& reactor, AsyncCurrencyService& fx, double amount, std::string currency,
+        std::optional<std::chrono::milliseconds> timeout, ConvertResult& result) {
+        try {
+            result.converted = co_await convertAsync(reactor, fx, amount, std::move(currency), timeout);
+        }
+        catch (const std::exception& e) {
+            result.error = e.what();
+        }
+        result.done = true;
+    }
+
+    struct ReceiveResult {
+        int resumed{ 0 };
+        std::optional<Message> message;
+    };
+
+    Task receiveOnce(Reactor& reactor, MessageSocket& socket, std::optional<std::chrono::milliseconds> timeout,
+        ReceiveResult& result) {
+        result.message = co_await receiveAsync(reactor, socket, timeout);
+        ++result.resumed;
+    }
+
+    // Connected PAIR sockets on a private context
+    struct SocketPair {
+        std::shared_ptr<zmq::context_t> context = std::make_shared<zmq::context_t>(1);
+        MessageSocket receiver{ zmq::socket_type::pair, context };
+        MessageSocket sender{ zmq::socket_type::pair, context };
+
+        SocketPair() {
+            receiver.bind("inproc://coroutine-test");
+            sender.connect("inproc://coroutine-test");
+        }
+    };
+}
+
+TEST(CoroutineTest, ConvertYieldsTheConvertedAmount) {
+    Tests::RateServerStub stub;
+    Reactor reactor;
+    AsyncCurrencyService fx(stub.endpoint);
+
+    ConvertResult eur;
+    ConvertResult jpy;
+    convertOnce(reactor, fx, 100.0, "EUR", std::nullopt, eur);
+    convertOnce(reactor, fx, 2.0, "JPY", std::nullopt, jpy);
+    runUntil(reactor, [&] { return eur.done && jpy.done; });
+
+    ASSERT_TRUE(eur.done && jpy.done);
+    EXPECT_DOUBLE_EQ(eur.converted, 92.0);
+    EXPECT_DOUBLE_EQ(jpy.converted, 299.0);
+    EXPECT_TRUE(eur.error.empty());
+}
+
+TEST(CoroutineTest, ConvertRethrowsServiceErrors) {
+    Tests::RateServerStub stub;
+    stub.removeRate("CAD");
+    Reactor reactor;
+    AsyncCurrencyService fx(stub.endpoint);
+
+    ConvertResult result;
+    convertOnce(reactor, fx, 1.0, "CAD", std::nullopt, result);
+    runUntil(reactor, [&] { return result.done; });
+
+    ASSERT_TRUE(result.done);
+    EXPECT_NE(result.error.find("Unsupported currency"), std::string::npos) << result.error;
+}
+
+TEST(CoroutineTest, ConvertRethrowsTimeouts) {
+    Reactor reactor;
+    AsyncCurrencyService fx("tcp://127.0.0.1:1");    // Nothing answers
+
+    ConvertResult result;
+    convertOnce(reactor, fx, 1.0, "EUR", 50ms, result);
+    runUntil(reactor, [&] { return result.done; });
+
+    ASSERT_TRUE(result.done);
+    EXPECT_FALSE(result.error.empty());
+}
+
+TEST(CoroutineTest, ReceiveReturnsTheMessage) {
+    SocketPair sockets;
+    Reactor reactor(sockets.context);
+
+    ReceiveResult result;
+    receiveOnce(reactor, sockets.receiver, std::nullopt, result);
+    EXPECT_EQ(result.resumed, 0);   // Nothing queued yet, so it is waiting on the reactor
+
+    sockets.sender.send(Message::makeSubscribe("AAPL"));
+    runUntil(reactor, [&] { return result.resumed > 0; });
+
+    ASSERT_EQ(result.resumed, 1);
+    ASSERT_TRUE(result.message);
+    EXPECT_EQ(result.message->type, MessageType::Subscribe);
+    EXPECT_EQ(result.message->symbol, "AAPL");
+}
+
+TEST(CoroutineTest, ReceiveUsesAQueuedMessageDirectly) {
+    SocketPair sockets;
+    Reactor reactor(sockets.context);
+    sockets.sender.send(Message::makeQuery("MSFT"));
+
+    // Wait until the message is readable, then await without running the reactor
+    zmq::pollitem_t item{ sockets.receiver.getSocket().handle(), 0, ZMQ_POLLIN, 0 };
+    ASSERT_EQ(zmq::poll(&item, 1, 1000ms), 1);
+
+    ReceiveResult result;
+    receiveOnce(reactor, sockets.receiver, std::nullopt, result);
+    ASSERT_EQ(result.resumed, 1);
+    EXPECT_EQ(result.message->symbol, "MSFT");
+}
+
+TEST(CoroutineTest, ReceiveTimesOut) {
+    SocketPair sockets;
+    Reactor reactor(sockets.context);
+
+    ReceiveResult result;
+    auto started = std::chrono::steady_clock::now();
+    receiveOnce(reactor, sockets.receiver, 50ms, result);
+    runUntil(reactor, [&] { return result.resumed > 0; });
+
+    ASSERT_EQ(result.resumed, 1);
+    EXPECT_FALSE(result.message);
+    EXPECT_GE(std::chrono::steady_clock::now() - started, 50ms);
+}
+
+// After the coroutine resumes, neither its socket handler nor its timer may fire again
+TEST(CoroutineTest, ReceiveUnregistersAfterResuming) {
+    SocketPair sockets;
+    Reactor reactor(sockets.context);
+
+    ReceiveResult result;
+    receiveOnce(reactor, sockets.receiver, 50ms, result);
+    sockets.sender.send(Message::makeSubscribe("AAPL"));
+    runUntil(reactor, [&] { return result.resumed > 0; });
+    ASSERT_EQ(result.resumed, 1);
+    ASSERT_TRUE(result.message);
+
+    // A leftover registration would consume this message; a leftover timer would resume again
+    sockets.sender.send(Message::makeUnsubscribe("AAPL"));
+    runFor(reactor, 100ms);
+    EXPECT_EQ(result.resumed, 1);
+
+    Message msg{};
+    ASSERT_TRUE(sockets.receiver.receive(msg, true));
+    EXPECT_EQ(msg.type, MessageType::Unsubscribe);
+
+    // The socket can be awaited again
+    ReceiveResult again;
+    receiveOnce(reactor, sockets.receiver, std::nullopt, again);
+    sockets.sender.send(Message::makeQuery("AAPL"));
+    runUntil(reactor, [&] { return again.resumed > 0; });
+    ASSERT_TRUE(again.message);
+    EXPECT_EQ(again.message->type, MessageType::Query);
+}
+
+TEST(CoroutineTest, TimedOutReceiveUnregisters) {
+    SocketPair sockets;
+    Reactor reactor(sockets.context);
+
+    ReceiveResult result;
+    receiveOnce(reactor, sockets.receiver, 20ms, result);
+    runUntil(reactor, [&] { return result.resumed > 0; });
+    ASSERT_EQ(result.resumed, 1);
+
+    sockets.sender.send(Message::makeSubscribe("AAPL"));
+    runFor(reactor, 50ms);
+    EXPECT_EQ(result.resumed, 1);
+
+    Message msg{};
+    EXPECT_TRUE(sockets.receiver.receive(msg, true));
+}
+
+#endif
@@ -0,0 +1,235 @@
+#include "RateServerStub.h"
+#include "TestData.h"
+#include "StockTracker/CurrencyService.h"
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+
+using namespace StockTracker;
+using namespace std::chrono_literals;
+
+namespace {
+
+    StockQuote quoteIn(const std::string& currency, double price) {
+        auto quote = Tests::makeQuote("AAPL", price, Tests::at(0));
+        quote.currency = currency;
+        return quote;
+    }
+
+    auto fields(const StockQuote& quote) {
+        return std::make_tuple(quote.price, quote.currency, quote.change_percent,
+            quote.indicators ? quote.indicators->sma : std::nullopt,
+            quote.indicators ? quote.indicators->volatility : std::nullopt);
+    }
+}
+
+TEST(CurrencyServiceTest, ConvertsWithTheServiceRate) {
+    Tests::RateServerStub stub;
+    CurrencyService currency(stub.endpoint);
+    EXPECT_DOUBLE_EQ(currency.convertCurrency(100.0, "EUR"), 92.0);
+    EXPECT_DOUBLE_EQ(currency.convertCurrency(2.0, "JPY"), 299.0);
+}
+
+TEST(CurrencyServiceTest, UsdNeedsNoRequest) {
+    Tests::RateServerStub stub;
+    CurrencyService currency(stub.endpoint);
+    EXPECT_EQ(currency.getRate("USD"), 1.0);
+    EXPECT_EQ(currency.convertCurrency(12.5, "USD"), 12.5);
+    EXPECT_EQ(stub.requests(), 0u);
+}
+
+TEST(CurrencyServiceTest, RateIsCachedWithinTtl) {
+    Tests::RateServerStub stub;
+    CurrencyService currency(stub.endpoint);
+    currency.setRateTtl(1h);
+
+    EXPECT_DOUBLE_EQ(currency.getRate("EUR"), 0.92);
+    stub.setRate("EUR", 0.5);
+    EXPECT_DOUBLE_EQ(currency.getRate("EUR"), 0.92);
+    EXPECT_DOUBLE_EQ(currency.convertCurrency(10.0, "EUR"), 9.2);
+    EXPECT_EQ(stub.requests(), 1u);
+
+    // Each currency has its own entry
+    EXPECT_DOUBLE_EQ(currency.getRate("GBP"), 0.79);
+    EXPECT_EQ(stub.requests(), 2u);
+}
+
+TEST(CurrencyServiceTest, RateIsFetchedAgainAfterTtl) {
+    Tests::RateServerStub stub;
+    CurrencyService currency(stub.endpoint);
+    currency.setRateTtl(200ms);
+
+    EXPECT_DOUBLE_EQ(currency.getRate("EUR"), 0.92);
+    stub.setRate("EUR", 0.5);
+    EXPECT_DOUBLE_EQ(currency.getRate("EUR"), 0.92);
+    EXPECT_EQ(stub.requests(), 1u);
+
+    std::this_thread::sleep_for(250ms);
+    EXPECT_DOUBLE_EQ(currency.getRate("EUR"), 0.5);
+    EXPECT_EQ(stub.requests(), 2u);
+}
+
+TEST(CurrencyServiceTest, ZeroTtlDisablesTheCache) {
+    Tests::RateServerStub stub;
+    CurrencyService currency(stub.endpoint);
+    currency.setRateTtl(0ms);
+
+    for (int i = 0; i < 3; ++i) {
+        currency.getRate("EUR");
+    }
+    EXPECT_EQ(stub.requests(), 3u);
+}
+
+TEST(CurrencyServiceTest, ClearRateCacheForcesAFetch) {
+    Tests::RateServerStub stub;
+    CurrencyService currency(stub.endpoint);
+    currency.setRateTtl(1h);
+
+    currency.getRate("EUR");
+    stub.setRate("EUR", 0.5);
+    currency.clearRateCache();
+    EXPECT_DOUBLE_EQ(currency.getRate("EUR"), 0.5);
+    EXPECT_EQ(stub.requests(), 2u);
+}
+
+TEST(CurrencyServiceTest, ConvertManyUsesOneLookup) {
+    Tests::RateServerStub stub;
+    CurrencyService currency(stub.endpoint);
+    currency.setRateTtl(0ms);   // Every getRate would be a request
+
+    std::vector<double> amounts{ 1.0, 2.5, -3.0, 0.0, 1e9 };
+    auto converted = currency.convertMany(amounts, "EUR");
+    ASSERT_EQ(converted.size(), amounts.size());
+    for (size_t i = 0; i < amounts.size(); ++i) {
+        EXPECT_DOUBLE_EQ(converted[i], amounts[i] * 0.92);
+    }
+    EXPECT_EQ(stub.requests(), 1u);
+    EXPECT_EQ(amounts[1], 2.5);     // Input left alone
+}
+
+TEST(CurrencyServiceTest, ConvertManyEdgeCases) {
+    Tests::RateServerStub stub;
+    CurrencyService currency(stub.endpoint);
+
+    EXPECT_TRUE(currency.convertMany({}, "EUR").empty());
+    EXPECT_EQ(currency.convertMany({ 4.0, 5.0 }, "USD"), (std::vector<double>{ 4.0, 5.0 }));
+    EXPECT_THROW(currency.convertMany({ 1.0 }, "XYZ"), std::runtime_error);
+    EXPECT_EQ(stub.requests(), 1u);
+}
+
+TEST(CurrencyServiceTest, ServiceErrorsAreThrownAndNotCached) {
+    Tests::RateServerStub stub;
+    CurrencyService currency(stub.endpoint);
+    stub.removeRate("CAD");
+
+    EXPECT_THROW(currency.getRate("CAD"), std::runtime_error);
+    stub.setRate("CAD", 1.36);
+    EXPECT_DOUBLE_EQ(currency.getRate("CAD"), 1.36);
+}
+
+TEST(CurrencyServiceTest, ConvertQuotesFromMixedCurrencies) {
+    Tests::RateServerStub stub;
+    CurrencyService currency(stub.endpoint);
+
+    std::vector<StockQuote> quotes{ quoteIn("USD", 100.0), quoteIn("EUR", 92.0), quoteIn("GBP", 7.9), quoteIn("EUR", 46.0) };
+    currency.convertQuotes(quotes, "JPY");
+    std::vector<double> expected{ 14950.0, 14950.0, 1495.0, 7475.0 };
+    for (size_t i = 0; i < quotes.size(); ++i) {
+        EXPECT_DOUBLE_EQ(quotes[i].price, expected[i]) << "quote " << i;
+        EXPECT_EQ(quotes[i].currency, "JPY");
+    }
+    // JPY, EUR and GBP once each
+    EXPECT_EQ(stub.requests(), 3u);
+
+    // Back to USD
+    currency.convertQuotes(quotes, "USD");
+    EXPECT_DOUBLE_EQ(quotes[2].price, 10.0);
+    EXPECT_EQ(quotes[2].currency, "USD");
+}
+
+TEST(CurrencyServiceTest, ConvertQuotesScalesOnlyPriceValuedIndicators) {
+    Tests::RateServerStub stub;
+    CurrencyService currency(stub.endpoint);
+
+    auto quote = quoteIn("USD", 200.0);
+    quote.change_percent = 1.25;
+    quote.indicators = QuoteIndicators{ 190.0, 195.0, 198.0, 0.003 };
+    auto partial = quoteIn("USD", 100.0);
+    partial.indicators = QuoteIndicators{ std::nullopt, 100.0, 100.0, std::nullopt };
+    std::vector<StockQuote> quotes{ quote, partial };
+    currency.convertQuotes(quotes, "EUR");
+
+    const auto& converted = *quotes[0].indicators;
+    EXPECT_DOUBLE_EQ(quotes[0].price, 184.0);
+    EXPECT_DOUBLE_EQ(*converted.sma, 174.8);
+    EXPECT_DOUBLE_EQ(*converted.ema, 179.4);
+    EXPECT_DOUBLE_EQ(*converted.vwap, 182.16);
+    EXPECT_EQ(converted.volatility, 0.003);
+    EXPECT_EQ(quotes[0].change_percent, 1.25);
+
+    EXPECT_FALSE(quotes[1].indicators->sma);
+    EXPECT_DOUBLE_EQ(*quotes[1].indicators->ema, 92.0);
+    EXPECT_FALSE(quotes[1].indicators->volatility);
+    EXPECT_FALSE(quotes[1].change_percent);
+}
+
+TEST(CurrencyServiceTest, UnsupportedCurrenciesThrowBeforeAnyQuoteChanges) {
+    Tests::RateServerStub stub;
+    CurrencyService currency(stub.endpoint);
+    stub.removeRate("GBP");
+
+    for (const auto& source : { std::string("XYZ"), std::string("GBP") }) {
+        SCOPED_TRACE(source);
+        std::vector<StockQuote> quotes{ quoteIn("USD", 100.0), quoteIn("EUR", 92.0), quoteIn(source, 1.0) };
+        auto before = quotes;
+        EXPECT_THROW(currency.convertQuotes(quotes, "CAD"), std::runtime_error);
+        for (size_t i = 0; i < quotes.size(); ++i) {
+            EXPECT_EQ(fields(quotes[i]), fields(before[i])) << "quote " << i;
+        }
+    }
+
+    std::vector<StockQuote> quotes{ quoteIn("USD", 100.0) };
+    EXPECT_THROW(currency.convertQuotes(quotes, "XYZ"), std::runtime_error);
+    EXPECT_EQ(quotes[0].currency, "USD");
+
+    // The target is checked even with nothing to convert
+    std::vector<StockQuote> none;
+    EXPECT_THROW(currency.convertQuotes(none, "XYZ"), std::runtime_error);
+    auto requests = stub.requests();
+    EXPECT_NO_THROW(currency.convertQuotes(none, "EUR"));
+    EXPECT_EQ(stub.requests(), requests);
+}
+
+TEST(CurrencyServiceTest, SameCurrencyNeedsNoRate) {
+    Tests::RateServerStub stub;
+    CurrencyService currency(stub.endpoint);
+
+    std::vector<StockQuote> quotes{ quoteIn("EUR", 92.0), quoteIn("EUR", 46.0) };
+    currency.convertQuotes(quotes, "EUR");
+    EXPECT_EQ(quotes[0].price, 92.0);
+    EXPECT_EQ(quotes[1].price, 46.0);
+
+    std::vector<double> amounts{ 1.0, 2.0 };
+    currency.convertInPlace(amounts.data(), amounts.size(), "EUR", "EUR");
+    EXPECT_EQ(amounts, (std::vector<double>{ 1.0, 2.0 }));
+    EXPECT_EQ(stub.requests(), 0u);
+
+    // Still has to be a currency
+    EXPECT_THROW(currency.convertInPlace(amounts.data(), amounts.size(), "XYZ", "XYZ"), std::runtime_error);
+}
+
+TEST(CurrencyServiceTest, ConvertInPlaceBetweenNonUsdCurrencies) {
+    Tests::RateServerStub stub;
+    CurrencyService currency(stub.endpoint);
+
+    std::vector<double> amounts{ 92.0, -46.0, 0.0 };
+    currency.convertInPlace(amounts.data(), amounts.size(), "GBP", "EUR");
+    EXPECT_DOUBLE_EQ(amounts[0], 79.0);
+    EXPECT_DOUBLE_EQ(amounts[1], -39.5);
+    EXPECT_EQ(amounts[2], 0.0);
+
+    currency.convertInPlace(amounts.data(), amounts.size(), "USD", "GBP");
+    EXPECT_DOUBLE_EQ(amounts[0], 100.0);
+    EXPECT_EQ(stub.requests(), 2u);
+}
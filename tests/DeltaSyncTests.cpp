@@ -0,0 +1,153 @@
+#include "TestData.h"
+#include "StockTracker/DatabaseService.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <set>
+
+using namespace StockTracker;
+using namespace std::chrono_literals;
+
+namespace {
+
+    std::vector<std::chrono::system_clock::time_point> timestamps(const std::vector<StockQuote>& quotes) {
+        std::vector<std::chrono::system_clock::time_point> result;
+        for (const auto& quote : quotes) {
+            result.push_back(quote.timestamp);
+        }
+        return result;
+    }
+
+    // The same file with and without the cache, so each case runs both paths
+    struct CachedAndPlain {
+        std::string path;
+        DatabaseService cached;
+        DatabaseService plain;
+
+        explicit CachedAndPlain(const std::string& name)
+            : path(Tests::tempDbPath(name))
+            , cached(path)
+            , plain(path)
+        {
+            cached.enableCache();
+        }
+    };
+
+    std::vector<std::string> sorted(std::vector<std::string> symbols) {
+        std::sort(symbols.begin(), symbols.end());
+        return symbols;
+    }
+
+    // What a client holding `list` has after applying `delta`
+    std::vector<std::string> applyDelta(std::set<std::string> list, const SubscriptionDelta& delta) {
+        if (delta.full) {
+            list.clear();
+        }
+        for (const auto& symbol : delta.removed) {
+            list.erase(symbol);
+        }
+        list.insert(delta.added.begin(), delta.added.end());
+        return { list.begin(), list.end() };
+    }
+}
+
+TEST(DeltaSyncTest, HistorySinceWithWallClockQuotes) {
+    CachedAndPlain db("delta-wall-clock");
+    auto now = std::chrono::system_clock::now();
+    for (int i = 4; i >= 0; --i) {
+        db.cached.savePrice(Tests::makeQuote("AAPL", 100.0 - i, now - std::chrono::minutes(i)));
+    }
+
+    for (auto* service : { &db.cached, &db.plain }) {
+        EXPECT_EQ(service->getPriceHistorySince("AAPL", now - 1h, 10).size(), 5u);
+
+        // A client holding up to a returned quote gets only what came after it
+        auto held = service->getPriceHistory("AAPL", 3).back();
+        auto delta = service->getPriceHistorySince("AAPL", held.timestamp, 10);
+        ASSERT_EQ(delta.size(), 2u);
+        EXPECT_EQ(delta[0].timestamp, std::chrono::time_point_cast<std::chrono::milliseconds>(now));
+        EXPECT_TRUE(service->getPriceHistorySince("AAPL", delta[0].timestamp, 10).empty());
+    }
+}
+
+// Hours of ticks, far more than fit in a nanosecond count read back as milliseconds
+TEST(DeltaSyncTest, HistorySinceAcrossHours) {
+    CachedAndPlain db("delta-hours");
+    auto start = std::chrono::system_clock::now() - 12h;
+    std::vector<std::chrono::system_clock::time_point> hours;
+    for (int h = 0; h < 12; ++h) {
+        hours.push_back(start + std::chrono::hours(h));
+        db.cached.savePrice(Tests::makeQuote("AAPL", 100.0 + h, hours.back()));
+    }
+
+    for (auto* service : { &db.cached, &db.plain }) {
+        auto delta = service->getPriceHistorySince("AAPL", hours[6], 10);
+        ASSERT_EQ(delta.size(), 5u);
+        for (size_t i = 0; i < delta.size(); ++i) {
+            EXPECT_EQ(delta[i].timestamp, std::chrono::time_point_cast<std::chrono::milliseconds>(hours[11 - i]));
+        }
+        // limit still caps the newest rows
+        EXPECT_EQ(timestamps(service->getPriceHistorySince("AAPL", hours[0], 3)),
+            timestamps(service->getPriceHistory("AAPL", 3)));
+    }
+    EXPECT_GT(db.cached.cacheStats()->hits, 0u);
+}
+
+TEST(DeltaSyncTest, SubscriptionChanges) {
+    auto path = Tests::tempDbPath("delta-subscriptions");
+    DatabaseService db(path);
+    EXPECT_EQ(db.subscriptionsVersion(), 0u);
+    db.saveSubscription("AAPL");
+    db.saveSubscription("MSFT");
+
+    // A new client gets the full list
+    auto initial = db.getSubscriptionChanges(0);
+    EXPECT_TRUE(initial.full);
+    EXPECT_EQ(sorted(initial.added), (std::vector<std::string>{ "AAPL", "MSFT" }));
+    EXPECT_EQ(initial.version, db.subscriptionsVersion());
+    std::set<std::string> client(initial.added.begin(), initial.added.end());
+
+    auto unchanged = db.getSubscriptionChanges(initial.version);
+    EXPECT_FALSE(unchanged.full);
+    EXPECT_TRUE(unchanged.added.empty() && unchanged.removed.empty());
+    EXPECT_EQ(unchanged.version, initial.version);
+
+    // Several versions later: only the latest change per symbol is reported
+    db.saveSubscription("NVDA");
+    auto afterNvda = db.subscriptionsVersion();
+    db.removeSubscription("MSFT");
+    db.saveSubscription("TSLA");
+    db.removeSubscription("TSLA");
+    db.removeSubscription("GOOG");     // Never subscribed, so no change
+
+    auto delta = db.getSubscriptionChanges(initial.version);
+    EXPECT_FALSE(delta.full);
+    EXPECT_EQ(delta.added, (std::vector<std::string>{ "NVDA" }));
+    EXPECT_EQ(delta.removed, (std::vector<std::string>{ "MSFT", "TSLA" }));
+    EXPECT_EQ(applyDelta(client, delta), db.getSubscriptions());
+
+    // A client that saw NVDA being added only hears about the removals
+    auto partial = db.getSubscriptionChanges(afterNvda);
+    EXPECT_TRUE(partial.added.empty());
+    EXPECT_EQ(partial.removed, (std::vector<std::string>{ "MSFT", "TSLA" }));
+
+    // Removed then re-added collapses into one addition
+    auto beforeReadd = delta.version;
+    db.removeSubscription("AAPL");
+    db.saveSubscription("AAPL");
+    auto readded = db.getSubscriptionChanges(beforeReadd);
+    EXPECT_EQ(readded.added, (std::vector<std::string>{ "AAPL" }));
+    EXPECT_TRUE(readded.removed.empty());
+    EXPECT_EQ(applyDelta({ "AAPL", "NVDA" }, readded), db.getSubscriptions());
+
+    // A version this database never reached (e.g. another server's) falls back to the full list
+    auto unknown = db.getSubscriptionChanges(readded.version + 100);
+    EXPECT_TRUE(unknown.full);
+    EXPECT_EQ(sorted(unknown.added), db.getSubscriptions());
+
+    // The read pool answers the same
+    DatabaseService pooled(path);
+    pooled.enableReadPool(ReadPoolOptions{ 1, std::chrono::milliseconds(1000) });
+    auto fromPool = pooled.getSubscriptionChanges(initial.version);
+    EXPECT_EQ(fromPool.version, db.subscriptionsVersion());
+    EXPECT_EQ(applyDelta(client, fromPool), db.getSubscriptions());
+}
@@ -0,0 +1,161 @@
+#include "TestData.h"
+#include "StockTracker/Indicators.h"
+#include "StockTracker/Messages.h"
+#include <gtest/gtest.h>
+#include <cmath>
+
+using namespace StockTracker;
+using namespace std::chrono_literals;
+
+namespace {
+
+    IndicatorOptions windows(size_t sma, size_t ema, size_t volatility) {
+        IndicatorOptions options;
+        options.sma_window = sma;
+        options.ema_period = ema;
+        options.volatility_window = volatility;
+        return options;
+    }
+
+    // Applies a quote `seconds` after T0 and returns it stamped
+    StockQuote apply(IndicatorEngine& engine, double price, int64_t seconds) {
+        auto quote = Tests::makeQuote("AAPL", price, Tests::at(seconds * 1000));
+        engine.apply(quote);
+        return quote;
+    }
+
+    double sampleStdDev(const std::vector<double>& values) {
+        double mean = 0.0;
+        for (double value : values) {
+            mean += value / static_cast<double>(values.size());
+        }
+        double squares = 0.0;
+        for (double value : values) {
+            squares += (value - mean) * (value - mean);
+        }
+        return std::sqrt(squares / static_cast<double>(values.size() - 1));
+    }
+}
+
+TEST(IndicatorTest, SmaWaitsForAFullWindowThenSlides) {
+    IndicatorEngine engine(windows(3, 20, 20));
+    std::vector<std::optional<double>> expected{ std::nullopt, std::nullopt, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0 };
+    for (size_t i = 0; i < expected.size(); ++i) {
+        auto quote = apply(engine, static_cast<double>(i + 1), static_cast<int64_t>(i));
+        ASSERT_TRUE(quote.indicators);
+        EXPECT_EQ(quote.indicators->sma, expected[i]) << "quote " << i;
+    }
+}
+
+TEST(IndicatorTest, EmaStartsAtTheFirstPrice) {
+    // Period 3 smooths by 2 / (3 + 1) = 0.5
+    IndicatorEngine engine(windows(20, 3, 20));
+    std::vector<std::pair<double, double>> steps{ { 10.0, 10.0 }, { 20.0, 15.0 }, { 10.0, 12.5 }, { 12.5, 12.5 } };
+    for (size_t i = 0; i < steps.size(); ++i) {
+        auto quote = apply(engine, steps[i].first, static_cast<int64_t>(i));
+        EXPECT_EQ(quote.indicators->ema, steps[i].second) << "quote " << i;
+    }
+}
+
+TEST(IndicatorTest, VolatilityIsTheSampleStdDevOfLogReturns) {
+    IndicatorEngine engine(windows(20, 20, 3));
+    std::vector<double> prices{ 100.0, 110.0, 99.0, 120.0, 115.0 };
+    std::vector<double> returns;
+    for (size_t i = 0; i < prices.size(); ++i) {
+        auto quote = apply(engine, prices[i], static_cast<int64_t>(i));
+        if (i > 0) {
+            returns.push_back(std::log(prices[i] / prices[i - 1]));
+        }
+        if (returns.size() < 2) {
+            EXPECT_FALSE(quote.indicators->volatility) << "quote " << i;
+            continue;
+        }
+        // Only the newest three returns count
+        std::vector<double> window(returns.end() - static_cast<std::ptrdiff_t>(std::min<size_t>(returns.size(), 3)), returns.end());
+        ASSERT_TRUE(quote.indicators->volatility) << "quote " << i;
+        EXPECT_NEAR(*quote.indicators->volatility, sampleStdDev(window), 1e-12) << "quote " << i;
+    }
+}
+
+TEST(IndicatorTest, VwapAndPreviousCloseRollOverAtUtcMidnight) {
+    IndicatorEngine engine;
+    using days = std::chrono::duration<int64_t, std::ratio<86400>>;
+    std::chrono::system_clock::time_point midnight = std::chrono::floor<days>(Tests::T0) + days(1);
+
+    auto quoteAt = [&](double price, std::chrono::system_clock::time_point time) {
+        auto quote = Tests::makeQuote("AAPL", price, time);
+        engine.apply(quote);
+        return quote;
+    };
+
+    auto first = quoteAt(10.0, midnight - 2min);
+    EXPECT_EQ(first.indicators->vwap, 10.0);
+    EXPECT_FALSE(first.change_percent);
+    EXPECT_EQ(quoteAt(20.0, midnight - 1ms).indicators->vwap, 15.0);
+
+    // A new session: the average starts over and the last price becomes the previous close
+    auto next = quoteAt(40.0, midnight);
+    EXPECT_EQ(next.indicators->vwap, 40.0);
+    ASSERT_TRUE(next.change_percent);
+    EXPECT_DOUBLE_EQ(*next.change_percent, 100.0);
+    EXPECT_EQ(quoteAt(10.0, midnight + 1min).indicators->vwap, 25.0);
+}
+
+TEST(IndicatorTest, ChangePercentUsesTheSeededPreviousClose) {
+    IndicatorEngine engine;
+    EXPECT_FALSE(apply(engine, 55.0, 0).change_percent);
+
+    engine.setPreviousClose("AAPL", 50.0);
+    auto quote = apply(engine, 55.0, 1);
+    ASSERT_TRUE(quote.change_percent);
+    EXPECT_DOUBLE_EQ(*quote.change_percent, 10.0);
+
+    // The feed's own value wins
+    auto fromFeed = Tests::makeQuote("AAPL", 45.0, Tests::at(2000));
+    fromFeed.change_percent = 1.5;
+    engine.apply(fromFeed);
+    EXPECT_EQ(fromFeed.change_percent, 1.5);
+
+    // A zero close can't be divided by
+    engine.setPreviousClose("AAPL", 0.0);
+    EXPECT_FALSE(apply(engine, 45.0, 3).change_percent);
+}
+
+TEST(IndicatorTest, LateQuotesDontChangeTheState) {
+    IndicatorEngine engine(windows(2, 3, 2));
+    IndicatorEngine inOrder(windows(2, 3, 2));
+    StockQuote before;
+    for (int64_t i = 0; i < 4; ++i) {
+        before = apply(engine, 100.0 + static_cast<double>(i), 10 + i);
+        apply(inOrder, 100.0 + static_cast<double>(i), 10 + i);
+    }
+
+    // Gets the current values, but leaves them as they were
+    auto late = apply(engine, 1000.0, 5);
+    ASSERT_TRUE(late.indicators);
+    EXPECT_EQ(late.indicators->sma, before.indicators->sma);
+    EXPECT_EQ(late.indicators->ema, before.indicators->ema);
+    EXPECT_EQ(late.indicators->vwap, before.indicators->vwap);
+    EXPECT_EQ(late.indicators->volatility, before.indicators->volatility);
+
+    auto expected = apply(inOrder, 104.0, 14);
+    auto actual = apply(engine, 104.0, 14);
+    EXPECT_EQ(actual.indicators->sma, expected.indicators->sma);
+    EXPECT_EQ(actual.indicators->ema, expected.indicators->ema);
+    EXPECT_EQ(actual.indicators->vwap, expected.indicators->vwap);
+    EXPECT_EQ(actual.indicators->volatility, expected.indicators->volatility);
+}
+
+TEST(IndicatorTest, AppliesToEveryQuoteOfABatch) {
+    IndicatorEngine engine(windows(2, 20, 20));
+    auto batch = Message::makeQuoteBatch({
+        Tests::makeQuote("AAPL", 10.0, Tests::at(0)),
+        Tests::makeQuote("MSFT", 30.0, Tests::at(0)),
+        Tests::makeQuote("AAPL", 20.0, Tests::at(1000)) });
+    engine.apply(batch);
+
+    const auto& quotes = *batch.quotes;
+    EXPECT_FALSE(quotes[0].indicators->sma);
+    EXPECT_FALSE(quotes[1].indicators->sma);
+    EXPECT_EQ(quotes[2].indicators->sma, 15.0);
+}
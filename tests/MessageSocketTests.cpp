@@ -0,0 +1,130 @@
+#include "TestData.h"
+#include "StockTracker/Messages.h"
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace StockTracker;
+using namespace std::chrono_literals;
+
+namespace {
+
+    // A MessageSocket and a plain socket that sees its frames as sent
+    struct SocketPair {
+        std::shared_ptr<zmq::context_t> context = std::make_shared<zmq::context_t>(1);
+        MessageSocket sender{ zmq::socket_type::pair, context };
+        zmq::socket_t receiver{ *context, zmq::socket_type::pair };
+
+        // A positive `hwm` limits how many frames can wait between the two
+        explicit SocketPair(const std::string& name, int hwm = 0) {
+            if (hwm > 0) {
+                sender.getSocket().set(zmq::sockopt::sndhwm, hwm);
+                receiver.set(zmq::sockopt::rcvhwm, hwm);
+            }
+            receiver.bind("inproc://" + name);
+            sender.connect("inproc://" + name);
+        }
+
+        std::optional<std::string> receiveFrame() {
+            zmq::message_t frame;
+            if (!receiver.recv(frame, zmq::recv_flags::dontwait)) {
+                return std::nullopt;
+            }
+            return frame.to_string();
+        }
+
+        std::optional<Message> receive() {
+            auto frame = receiveFrame();
+            if (!frame) {
+                return std::nullopt;
+            }
+            Message msg;
+            from_json(json::parse(*frame), msg);
+            return msg;
+        }
+    };
+}
+
+TEST(MessageSocketTest, JsonFramesMatchDump) {
+    SocketPair sockets("socket-json-frames");
+
+    // Longest first, so a frame with leftovers from the one before would show
+    std::vector<Message> messages{
+        Message::makeError(std::string(300, 'x')),
+        Message::makeQuoteUpdate(Tests::makeQuote("AAPL", 189.5, Tests::at(0))),
+        Message::makeSubscribe("MSFT"),
+        Message::makeError("") };
+    for (const auto& msg : messages) {
+        sockets.sender.send(msg);
+        json j;
+        to_json(j, msg);
+        EXPECT_EQ(sockets.receiveFrame(), j.dump());
+    }
+}
+
+TEST(MessageSocketTest, TrySendGoesAfterBatchedQuotes) {
+    SocketPair sockets("socket-try-send-order");
+    sockets.sender.enableQuoteBatching(10, std::chrono::hours(1));
+    for (int i = 0; i < 3; ++i) {
+        sockets.sender.send(Message::makeQuoteUpdate(Tests::makeQuote("AAPL", 100.0 + i, Tests::at(i))));
+    }
+    EXPECT_FALSE(sockets.receiveFrame());
+
+    ASSERT_TRUE(sockets.sender.trySend(Message::makeError("after")));
+    auto batch = sockets.receive();
+    ASSERT_TRUE(batch);
+    EXPECT_EQ(batch->type, MessageType::QuoteBatch);
+    ASSERT_TRUE(batch->quotes);
+    ASSERT_EQ(batch->quotes->size(), 3u);
+    EXPECT_EQ(batch->quotes->back().price, 102.0);
+
+    auto control = sockets.receive();
+    ASSERT_TRUE(control);
+    EXPECT_EQ(control->type, MessageType::Error);
+    EXPECT_FALSE(sockets.receiveFrame());
+}
+
+TEST(MessageSocketTest, BlockedTrySendKeepsTheBatch) {
+    SocketPair sockets("socket-try-send-blocked", 1);
+
+    // Fill the pipe while nothing reads it
+    size_t fillers = 0;
+    while (sockets.sender.trySend(Message::makeError("filler"))) {
+        ++fillers;
+    }
+    ASSERT_GT(fillers, 0u);
+    ASSERT_LE(fillers, 2u);
+
+    sockets.sender.enableQuoteBatching(10, std::chrono::hours(1));
+    sockets.sender.send(Message::makeQuoteUpdate(Tests::makeQuote("AAPL", 100.0, Tests::at(0))));
+    sockets.sender.send(Message::makeQuoteUpdate(Tests::makeQuote("AAPL", 101.0, Tests::at(1))));
+    EXPECT_FALSE(sockets.sender.trySend(Message::makeError("after")));
+
+    for (size_t i = 0; i < fillers; ++i) {
+        auto filler = sockets.receive();
+        ASSERT_TRUE(filler);
+        EXPECT_EQ(filler->error, "filler");
+    }
+
+    // The reader's credit reaches the sender asynchronously; meanwhile the batch must stay put
+    std::vector<Message> received;
+    bool sent = false;
+    for (int attempt = 0; attempt < 1000 && !sent; ++attempt) {
+        sent = sockets.sender.trySend(Message::makeError("after"));
+        while (auto msg = sockets.receive()) {
+            received.push_back(*msg);
+        }
+        if (!sent) {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+    ASSERT_TRUE(sent);
+    while (auto msg = sockets.receive()) {
+        received.push_back(*msg);
+    }
+
+    ASSERT_EQ(received.size(), 2u);
+    EXPECT_EQ(received[0].type, MessageType::QuoteBatch);
+    ASSERT_TRUE(received[0].quotes);
+    EXPECT_EQ(received[0].quotes->size(), 2u);
+    EXPECT_EQ(received[1].error, "after");
+}
@@ -0,0 +1,113 @@
+#include "TestData.h"
+#include "StockTracker/PackedQuote.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+using namespace StockTracker;
+using namespace std::chrono_literals;
+
+TEST(PackedQuoteTest, RoundTripKeepsEveryStoredField) {
+    SymbolTable symbols;
+    auto quote = Tests::makeQuote("AAPL", 189.25, Tests::at(1234) + 567us);
+    quote.currency = "EUR";
+    quote.change_percent = -0.75;
+    quote.indicators = QuoteIndicators{ 1.0, 2.0, 3.0, 4.0 };
+
+    auto packed = PackedQuote::pack(quote, symbols);
+    EXPECT_EQ(packed.symbol, *symbols.find("AAPL"));
+    EXPECT_EQ(SymbolTable::currencies().name(packed.currency), "EUR");
+
+    auto unpacked = packed.unpack(symbols);
+    EXPECT_EQ(unpacked.symbol, "AAPL");
+    EXPECT_EQ(unpacked.price, 189.25);
+    EXPECT_EQ(unpacked.timestamp, quote.timestamp);     // Full clock resolution
+    EXPECT_EQ(unpacked.change_percent, -0.75);
+    EXPECT_EQ(unpacked.currency, "EUR");
+    EXPECT_FALSE(unpacked.indicators);                  // Not packed
+}
+
+TEST(PackedQuoteTest, ChangePercentAbsentIsNotZero) {
+    SymbolTable symbols;
+    auto quote = Tests::makeQuote("AAPL", 10.0, Tests::at(0));
+
+    auto absent = PackedQuote::pack(quote, symbols);
+    EXPECT_EQ(absent.flags & PackedQuote::HAS_CHANGE_PERCENT, 0);
+    EXPECT_FALSE(absent.unpack(symbols).change_percent);
+
+    quote.change_percent = 0.0;
+    auto zero = PackedQuote::pack(quote, symbols);
+    EXPECT_NE(zero.flags & PackedQuote::HAS_CHANGE_PERCENT, 0);
+    EXPECT_EQ(zero.unpack(symbols).change_percent, 0.0);
+}
+
+TEST(PackedQuoteTest, SymbolIdsAreDenseAndStable) {
+    SymbolTable symbols;
+    EXPECT_EQ(symbols.intern("AAPL"), 0u);
+    EXPECT_EQ(symbols.intern("MSFT"), 1u);
+    EXPECT_EQ(symbols.intern("AAPL"), 0u);
+    EXPECT_EQ(symbols.find("MSFT"), 1u);
+    EXPECT_FALSE(symbols.find("NVDA"));
+    EXPECT_EQ(symbols.size(), 2u);
+
+    // Names stay where they are however many follow
+    const std::string& aapl = symbols.name(0);
+    for (int i = 0; i < 10000; ++i) {
+        symbols.intern("SYM" + std::to_string(i));
+    }
+    EXPECT_EQ(&symbols.name(0), &aapl);
+    EXPECT_EQ(aapl, "AAPL");
+    EXPECT_EQ(symbols.intern("AAPL"), 0u);
+    EXPECT_THROW(symbols.name(static_cast<SymbolId>(symbols.size())), std::out_of_range);
+}
+
+TEST(PackedQuoteTest, InterningPastTheLimitLeavesTheTableAlone) {
+    SymbolTable symbols;
+    symbols.intern("USD");
+    symbols.intern("EUR");
+    EXPECT_EQ(symbols.intern("GBP", 2), 2u);
+
+    EXPECT_THROW(symbols.intern("JPY", 2), std::length_error);
+    EXPECT_EQ(symbols.size(), 3u);
+    EXPECT_FALSE(symbols.find("JPY"));
+    // Names already in the table are still found
+    EXPECT_EQ(symbols.intern("EUR", 2), 1u);
+    EXPECT_EQ(symbols.intern("JPY"), 3u);
+}
+
+TEST(PackedQuoteTest, ConcurrentInternAgreesOnIds) {
+    SymbolTable symbols;
+    std::vector<std::string> names;
+    for (int i = 0; i < 1000; ++i) {
+        names.push_back("SYM" + std::to_string(i));
+    }
+
+    // Every thread interns every name, each in its own order
+    constexpr size_t THREADS = 8;
+    std::vector<std::unordered_map<std::string, SymbolId>> seen(THREADS);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&, t] {
+            auto order = names;
+            std::shuffle(order.begin(), order.end(), std::mt19937(static_cast<unsigned>(t)));
+            for (const auto& name : order) {
+                seen[t][name] = symbols.intern(name);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(symbols.size(), names.size());
+    for (const auto& name : names) {
+        SymbolId id = seen[0][name];
+        EXPECT_LT(id, names.size());
+        EXPECT_EQ(symbols.name(id), name);
+        for (size_t t = 1; t < THREADS; ++t) {
+            EXPECT_EQ(seen[t][name], id) << name;
+        }
+    }
+}
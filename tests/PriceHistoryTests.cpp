@@ -0,0 +1,107 @@
+#include "TestData.h"
+#include "StockTracker/DatabaseService.h"
+#include <gtest/gtest.h>
+#include <sqlite3.h>
+
+using namespace StockTracker;
+using namespace std::chrono_literals;
+
+namespace {
+
+    std::vector<int64_t> storedTimestamps(const std::vector<StockQuote>& quotes) {
+        std::vector<int64_t> result;
+        for (const auto& quote : quotes) {
+            result.push_back(toStoredTimestamp(quote.timestamp));
+        }
+        return result;
+    }
+
+    // Quotes one second apart ending at now(), with sub-millisecond parts
+    std::vector<StockQuote> recentQuotes(size_t count) {
+        auto now = std::chrono::system_clock::now();
+        std::vector<StockQuote> quotes;
+        for (size_t i = 0; i < count; ++i) {
+            auto time = now - std::chrono::seconds(count - 1 - i) + std::chrono::microseconds(250);
+            quotes.push_back(Tests::makeQuote("AAPL", 100.0 + static_cast<double>(i), time));
+        }
+        return quotes;
+    }
+}
+
+// Every query returns timestamps that can be passed back in as bounds
+TEST(PriceHistoryTest, ReturnedTimestampsWorkAsBounds) {
+    DatabaseService db(Tests::tempDbPath("history-bounds"));
+    auto saved = recentQuotes(10);
+    for (const auto& quote : saved) {
+        db.savePrice(quote);
+    }
+
+    auto latest = db.getPriceHistory("AAPL", 10);
+    ASSERT_EQ(latest.size(), 10u);
+    for (size_t i = 0; i < latest.size(); ++i) {
+        // Stored at millisecond resolution
+        auto expected = std::chrono::time_point_cast<std::chrono::milliseconds>(saved[9 - i].timestamp);
+        EXPECT_EQ(latest[i].timestamp, expected);
+        EXPECT_EQ(latest[i].price, saved[9 - i].price);
+    }
+
+    // [from, to) built from returned timestamps
+    auto range = db.getPriceHistoryRange("AAPL", latest[6].timestamp, latest[2].timestamp);
+    EXPECT_EQ(storedTimestamps(range), (std::vector<int64_t>{
+        toStoredTimestamp(latest[6].timestamp), toStoredTimestamp(latest[5].timestamp),
+        toStoredTimestamp(latest[4].timestamp), toStoredTimestamp(latest[3].timestamp) }));
+
+    auto cursor = db.openPriceHistoryCursor("AAPL", latest[6].timestamp, latest[2].timestamp);
+    std::vector<StockQuote> streamed;
+    StockQuote quote;
+    while (cursor.next(quote)) {
+        streamed.push_back(quote);
+    }
+    EXPECT_EQ(storedTimestamps(streamed), storedTimestamps(range));
+
+    std::vector<StockQuote> scanned;
+    db.scanPriceHistory("AAPL", latest[6].timestamp, latest[2].timestamp,
+        [&](const StockQuote& row) { scanned.push_back(row); });
+    EXPECT_EQ(storedTimestamps(scanned), storedTimestamps(range));
+
+    // The page key is a stored timestamp of a returned quote
+    auto page = db.getPriceHistoryPage("AAPL", 4);
+    ASSERT_TRUE(page.next);
+    EXPECT_EQ(page.next->timestamp, toStoredTimestamp(page.quotes.back().timestamp));
+    auto older = db.getPriceHistoryPage("AAPL", 4, page.next);
+    ASSERT_EQ(older.quotes.size(), 4u);
+    EXPECT_EQ(older.quotes.front().timestamp, latest[4].timestamp);
+
+    // Same-millisecond quotes come back newest saved first, as the cache returns them
+    auto tie = Tests::makeQuote("AAPL", 1.0, saved.back().timestamp + 1h);
+    db.savePrice(tie);
+    tie.price = 2.0;
+    tie.timestamp += 100us;
+    db.savePrice(tie);
+    auto newest = db.getPriceHistory("AAPL", 2);
+    EXPECT_EQ(newest[0].price, 2.0);
+    EXPECT_EQ(newest[1].price, 1.0);
+}
+
+// price_history tables written when the column held system_clock ticks are converted once
+TEST(PriceHistoryTest, TickTimestampsAreMigrated) {
+    auto path = Tests::tempDbPath("history-migrate");
+    auto time = Tests::at(1234) + 567us;
+    {
+        sqlite3* raw = nullptr;
+        ASSERT_EQ(sqlite3_open(path.c_str(), &raw), SQLITE_OK);
+        std::string sql = "CREATE TABLE price_history (symbol TEXT NOT NULL, price REAL NOT NULL,"
+            " timestamp INTEGER NOT NULL, change_percent REAL);"
+            " INSERT INTO price_history VALUES ('AAPL', 1.5, "
+            + std::to_string(time.time_since_epoch().count()) + ", NULL);";
+        EXPECT_EQ(sqlite3_exec(raw, sql.c_str(), nullptr, nullptr, nullptr), SQLITE_OK);
+        sqlite3_close(raw);
+    }
+
+    for (int open = 0; open < 2; ++open) {
+        DatabaseService db(path);
+        auto history = db.getPriceHistory("AAPL", 5);
+        ASSERT_EQ(history.size(), 1u);
+        EXPECT_EQ(history[0].timestamp, Tests::at(1234));
+    }
+}
@@ -0,0 +1,162 @@
+#include "TestData.h"
+#include "StockTracker/DatabaseService.h"
+#include <gtest/gtest.h>
+
+using namespace StockTracker;
+
+namespace {
+
+    std::vector<std::chrono::system_clock::time_point> timestamps(const std::vector<StockQuote>& quotes) {
+        std::vector<std::chrono::system_clock::time_point> result;
+        for (const auto& quote : quotes) {
+            result.push_back(quote.timestamp);
+        }
+        return result;
+    }
+
+    // getPriceHistory with and without the cache must agree; `uncached` reads the same file
+    void expectSameHistory(DatabaseService& cached, DatabaseService& uncached, const std::string& symbol, int limit) {
+        auto expected = uncached.getPriceHistory(symbol, limit);
+        auto actual = cached.getPriceHistory(symbol, limit);
+        EXPECT_EQ(timestamps(expected), timestamps(actual)) << symbol << " limit " << limit;
+        ASSERT_EQ(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_EQ(expected[i].price, actual[i].price);
+            EXPECT_EQ(expected[i].change_percent, actual[i].change_percent);
+        }
+    }
+}
+
+TEST(QuoteCacheTest, HitsMatchTheStore) {
+    auto path = Tests::tempDbPath("cache-hits");
+    DatabaseService db(path);
+    db.enableCache();
+    for (int64_t i = 1; i <= 10; ++i) {
+        auto quote = Tests::makeQuote("AAPL", 100.0 + static_cast<double>(i), Tests::at(i));
+        quote.change_percent = 0.5 * static_cast<double>(i);
+        db.savePrice(quote);
+    }
+
+    DatabaseService plain(path);
+    expectSameHistory(db, plain, "AAPL", 5);
+    EXPECT_EQ(db.cacheStats()->hits, 1u);
+    EXPECT_EQ(db.getPriceHistory("AAPL", 1).front().timestamp, Tests::at(10));
+}
+
+// A ring created after rows were saved must not cache a quote older than those rows
+TEST(QuoteCacheTest, BackfillAfterEnableCacheIsNotCached) {
+    auto path = Tests::tempDbPath("cache-backfill");
+    DatabaseService db(path);
+    db.savePrice(Tests::makeQuote("AAPL", 1.0, Tests::at(2000)));
+    db.savePrice(Tests::makeQuote("AAPL", 2.0, Tests::at(3000)));
+
+    db.enableCache();
+    db.savePrice(Tests::makeQuote("AAPL", 0.5, Tests::at(1000)));
+
+    DatabaseService plain(path);
+    expectSameHistory(db, plain, "AAPL", 1);
+    EXPECT_EQ(db.getPriceHistory("AAPL", 1).front().timestamp, Tests::at(3000));
+
+    // Newer quotes are cached again
+    db.savePrice(Tests::makeQuote("AAPL", 3.0, Tests::at(4000)));
+    auto hits = db.cacheStats()->hits;
+    expectSameHistory(db, plain, "AAPL", 1);
+    EXPECT_EQ(db.cacheStats()->hits, hits + 1);
+    expectSameHistory(db, plain, "AAPL", 2);
+}
+
+TEST(QuoteCacheTest, BackfillAfterEvictionIsNotCached) {
+    for (bool writeBehind : { false, true }) {
+        SCOPED_TRACE(writeBehind ? "write-behind" : "synchronous");
+        auto path = Tests::tempDbPath("cache-evict");
+        DatabaseService db(path);
+        if (writeBehind) {
+            db.enableWriteBehind();
+        }
+        // Room for a single symbol
+        db.enableCache(QuoteCacheOptions{ 4, 1 });
+
+        db.savePrice(Tests::makeQuote("AAPL", 1.0, Tests::at(2000)));
+        db.savePrice(Tests::makeQuote("MSFT", 1.0, Tests::at(2000)));   // Evicts AAPL
+        db.savePrice(Tests::makeQuote("AAPL", 0.5, Tests::at(1000)));   // Recreates AAPL's ring with an older quote
+        db.flush();
+        EXPECT_EQ(db.cacheStats()->evictions, 2u);
+
+        DatabaseService plain(path);
+        expectSameHistory(db, plain, "AAPL", 1);
+        EXPECT_EQ(db.getPriceHistory("AAPL", 1).front().timestamp, Tests::at(2000));
+    }
+}
+
+// Retention drops a ring; the recreated ring must not take a quote older than the rest
+TEST(QuoteCacheTest, ClearedRingKeepsItsFloor) {
+    QuoteCache cache(QuoteCacheOptions{ 4 });
+    cache.insert(Tests::makeQuote("AAPL", 1.0, Tests::at(100)));
+    cache.insert(Tests::makeQuote("AAPL", 2.0, Tests::at(200)));
+    cache.clear();
+
+    cache.insert(Tests::makeQuote("AAPL", 0.5, Tests::at(150)));
+    EXPECT_FALSE(cache.getRecent("AAPL", 1));
+    cache.insert(Tests::makeQuote("AAPL", 3.0, Tests::at(300)));
+    auto recent = cache.getRecent("AAPL", 1);
+    ASSERT_TRUE(recent);
+    EXPECT_EQ(recent->front().price, 3.0);
+    EXPECT_EQ(recent->front().timestamp, Tests::at(300));
+}
+
+TEST(QuoteCacheTest, NewRingIsSeededFromTheStore) {
+    QuoteCache cache(QuoteCacheOptions{ 4 }, [](const std::string& symbol) -> std::optional<int64_t> {
+        if (symbol == "AAPL") {
+            return toStoredTimestamp(Tests::at(500));
+        }
+        return std::nullopt;
+    });
+    cache.insert(Tests::makeQuote("AAPL", 1.0, Tests::at(400)));
+    cache.insert(Tests::makeQuote("MSFT", 1.0, Tests::at(400)));
+    EXPECT_FALSE(cache.getRecent("AAPL", 1));
+    EXPECT_TRUE(cache.getRecent("MSFT", 1));
+
+    cache.insert(Tests::makeQuote("AAPL", 2.0, Tests::at(500)));
+    EXPECT_TRUE(cache.getRecent("AAPL", 1));
+}
+
+// Cache hits and store reads must cut at `since` the same way
+TEST(QuoteCacheTest, HistorySinceMatchesTheStore) {
+    auto path = Tests::tempDbPath("cache-since");
+    DatabaseService db(path);
+    db.enableCache(QuoteCacheOptions{ 8 });
+    for (int64_t tick = 1001; tick <= 1020; ++tick) {
+        db.savePrice(Tests::makeQuote("AAPL", static_cast<double>(tick), Tests::at(tick)));
+    }
+    DatabaseService plain(path);
+
+    struct Case {
+        std::chrono::system_clock::time_point since;
+        int limit;
+        std::vector<int64_t> ticks;     // Expected, newest first
+        bool hit;
+    };
+    std::vector<Case> cases{
+        { Tests::at(1015), 5, { 1020, 1019, 1018, 1017, 1016 }, true },
+        { Tests::at(1017), 8, { 1020, 1019, 1018 }, true },
+        // Sub-millisecond parts of `since` don't count
+        { Tests::at(1017) + std::chrono::microseconds(500), 8, { 1020, 1019, 1018 }, true },
+        { Tests::at(1020), 5, {}, true },
+        // Past the ring's capacity the store answers
+        { Tests::at(1009), 12, { 1020, 1019, 1018, 1017, 1016, 1015, 1014, 1013, 1012, 1011, 1010 }, false },
+        { Tests::at(0), 3, { 1020, 1019, 1018 }, true },
+    };
+    for (const auto& c : cases) {
+        SCOPED_TRACE("since " + std::to_string(c.since.time_since_epoch().count()) + " limit " + std::to_string(c.limit));
+        std::vector<std::chrono::system_clock::time_point> expected;
+        for (auto tick : c.ticks) {
+            expected.push_back(Tests::at(tick));
+        }
+
+        auto hits = db.cacheStats()->hits;
+        auto cached = db.getPriceHistorySince("AAPL", c.since, c.limit);
+        EXPECT_EQ(db.cacheStats()->hits - hits, c.hit ? 1u : 0u);
+        EXPECT_EQ(timestamps(cached), expected);
+        EXPECT_EQ(timestamps(plain.getPriceHistorySince("AAPL", c.since, c.limit)), expected);
+    }
+}
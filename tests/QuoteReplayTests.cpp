@@ -0,0 +1,208 @@
+#include "TestData.h"
+#include "StockTracker/QuoteReplay.h"
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace StockTracker;
+using namespace std::chrono_literals;
+
+namespace {
+
+    std::vector<StockQuote> drain(QuoteSource& source) {
+        std::vector<StockQuote> quotes;
+        StockQuote quote;
+        while (source.next(quote)) {
+            quotes.push_back(quote);
+        }
+        return quotes;
+    }
+
+    // Connected PAIR sockets on a private context. The replayer runs on the test thread,
+    // so keep what it sends below the socket buffers.
+    struct SocketPair {
+        std::shared_ptr<zmq::context_t> context = std::make_shared<zmq::context_t>(1);
+        MessageSocket receiver{ zmq::socket_type::pair, context };
+        MessageSocket sender{ zmq::socket_type::pair, context };
+
+        SocketPair() {
+            receiver.bind("inproc://replay-test");
+            sender.connect("inproc://replay-test");
+            receiver.setTimeout(1000);
+        }
+
+        std::vector<Message> receiveAll() {
+            std::vector<Message> messages;
+            while (auto msg = receiver.receive(true)) {
+                messages.push_back(std::move(*msg));
+            }
+            return messages;
+        }
+    };
+
+    SyntheticQuoteOptions smallSource(uint64_t max_quotes) {
+        SyntheticQuoteOptions options;
+        options.symbols = 4;
+        options.interval = 100ms;
+        options.max_quotes = max_quotes;
+        return options;
+    }
+}
+
+TEST(QuoteReplayTest, SyntheticSourceIsDeterministic) {
+    SyntheticQuoteSource first(smallSource(40));
+    SyntheticQuoteSource second(smallSource(40));
+    auto a = drain(first);
+    auto b = drain(second);
+
+    ASSERT_EQ(a.size(), 40u);
+    ASSERT_EQ(b.size(), 40u);
+    for (size_t i = 0; i < a.size(); ++i) {
+        EXPECT_EQ(a[i].symbol, "SYM" + std::to_string(i % 4));
+        EXPECT_EQ(a[i].symbol, b[i].symbol);
+        EXPECT_EQ(a[i].price, b[i].price);
+        EXPECT_EQ(a[i].change_percent, b[i].change_percent);
+        // Symbols tick once per interval, spread evenly across it
+        EXPECT_EQ(a[i].timestamp - a[0].timestamp, 25ms * static_cast<int64_t>(i));
+    }
+
+    auto options = smallSource(40);
+    options.seed = 7;
+    SyntheticQuoteSource other(options);
+    auto c = drain(other);
+    EXPECT_NE(a.back().price, c.back().price);
+}
+
+TEST(QuoteReplayTest, FullSpeedReplaySendsEveryQuoteInOrder) {
+    SocketPair sockets;
+    SyntheticQuoteSource source(smallSource(200));
+    QuoteReplayer replayer(sockets.sender, ReplayOptions{ 0.0 });
+
+    auto stats = replayer.run(source);
+    EXPECT_EQ(stats.sent, 200u);
+    EXPECT_EQ(stats.max_lag, 0ns);
+
+    SyntheticQuoteSource expected(smallSource(200));
+    auto quotes = drain(expected);
+    auto messages = sockets.receiveAll();
+    ASSERT_EQ(messages.size(), quotes.size());
+    for (size_t i = 0; i < messages.size(); ++i) {
+        ASSERT_EQ(messages[i].type, MessageType::QuoteUpdate);
+        ASSERT_TRUE(messages[i].quote);
+        EXPECT_EQ(messages[i].symbol, quotes[i].symbol);
+        EXPECT_EQ(messages[i].quote->symbol, quotes[i].symbol);
+        EXPECT_EQ(messages[i].quote->price, quotes[i].price);
+        EXPECT_TRUE(messages[i].sentAt);
+    }
+}
+
+TEST(QuoteReplayTest, LatencyRecorderCountsEveryQuoteOfABatch) {
+    SocketPair sockets;
+    sockets.sender.setWireFormat(WireFormat::Binary);
+    sockets.sender.enableQuoteBatching(10, std::chrono::hours(1));
+    SyntheticQuoteSource source(smallSource(95));
+    QuoteReplayer(sockets.sender, ReplayOptions{ 0.0 }).run(source);
+
+    LatencyRecorder recorder;
+    auto messages = sockets.receiveAll();
+    ASSERT_EQ(messages.size(), 10u);    // Nine full batches and the rest, flushed by run()
+    for (const auto& msg : messages) {
+        EXPECT_EQ(msg.type, MessageType::QuoteBatch);
+        EXPECT_TRUE(recorder.record(msg));
+    }
+
+    auto stats = recorder.stats();
+    EXPECT_EQ(recorder.received(), 95u);
+    EXPECT_EQ(stats.quotes, 95u);
+    EXPECT_EQ(stats.latency.count, 10u);
+    EXPECT_EQ(stats.latency.name, "replay.latency");
+    EXPECT_EQ(messages.back().quotes->size(), 5u);
+
+    recorder.reset();
+    EXPECT_EQ(recorder.received(), 0u);
+    EXPECT_EQ(recorder.stats().latency.count, 0u);
+}
+
+TEST(QuoteReplayTest, UnstampedMessagesAreNotRecorded) {
+    SocketPair sockets;
+    SyntheticQuoteSource source(smallSource(3));
+    ReplayOptions options;
+    options.speed = 0.0;
+    options.stamp_send_time = false;
+    QuoteReplayer(sockets.sender, options).run(source);
+
+    LatencyRecorder recorder;
+    auto messages = sockets.receiveAll();
+    ASSERT_EQ(messages.size(), 3u);
+    for (const auto& msg : messages) {
+        EXPECT_FALSE(msg.sentAt);
+        EXPECT_FALSE(recorder.record(msg));
+    }
+    EXPECT_EQ(recorder.received(), 0u);
+}
+
+// Offsets divided by speed are lower bounds: sends are never early
+TEST(QuoteReplayTest, SpeedScalesTheSpacingOfTimestamps) {
+    SocketPair sockets;
+    // One tick every 100ms, so the fifth is due 400ms / speed after the first
+    for (double speed : { 4.0, 2.0 }) {
+        SyntheticQuoteOptions options;
+        options.symbols = 1;
+        options.interval = 100ms;
+        options.max_quotes = 5;
+        SyntheticQuoteSource source(options);
+
+        auto stats = QuoteReplayer(sockets.sender, ReplayOptions{ speed }).run(source);
+        EXPECT_EQ(stats.sent, 5u);
+        EXPECT_GE(stats.elapsed, std::chrono::duration_cast<std::chrono::nanoseconds>(400ms / speed));
+        EXPECT_LT(stats.elapsed, 5s);
+        EXPECT_EQ(sockets.receiveAll().size(), 5u);
+    }
+}
+
+TEST(QuoteReplayTest, StopInterruptsAWait) {
+    SocketPair sockets;
+    SyntheticQuoteOptions options;
+    options.symbols = 1;
+    options.interval = std::chrono::hours(1);
+    SyntheticQuoteSource source(options);
+    QuoteReplayer replayer(sockets.sender);
+
+    ReplayStats stats;
+    std::thread replay([&] { stats = replayer.run(source); });
+    ASSERT_TRUE(sockets.receiver.receive());    // The first quote is due at once, the next in an hour
+    replayer.stop();
+    replay.join();
+
+    EXPECT_EQ(stats.sent, 1u);
+    EXPECT_LT(stats.elapsed, 5s);
+}
+
+// Ticks of both symbols come back merged by timestamp with their exact spacing, across
+// window boundaries and without the quote at `to`
+TEST(QuoteReplayTest, HistorySourceMergesSymbolsAcrossWindows) {
+    DatabaseService db(Tests::tempDbPath("replay-history"));
+    std::vector<StockQuote> saved;
+    for (int64_t i = 0; i < 24; ++i) {
+        saved.push_back(Tests::makeQuote(i % 2 == 0 ? "AAPL" : "MSFT", 100.0 + static_cast<double>(i), Tests::at(250 * i)));
+    }
+    // Saved out of order: the source sorts each window
+    for (auto it = saved.rbegin(); it != saved.rend(); ++it) {
+        db.savePrice(*it);
+    }
+    db.savePrice(Tests::makeQuote("NVDA", 1.0, Tests::at(0)));
+
+    auto from = Tests::at(500);
+    auto to = Tests::at(5000);
+    HistoryQuoteSource source(db, { "AAPL", "MSFT" }, from, to, 1s);
+    auto quotes = drain(source);
+
+    ASSERT_EQ(quotes.size(), 18u);     // 500ms up to (not including) 5s, four a second
+    for (size_t i = 0; i < quotes.size(); ++i) {
+        const auto& expected = saved[i + 2];
+        EXPECT_EQ(quotes[i].symbol, expected.symbol);
+        EXPECT_EQ(quotes[i].price, expected.price);
+        EXPECT_EQ(quotes[i].timestamp, expected.timestamp);
+    }
+
+    EXPECT_THROW(HistoryQuoteSource(db, { "AAPL" }, from, to, 0s), std::invalid_argument);
+}
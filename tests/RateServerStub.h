@@ -0,0 +1,85 @@
+#pragma once
+#include <zmq.hpp>
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace StockTracker::Tests {
+
+    // Local stand-in for the currency service: a REP socket on an OS-picked port that
+    // answers conversions from a rate table the test can change, and counts requests
+    class RateServerStub {
+    public:
+        RateServerStub()
+            : socket(context, zmq::socket_type::rep)
+        {
+            socket.set(zmq::sockopt::linger, 0);
+            socket.set(zmq::sockopt::rcvtimeo, 20);
+            socket.bind("tcp://127.0.0.1:*");
+            endpoint = socket.get(zmq::sockopt::last_endpoint);
+            thread = std::thread([this] { serve(); });
+        }
+
+        ~RateServerStub() {
+            running = false;
+            thread.join();
+        }
+
+        RateServerStub(const RateServerStub&) = delete;
+        RateServerStub& operator=(const RateServerStub&) = delete;
+
+        // USD -> currency rate; a currency without one gets an error reply
+        void setRate(const std::string& currency, double rate) {
+            std::lock_guard<std::mutex> lock(mutex);
+            rates[currency] = rate;
+        }
+
+        void removeRate(const std::string& currency) {
+            std::lock_guard<std::mutex> lock(mutex);
+            rates.erase(currency);
+        }
+
+        size_t requests() const { return requestCount; }
+
+        std::string endpoint;
+
+    private:
+        zmq::context_t context{ 1 };
+        zmq::socket_t socket;
+        std::atomic<bool> running{ true };
+        std::atomic<size_t> requestCount{ 0 };
+        std::thread thread;
+
+        std::mutex mutex;
+        std::unordered_map<std::string, double> rates{
+            {"EUR", 0.92}, {"GBP", 0.79}, {"JPY", 149.5}, {"CAD", 1.36}
+        };
+
+        void serve() {
+            while (running) {
+                zmq::message_t request;
+                if (!socket.recv(request)) {
+                    continue;
+                }
+                ++requestCount;
+
+                auto j = nlohmann::json::parse(request.to_string_view());
+                nlohmann::json reply;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    auto it = rates.find(j.value("to_currency", ""));
+                    if (it == rates.end()) {
+                        reply["error"] = "Unsupported currency";
+                    }
+                    else {
+                        reply["converted_amount"] = j.at("amount").get<double>() * it->second;
+                    }
+                }
+                socket.send(zmq::buffer(reply.dump()), zmq::send_flags::none);
+            }
+        }
+    };
+}
@@ -0,0 +1,149 @@
+#include "TestData.h"
+#include "StockTracker/DatabaseService.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace StockTracker;
+
+namespace {
+
+    constexpr size_t BATCH_SIZE = 50;   // Quotes per write-behind transaction, half of them per symbol
+    constexpr size_t BATCHES = 40;
+    constexpr int64_t FIRST_MILLIS = 1000;
+
+    // Quote `i` of the ingest: AAPL and MSFT alternate, both at Tests::at(FIRST_MILLIS + i / 2)
+    StockQuote ingestQuote(size_t i) {
+        const char* symbol = i % 2 == 0 ? "AAPL" : "MSFT";
+        return Tests::makeQuote(symbol, 100.0 + static_cast<double>(i), Tests::at(FIRST_MILLIS + static_cast<int64_t>(i / 2)));
+    }
+
+    // Write-behind that commits only full batches: the delay never runs out, so the writer
+    // waits for BATCH_SIZE quotes unless flush() asks for less
+    WriteBehindOptions fullBatchesOnly() {
+        WriteBehindOptions options;
+        options.max_batch_size = BATCH_SIZE;
+        options.max_delay = std::chrono::hours(1);
+        return options;
+    }
+
+    bool newestFirst(const std::vector<StockQuote>& rows) {
+        return std::is_sorted(rows.begin(), rows.end(),
+            [](const StockQuote& a, const StockQuote& b) { return a.timestamp > b.timestamp; });
+    }
+
+    void expectSameQuotes(const std::vector<StockQuote>& expected, const std::vector<StockQuote>& actual) {
+        ASSERT_EQ(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_EQ(expected[i].symbol, actual[i].symbol);
+            EXPECT_EQ(expected[i].price, actual[i].price);
+            EXPECT_EQ(expected[i].timestamp, actual[i].timestamp);
+        }
+    }
+}
+
+// Pooled readers run while whole batches are committed. Each batch holds BATCH_SIZE / 2 quotes
+// of both symbols, so a reader that saw part of one would find a count off the batch grid.
+TEST(ReadPoolTest, ReadersOnlySeeWholeBatches) {
+    DatabaseService db(Tests::tempDbPath("read-pool-batches"));
+    db.enableWriteBehind(fullBatchesOnly());
+    db.enableReadPool(ReadPoolOptions{ 4 });
+
+    std::atomic<bool> ingesting{ true };
+    std::atomic<size_t> violations{ 0 };
+    std::atomic<size_t> reads{ 0 };
+    const size_t perSymbol = BATCHES * BATCH_SIZE / 2;
+
+    auto reader = [&](const std::string& symbol) {
+        size_t lastCount = 0;
+        auto check = [&](const std::vector<StockQuote>& rows) {
+            size_t count = rows.size();
+            bool wholeBatches = count % (BATCH_SIZE / 2) == 0;
+            bool grows = count >= lastCount;
+            // The newest row read back is the last quote of the newest committed batch
+            bool newest = count == 0 || rows.front().timestamp == Tests::at(FIRST_MILLIS + static_cast<int64_t>(count) - 1);
+            if (!wholeBatches || !grows || !newest || !newestFirst(rows)) {
+                ++violations;
+            }
+            lastCount = count;
+            ++reads;
+        };
+        // Read once more after ingest ends so every reader sees the final state
+        bool more = true;
+        while (more) {
+            more = ingesting;
+            check(db.getPriceHistory(symbol, static_cast<int>(perSymbol)));
+            auto page = db.getPriceHistoryPage(symbol, static_cast<int>(perSymbol));
+            check(page.quotes);
+            auto range = db.getPriceHistoryRange(symbol, Tests::at(0), Tests::at(FIRST_MILLIS + static_cast<int64_t>(perSymbol)));
+            std::reverse(range.begin(), range.end());
+            check(range);
+        }
+        if (lastCount != perSymbol) {
+            ++violations;
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for (const char* symbol : { "AAPL", "MSFT", "AAPL", "MSFT" }) {
+        readers.emplace_back(reader, symbol);
+    }
+    for (size_t i = 0; i < BATCHES * BATCH_SIZE; ++i) {
+        db.savePrice(ingestQuote(i));
+    }
+    db.flush();
+    ingesting = false;
+    for (auto& thread : readers) {
+        thread.join();
+    }
+
+    EXPECT_EQ(violations, 0u);
+    EXPECT_GT(reads, 0u);
+}
+
+// After each committed batch the pool must return what the main connection returns
+TEST(ReadPoolTest, PooledReadsMatchTheMainConnection) {
+    auto path = Tests::tempDbPath("read-pool-match");
+    DatabaseService pooled(path);
+    pooled.saveSubscription("AAPL");
+    pooled.saveSubscription("MSFT");
+    pooled.enableWriteBehind(fullBatchesOnly());
+    pooled.enableReadPool(ReadPoolOptions{ 2 });
+    DatabaseService plain(path);
+
+    auto from = Tests::at(FIRST_MILLIS + 3);
+    auto to = Tests::at(FIRST_MILLIS + 60);
+    for (size_t batch = 0; batch < 4; ++batch) {
+        for (size_t i = 0; i < BATCH_SIZE; ++i) {
+            pooled.savePrice(ingestQuote(batch * BATCH_SIZE + i));
+        }
+        pooled.flush();
+
+        for (const char* symbol : { "AAPL", "MSFT" }) {
+            SCOPED_TRACE(std::string(symbol) + " after batch " + std::to_string(batch));
+            expectSameQuotes(plain.getPriceHistory(symbol, 30), pooled.getPriceHistory(symbol, 30));
+            auto range = plain.getPriceHistoryRange(symbol, from, to);
+            EXPECT_EQ(range.size(), std::min<size_t>((batch + 1) * BATCH_SIZE / 2, 60) - 3);
+            expectSameQuotes(range, pooled.getPriceHistoryRange(symbol, from, to));
+            expectSameQuotes(plain.getPriceHistoryRange(symbol, from, to, 7), pooled.getPriceHistoryRange(symbol, from, to, 7));
+
+            // Walk every page; both sides must hand out the same keys
+            std::optional<HistoryPageKey> after;
+            do {
+                auto expected = plain.getPriceHistoryPage(symbol, 16, after);
+                auto actual = pooled.getPriceHistoryPage(symbol, 16, after);
+                expectSameQuotes(expected.quotes, actual.quotes);
+                ASSERT_EQ(expected.next.has_value(), actual.next.has_value());
+                if (expected.next) {
+                    EXPECT_EQ(expected.next->timestamp, actual.next->timestamp);
+                    EXPECT_EQ(expected.next->rowid, actual.next->rowid);
+                }
+                after = expected.next;
+            } while (after);
+        }
+        EXPECT_EQ(plain.getSubscriptions(), pooled.getSubscriptions());
+    }
+}
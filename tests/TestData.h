@@ -0,0 +1,41 @@
+#pragma once
+#include "StockTracker/Types.h"
+#include <chrono>
+#include <filesystem>
+#include <string>
+
+namespace StockTracker::Tests {
+
+    // Database path under the temp directory, with files left by an earlier run removed
+    inline std::string tempDbPath(const std::string& name) {
+        auto path = std::filesystem::temp_directory_path() / ("stocktracker-test-" + name + ".db");
+        for (const char* suffix : { "", "-wal", "-shm" }) {
+            std::filesystem::remove(path.string() + suffix);
+        }
+        return path.string();
+    }
+
+    // Directory under the temp directory, emptied of anything left by an earlier run
+    inline std::string tempDirPath(const std::string& name) {
+        auto path = std::filesystem::temp_directory_path() / ("stocktracker-test-" + name);
+        std::filesystem::remove_all(path);
+        return path.string();
+    }
+
+    // A fixed, ordinary wall-clock time, so stored timestamps are realistic epoch values
+    inline const std::chrono::system_clock::time_point T0{ std::chrono::milliseconds(1'700'000'000'000) };
+
+    // `millis` milliseconds after T0
+    inline std::chrono::system_clock::time_point at(int64_t millis) {
+        return T0 + std::chrono::milliseconds(millis);
+    }
+
+    // `millis` milliseconds after the hour T0 falls in, so bars start at whole minutes of it
+    inline std::chrono::system_clock::time_point atBar(int64_t millis) {
+        return std::chrono::floor<std::chrono::hours>(T0) + std::chrono::milliseconds(millis);
+    }
+
+    inline StockQuote makeQuote(const std::string& symbol, double price, std::chrono::system_clock::time_point time) {
+        return StockQuote{ symbol, price, time, std::nullopt, "USD", std::nullopt };
+    }
+}
@@ -0,0 +1,359 @@
+#include "TestData.h"
+#include "StockTracker/SqlitePriceStore.h"
+#include "StockTracker/TickLogStore.h"
+#include <gtest/gtest.h>
+#include <sqlite3.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <tuple>
+
+using namespace StockTracker;
+
+namespace {
+
+    constexpr size_t TICKS_PER_SEGMENT = 4;
+
+    // Offsets into a segment file's header
+    constexpr std::streamoff VERSION_OFFSET = 8;
+    constexpr std::streamoff COUNT_OFFSET = 24;
+    constexpr std::streamoff MIN_TIMESTAMP_OFFSET = 40;
+    constexpr std::streamoff HEADER_SIZE = 64;
+
+    std::filesystem::path segmentPath(const std::string& directory, const std::string& symbol, int index) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "seg-%06d.dat", index);
+        return std::filesystem::path(directory) / symbol / name;
+    }
+
+    template <typename T>
+    void writeAt(const std::filesystem::path& path, std::streamoff offset, T value) {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(offset);
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    template <typename T>
+    T readAt(const std::filesystem::path& path, std::streamoff offset) {
+        std::ifstream file(path, std::ios::binary);
+        file.seekg(offset);
+        T value{};
+        file.read(reinterpret_cast<char*>(&value), sizeof(value));
+        return value;
+    }
+
+    // The same history in both stores, so every query can be compared row for row
+    struct StorePair {
+        std::string directory;
+        sqlite3* db{ nullptr };
+        std::unique_ptr<SqlitePriceStore> sqlite;
+        std::unique_ptr<TickLogStore> ticks;
+
+        explicit StorePair(const std::string& name)
+            : directory(Tests::tempDirPath(name))
+        {
+            if (sqlite3_open(":memory:", &db) != SQLITE_OK) {
+                throw std::runtime_error("Failed to open database");
+            }
+            sqlite = std::make_unique<SqlitePriceStore>(db);
+            reopen();
+        }
+
+        ~StorePair() {
+            sqlite.reset();
+            sqlite3_close(db);
+        }
+
+        void append(const std::vector<StockQuote>& quotes) {
+            sqlite->append(quotes.data(), quotes.size());
+            ticks->append(quotes.data(), quotes.size());
+        }
+
+        // Loads the tick log from its files again
+        void reopen() {
+            ticks.reset();
+            ticks = std::make_unique<TickLogStore>(TickLogOptions{ directory, TICKS_PER_SEGMENT });
+        }
+    };
+
+    auto fields(const StockQuote& quote) {
+        return std::make_tuple(quote.symbol, quote.timestamp, quote.price, quote.change_percent);
+    }
+
+    void expectSameRows(const std::vector<StockQuote>& expected, const std::vector<StockQuote>& actual) {
+        ASSERT_EQ(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_EQ(fields(expected[i]), fields(actual[i])) << "row " << i;
+        }
+    }
+
+    std::vector<StockQuote> walkPages(PriceStore& store, const std::string& symbol, int limit) {
+        std::vector<StockQuote> quotes;
+        std::optional<HistoryPageKey> key;
+        do {
+            auto page = store.page(symbol, limit, key);
+            quotes.insert(quotes.end(), page.quotes.begin(), page.quotes.end());
+            key = page.next;
+        } while (key);
+        return quotes;
+    }
+
+    std::vector<StockQuote> readCursor(PriceHistoryCursor::Source& cursor) {
+        std::vector<StockQuote> quotes;
+        StockQuote quote;
+        while (cursor.next(quote)) {
+            quotes.push_back(quote);
+        }
+        return quotes;
+    }
+
+    // Scans visit rows in storage order, which only the tick log defines, so compare as sets
+    std::vector<StockQuote> sortedScan(PriceStore& store, const std::string& symbol,
+        std::chrono::system_clock::time_point from, std::chrono::system_clock::time_point to) {
+        std::vector<StockQuote> quotes;
+        store.scan(symbol, from, to, [&](const StockQuote& quote) { quotes.push_back(quote); });
+        std::sort(quotes.begin(), quotes.end(), [](const StockQuote& a, const StockQuote& b) {
+            return std::tie(a.timestamp, a.price) < std::tie(b.timestamp, b.price);
+        });
+        return quotes;
+    }
+
+    void expectSameQueries(StorePair& stores, const std::string& symbol) {
+        SCOPED_TRACE(symbol);
+        auto& sqlite = *stores.sqlite;
+        auto& ticks = *stores.ticks;
+
+        for (int limit : { 1, 5, -1 }) {
+            expectSameRows(sqlite.latest(symbol, limit), ticks.latest(symbol, limit));
+        }
+        for (int limit : { 1, 3, 7 }) {
+            expectSameRows(walkPages(sqlite, symbol, limit), walkPages(ticks, symbol, limit));
+        }
+
+        // Windows that start and end on ticks, between ticks, on ties and outside the history
+        std::vector<std::pair<int64_t, int64_t>> windows{
+            { -1000, 100000 }, { 0, 1 }, { 3, 9 }, { 4, 4 }, { 5, 23 }, { 11, 12 }, { 40, 1000 }, { 90000, 100000 }
+        };
+        for (const auto& [from, to] : windows) {
+            SCOPED_TRACE(testing::Message() << "[" << from << ", " << to << ")");
+            for (int limit : { 2, -1 }) {
+                expectSameRows(sqlite.range(symbol, Tests::at(from), Tests::at(to), limit),
+                    ticks.range(symbol, Tests::at(from), Tests::at(to), limit));
+            }
+            expectSameRows(readCursor(*sqlite.openCursor(symbol, Tests::at(from), Tests::at(to))),
+                readCursor(*ticks.openCursor(symbol, Tests::at(from), Tests::at(to))));
+            expectSameRows(sortedScan(sqlite, symbol, Tests::at(from), Tests::at(to)),
+                sortedScan(ticks, symbol, Tests::at(from), Tests::at(to)));
+        }
+    }
+
+    void expectSameStores(StorePair& stores) {
+        auto symbols = stores.sqlite->symbols();
+        auto logged = stores.ticks->symbols();
+        std::sort(logged.begin(), logged.end());
+        EXPECT_EQ(symbols, logged);
+        for (const auto& symbol : symbols) {
+            expectSameQueries(stores, symbol);
+        }
+        expectSameQueries(stores, "NONE");
+    }
+
+    // `count` ticks per symbol at the given offsets, interleaved, with every third one
+    // carrying a change percent and sub-millisecond parts that storage drops
+    std::vector<StockQuote> interleaved(const std::vector<std::string>& symbols, const std::vector<int64_t>& offsets) {
+        std::vector<StockQuote> quotes;
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            for (size_t s = 0; s < symbols.size(); ++s) {
+                auto time = Tests::at(offsets[i]) + std::chrono::microseconds(250);
+                auto quote = Tests::makeQuote(symbols[s], 100.0 + static_cast<double>(s * 1000 + i), time);
+                if (i % 3 == 0) {
+                    quote.change_percent = 0.5 * static_cast<double>(i);
+                }
+                quotes.push_back(quote);
+            }
+        }
+        return quotes;
+    }
+
+    // 0..24 with ties at 4 and 11
+    std::vector<int64_t> orderedOffsets() {
+        std::vector<int64_t> offsets;
+        for (int64_t i = 0; i < 25; ++i) {
+            offsets.push_back(i);
+            if (i == 4 || i == 11) {
+                offsets.push_back(i);
+            }
+        }
+        return offsets;
+    }
+}
+
+TEST(TickLogStoreTest, MatchesSqliteAcrossSegmentsAndReopen) {
+    StorePair stores("ticklog-matches");
+    stores.append(interleaved({ "AAPL", "MSFT" }, orderedOffsets()));
+    // Spans several segments, the last one partly filled
+    ASSERT_TRUE(std::filesystem::exists(segmentPath(stores.directory, "AAPL", 6)));
+    ASSERT_FALSE(std::filesystem::exists(segmentPath(stores.directory, "AAPL", 7)));
+
+    expectSameStores(stores);
+
+    stores.ticks->sync();
+    stores.reopen();
+    expectSameStores(stores);
+
+    // Appends after reopening continue the same sequence
+    stores.append(interleaved({ "AAPL" }, { 25, 26, 26 }));
+    expectSameStores(stores);
+}
+
+TEST(TickLogStoreTest, MatchesSqliteWithOutOfOrderAppends) {
+    StorePair stores("ticklog-out-of-order");
+    // Disorder within the first segment, across a segment boundary and with a tie
+    std::vector<int64_t> offsets{ 3, 1, 0, 2, 7, 8, 6, 9, 5, 10, 12, 11, 11, 13, 14, 4 };
+    stores.append(interleaved({ "AAPL" }, offsets));
+    expectSameStores(stores);
+
+    // Loading recomputes the order from the segment headers
+    stores.reopen();
+    expectSameStores(stores);
+
+    // The newest tick arriving late still counts as the latest
+    stores.append({ Tests::makeQuote("AAPL", 1.0, Tests::at(30)), Tests::makeQuote("AAPL", 2.0, Tests::at(29)) });
+    expectSameRows(stores.sqlite->latest("AAPL", 2), stores.ticks->latest("AAPL", 2));
+    expectSameStores(stores);
+}
+
+TEST(TickLogStoreTest, TrimDropsWholeSegmentsLikeSqliteDropsRows) {
+    StorePair stores("ticklog-trim");
+    // The first segment is out of order on its own, the rest follow it
+    std::vector<int64_t> offsets{ 2, 0, 3, 1 };
+    for (int64_t i = 4; i < 14; ++i) {
+        offsets.push_back(i);
+    }
+    stores.append(interleaved({ "AAPL" }, offsets));
+
+    std::vector<StockQuote> fromSqlite;
+    std::vector<StockQuote> fromTicks;
+    auto keep = [](std::vector<StockQuote>& into) {
+        return [&into](const std::vector<StockQuote>& rows) { into = rows; };
+    };
+
+    // Nothing in the first segment is old enough yet
+    EXPECT_EQ(stores.ticks->trim("AAPL", Tests::at(3), 1, keep(fromTicks)), 0u);
+
+    // One segment's worth, which is also the oldest rows by timestamp
+    ASSERT_EQ(stores.ticks->trim("AAPL", Tests::at(6), 1, keep(fromTicks)), TICKS_PER_SEGMENT);
+    ASSERT_EQ(stores.sqlite->trim("AAPL", Tests::at(6), TICKS_PER_SEGMENT, keep(fromSqlite)), TICKS_PER_SEGMENT);
+    std::sort(fromTicks.begin(), fromTicks.end(), [](const StockQuote& a, const StockQuote& b) { return a.timestamp < b.timestamp; });
+    expectSameRows(fromSqlite, fromTicks);
+    // What's left is ordered again and answered by binary search
+    expectSameStores(stores);
+
+    // The segment being appended to is never dropped
+    auto remaining = stores.ticks->latest("AAPL", -1).size();
+    size_t dropped = 0;
+    while (size_t rows = stores.ticks->trim("AAPL", Tests::at(1000), 100, keep(fromTicks))) {
+        dropped += rows;
+    }
+    EXPECT_EQ(stores.ticks->latest("AAPL", -1).size(), remaining - dropped);
+    EXPECT_FALSE(stores.ticks->latest("AAPL", -1).empty());
+
+    stores.sqlite->trim("AAPL", Tests::at(1000), dropped, keep(fromSqlite));
+    expectSameStores(stores);
+    stores.reopen();
+    expectSameStores(stores);
+}
+
+TEST(TickLogStoreTest, CursorSkipsRowsTrimmedWhileOpen) {
+    for (bool ordered : { true, false }) {
+        SCOPED_TRACE(ordered ? "ordered" : "out of order");
+        StorePair stores(ordered ? "ticklog-cursor-ordered" : "ticklog-cursor-unordered");
+        std::vector<int64_t> offsets;
+        for (int64_t i = 0; i < 16; ++i) {
+            offsets.push_back(i);
+        }
+        if (!ordered) {
+            std::swap(offsets[13], offsets[14]);
+        }
+        stores.append(interleaved({ "AAPL" }, offsets));
+
+        auto cursor = stores.ticks->openCursor("AAPL", Tests::at(0), Tests::at(100));
+        StockQuote quote;
+        ASSERT_TRUE(cursor->next(quote));
+        EXPECT_EQ(quote.timestamp, Tests::at(0));
+        ASSERT_TRUE(cursor->next(quote));
+
+        // Two segments go while the cursor is between them
+        auto ignore = [](const std::vector<StockQuote>&) {};
+        ASSERT_EQ(stores.ticks->trim("AAPL", Tests::at(8), 8, ignore), 8u);
+        ASSERT_EQ(stores.sqlite->trim("AAPL", Tests::at(8), 8, ignore), 8u);
+
+        expectSameRows(stores.sqlite->range("AAPL", Tests::at(0), Tests::at(100), -1), readCursor(*cursor));
+        EXPECT_FALSE(cursor->next(quote));
+    }
+}
+
+TEST(TickLogStoreTest, ConvertsVersionOneSegments) {
+    StorePair stores("ticklog-version-one");
+    stores.append(interleaved({ "AAPL" }, orderedOffsets()));
+    stores.ticks->sync();
+    stores.ticks.reset();
+
+    // Rewrite the first segment the way version 1 stored it, in system_clock ticks
+    auto ticksPerMilli = std::chrono::duration_cast<std::chrono::system_clock::duration>(
+        std::chrono::milliseconds(1)).count();
+    auto path = segmentPath(stores.directory, "AAPL", 0);
+    writeAt<uint32_t>(path, VERSION_OFFSET, 1);
+    for (std::streamoff offset : { MIN_TIMESTAMP_OFFSET, MIN_TIMESTAMP_OFFSET + 8 }) {
+        writeAt(path, offset, readAt<int64_t>(path, offset) * ticksPerMilli);
+    }
+    for (size_t row = 0; row < TICKS_PER_SEGMENT; ++row) {
+        std::streamoff offset = HEADER_SIZE + static_cast<std::streamoff>(row * sizeof(int64_t));
+        writeAt(path, offset, readAt<int64_t>(path, offset) * ticksPerMilli);
+    }
+
+    stores.reopen();
+    expectSameStores(stores);
+    EXPECT_EQ(readAt<uint32_t>(path, VERSION_OFFSET), 2u);
+
+    // Converted once, on disk
+    stores.ticks->sync();
+    stores.reopen();
+    expectSameStores(stores);
+}
+
+TEST(TickLogStoreTest, RejectsCorruptSegments) {
+    auto corrupt = [](const char* name, const std::function<void(const std::string&)>& damage) {
+        SCOPED_TRACE(name);
+        auto directory = Tests::tempDirPath(std::string("ticklog-corrupt-") + name);
+        {
+            TickLogStore store(TickLogOptions{ directory, TICKS_PER_SEGMENT });
+            auto quotes = interleaved({ "AAPL" }, orderedOffsets());
+            store.append(quotes.data(), quotes.size());
+            store.sync();
+        }
+        damage(directory);
+        EXPECT_THROW(TickLogStore(TickLogOptions{ directory, TICKS_PER_SEGMENT }), std::runtime_error);
+    };
+
+    corrupt("magic", [](const std::string& directory) {
+        writeAt<char>(segmentPath(directory, "AAPL", 1), 0, 'X');
+    });
+    corrupt("version", [](const std::string& directory) {
+        writeAt<uint32_t>(segmentPath(directory, "AAPL", 1), VERSION_OFFSET, 99);
+    });
+    corrupt("count", [](const std::string& directory) {
+        writeAt<uint64_t>(segmentPath(directory, "AAPL", 1), COUNT_OFFSET, TICKS_PER_SEGMENT + 1);
+    });
+    corrupt("truncated", [](const std::string& directory) {
+        auto path = segmentPath(directory, "AAPL", 1);
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 8);
+    });
+    corrupt("empty", [](const std::string& directory) {
+        std::filesystem::resize_file(segmentPath(directory, "AAPL", 1), 0);
+    });
+    corrupt("gap", [](const std::string& directory) {
+        std::filesystem::remove(segmentPath(directory, "AAPL", 2));
+    });
+}
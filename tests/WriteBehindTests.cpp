@@ -0,0 +1,156 @@
+#include "TestData.h"
+#include "StockTracker/DatabaseService.h"
+#include "StockTracker/TickLogStore.h"
+#include <gtest/gtest.h>
+#include <atomic>
+
+using namespace StockTracker;
+using namespace std::chrono_literals;
+
+namespace {
+
+    // Batches wait for flush() or a full batch, never for the delay
+    WriteBehindOptions heldUntilFlush(size_t max_queue_size = 10000) {
+        WriteBehindOptions options;
+        options.max_queue_size = max_queue_size;
+        options.max_batch_size = max_queue_size + 1;
+        options.max_delay = 1h;
+        return options;
+    }
+
+    // A TickLogStore whose appends can be made to fail
+    class FailingStore : public PriceStore {
+    public:
+        FailingStore(const std::string& directory, const std::atomic<bool>& failing)
+            : store(TickLogOptions{ directory })
+            , failing(failing)
+        {}
+
+        void append(const StockQuote* quotes, size_t count) override {
+            if (failing) {
+                throw std::runtime_error("Disk full");
+            }
+            store.append(quotes, count);
+        }
+        std::vector<StockQuote> latest(const std::string& symbol, int limit) override {
+            return store.latest(symbol, limit);
+        }
+        std::vector<StockQuote> range(const std::string& symbol,
+            std::chrono::system_clock::time_point from,
+            std::chrono::system_clock::time_point to,
+            int limit) override {
+            return store.range(symbol, from, to, limit);
+        }
+        PriceHistoryPage page(const std::string& symbol, int limit,
+            std::optional<HistoryPageKey> after) override {
+            return store.page(symbol, limit, after);
+        }
+        std::unique_ptr<PriceHistoryCursor::Source> openCursor(const std::string& symbol,
+            std::chrono::system_clock::time_point from,
+            std::chrono::system_clock::time_point to) override {
+            return store.openCursor(symbol, from, to);
+        }
+        void scan(const std::string& symbol,
+            std::chrono::system_clock::time_point from,
+            std::chrono::system_clock::time_point to,
+            const std::function<void(const StockQuote&)>& visit) override {
+            store.scan(symbol, from, to, visit);
+        }
+        std::vector<std::string> symbols() override {
+            return store.symbols();
+        }
+        size_t trim(const std::string& symbol, std::chrono::system_clock::time_point before,
+            size_t max_rows, const std::function<void(const std::vector<StockQuote>&)>& retire) override {
+            return store.trim(symbol, before, max_rows, retire);
+        }
+
+    private:
+        TickLogStore store;
+        const std::atomic<bool>& failing;
+    };
+
+    std::vector<OhlcvBar> minuteBars(DatabaseService& db) {
+        BarQuery query;
+        query.interval = 1min;
+        query.from = Tests::atBar(0);
+        query.to = Tests::atBar(3600 * 1000);
+        return db.getBars("AAPL", query);
+    }
+}
+
+TEST(WriteBehindTest, FlushGivesReadYourWrites) {
+    DatabaseService db(Tests::tempDbPath("write-behind-flush"));
+    db.enableBars(BarAggregatorOptions{ { 1min } });
+    db.enableWriteBehind(heldUntilFlush());
+
+    // Three minutes of ticks, so two bars close along the way
+    for (int i = 0; i < 9; ++i) {
+        db.savePrice(Tests::makeQuote("AAPL", 100.0 + i, Tests::atBar(i * 20'000)));
+    }
+    EXPECT_EQ(db.pendingWrites(), 9u);
+    EXPECT_TRUE(db.getPriceHistory("AAPL", 10).empty());
+    EXPECT_TRUE(minuteBars(db).empty());
+
+    db.flush();
+    EXPECT_EQ(db.pendingWrites(), 0u);
+    auto history = db.getPriceHistory("AAPL", 10);
+    ASSERT_EQ(history.size(), 9u);
+    EXPECT_EQ(history.front().price, 108.0);
+
+    auto bars = minuteBars(db);
+    ASSERT_EQ(bars.size(), 3u);
+    for (size_t i = 0; i < bars.size(); ++i) {
+        EXPECT_EQ(bars[i].open, 100.0 + 3 * i);
+        EXPECT_EQ(bars[i].close, 102.0 + 3 * i);
+        EXPECT_EQ(bars[i].volume, 3u);
+    }
+}
+
+TEST(WriteBehindTest, TrySavePriceRefusesWhenTheQueueIsFull) {
+    DatabaseService db(Tests::tempDbPath("write-behind-backpressure"));
+    db.enableWriteBehind(heldUntilFlush(3));
+
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(db.trySavePrice(Tests::makeQuote("AAPL", 100.0 + i, Tests::at(i))));
+    }
+    EXPECT_FALSE(db.trySavePrice(Tests::makeQuote("AAPL", 103.0, Tests::at(3))));
+    EXPECT_EQ(db.pendingWrites(), 3u);
+
+    // The refused quote was never queued, and there's room again once the queue drains
+    db.flush();
+    EXPECT_EQ(db.getPriceHistory("AAPL", 10).size(), 3u);
+    EXPECT_TRUE(db.trySavePrice(Tests::makeQuote("AAPL", 103.0, Tests::at(3))));
+    db.flush();
+    EXPECT_EQ(db.getPriceHistory("AAPL", 10).front().price, 103.0);
+}
+
+TEST(WriteBehindTest, WriterErrorsReachFlushAndDroppedBatchesLeaveNoBars) {
+    std::atomic<bool> failing{ false };
+    DatabaseService db(Tests::tempDbPath("write-behind-error"),
+        std::make_unique<FailingStore>(Tests::tempDirPath("write-behind-error-ticks"), failing));
+    db.enableBars(BarAggregatorOptions{ { 1min } });
+    db.enableWriteBehind(heldUntilFlush());
+
+    failing = true;
+    db.savePrice(Tests::makeQuote("AAPL", 50.0, Tests::atBar(0)));
+    db.savePrice(Tests::makeQuote("AAPL", 60.0, Tests::atBar(70'000)));
+    EXPECT_THROW(db.flush(), std::runtime_error);
+    EXPECT_EQ(db.pendingWrites(), 0u);
+
+    // Reported once; the writer carries on with the next batch
+    EXPECT_NO_THROW(db.flush());
+    EXPECT_TRUE(db.getPriceHistory("AAPL", 10).empty());
+    EXPECT_TRUE(minuteBars(db).empty());
+
+    failing = false;
+    db.savePrice(Tests::makeQuote("AAPL", 100.0, Tests::atBar(10'000)));
+    db.savePrice(Tests::makeQuote("AAPL", 110.0, Tests::atBar(80'000)));
+    db.flush();
+
+    auto bars = minuteBars(db);
+    ASSERT_EQ(bars.size(), 2u);
+    EXPECT_EQ(bars[0].open, 100.0);
+    EXPECT_EQ(bars[0].volume, 1u);
+    EXPECT_EQ(bars[1].open, 110.0);
+    EXPECT_EQ(bars[1].volume, 1u);
+}
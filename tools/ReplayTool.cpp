@@ -0,0 +1,302 @@
+// Quote replay / load generator. Publishes stored or synthetic quotes on a PUB socket
+// and, with --loopback, measures end-to-end latency and throughput in the same process.
+//
+//   StockTracker.Replay --loopback --endpoint ipc:///tmp/replay --speed 4
+//   StockTracker.Replay --source db --db stocktracker.db --symbols AAPL,MSFT --hours 24 --speed 60
+//   StockTracker.Replay --loopback --sweep --endpoint tcp://127.0.0.1:*
+//   StockTracker.Replay --listen tcp://127.0.0.1:5600      (receiver only, for a second process)
+#include "StockTracker/QuoteReplay.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace StockTracker;
+
+namespace {
+
+    struct Options {
+        std::string source{ "synthetic" };
+        std::string dbPath{ "stocktracker.db" };
+        std::vector<std::string> symbols;
+        int hours{ 24 };
+        SyntheticQuoteOptions synthetic;
+        double speed{ 1.0 };
+        std::string endpoint{ "inproc://stocktracker-replay" };
+        WireFormat format{ WireFormat::Binary };
+        size_t batch{ 0 };
+        bool loopback{ false };
+        bool sweep{ false };
+        std::chrono::seconds duration{ 5 };
+        std::string listen;
+    };
+
+    void usage() {
+        std::puts(
+            "Usage: StockTracker.Replay [options]\n"
+            "  --source synthetic|db   Where quotes come from (default synthetic)\n"
+            "  --db PATH               Database for --source db (default stocktracker.db)\n"
+            "  --symbols A,B,...       Symbols to replay from the database\n"
+            "  --hours N               Replay the last N hours of history (default 24)\n"
+            "  --count N               Synthetic symbols (default 1000)\n"
+            "  --interval-ms N         Synthetic ticks per symbol every N ms (default 1000)\n"
+            "  --max-quotes N          Stop after N synthetic quotes (default unlimited)\n"
+            "  --speed X               Multiple of real time, 0 = as fast as possible (default 1)\n"
+            "  --endpoint E            PUB endpoint to bind (default inproc://stocktracker-replay)\n"
+            "  --format json|binary    Wire format (default binary)\n"
+            "  --batch N               Send QuoteBatch messages of up to N quotes\n"
+            "  --loopback              Receive in-process and report latency and throughput\n"
+            "  --sweep                 With --loopback: double --speed until delivery falls below 95%\n"
+            "  --duration S            Seconds per run (default 5, 0 = until the source ends)\n"
+            "  --listen E              Only receive: connect a SUB socket to E and report every second");
+    }
+
+    std::vector<std::string> split(const std::string& list) {
+        std::vector<std::string> items;
+        std::stringstream in(list);
+        std::string item;
+        while (std::getline(in, item, ',')) {
+            if (!item.empty()) {
+                items.push_back(item);
+            }
+        }
+        return items;
+    }
+
+    Options parse(int argc, char** argv) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument(arg + " needs a value");
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--source") options.source = value();
+            else if (arg == "--db") options.dbPath = value();
+            else if (arg == "--symbols") options.symbols = split(value());
+            else if (arg == "--hours") options.hours = std::stoi(value());
+            else if (arg == "--count") options.synthetic.symbols = std::stoul(value());
+            else if (arg == "--interval-ms") options.synthetic.interval = std::chrono::milliseconds(std::stol(value()));
+            else if (arg == "--max-quotes") options.synthetic.max_quotes = std::stoull(value());
+            else if (arg == "--speed") options.speed = std::stod(value());
+            else if (arg == "--endpoint") options.endpoint = value();
+            else if (arg == "--format") options.format = value() == "json" ? WireFormat::Json : WireFormat::Binary;
+            else if (arg == "--batch") options.batch = std::stoul(value());
+            else if (arg == "--loopback") options.loopback = true;
+            else if (arg == "--sweep") options.sweep = true;
+            else if (arg == "--duration") options.duration = std::chrono::seconds(std::stol(value()));
+            else if (arg == "--listen") options.listen = value();
+            else throw std::invalid_argument("Unknown option " + arg);
+        }
+
+        if (options.source != "synthetic" && options.source != "db") {
+            throw std::invalid_argument("--source must be synthetic or db");
+        }
+        if (options.source == "db" && options.symbols.empty()) {
+            throw std::invalid_argument("--source db needs --symbols");
+        }
+        if (options.sweep && (!options.loopback || options.speed <= 0.0 || options.duration.count() <= 0)) {
+            throw std::invalid_argument("--sweep needs --loopback, a positive --speed and a positive --duration");
+        }
+        return options;
+    }
+
+    double micros(uint64_t nanos) {
+        return static_cast<double>(nanos) / 1000.0;
+    }
+
+    // Receives on a SUB socket until stopped, feeding every message to `recorder`
+    class Receiver {
+    public:
+        Receiver(const std::string& endpoint, WireFormat format, LatencyRecorder& recorder)
+            : socket(zmq::socket_type::sub)
+            , recorder(recorder)
+        {
+            socket.setWireFormat(format);
+            socket.setTimeout(100);
+            socket.setSubscribe();
+            socket.connect(endpoint);
+            thread = std::thread([this] { run(); });
+        }
+
+        ~Receiver() {
+            running = false;
+            thread.join();
+        }
+
+    private:
+        void run() {
+            Message msg{};
+            while (running) {
+                if (socket.receive(msg)) {
+                    recorder.record(msg);
+                }
+            }
+        }
+
+        MessageSocket socket;
+        LatencyRecorder& recorder;
+        std::atomic<bool> running{ true };
+        std::thread thread;
+    };
+
+    struct RunResult {
+        ReplayStats replay;
+        LatencyStats received;
+    };
+
+    std::unique_ptr<QuoteSource> makeSource(const Options& options, std::unique_ptr<DatabaseService>& db) {
+        if (options.source == "db") {
+            if (!db) {
+                db = std::make_unique<DatabaseService>(options.dbPath);
+            }
+            auto to = std::chrono::system_clock::now();
+            return std::make_unique<HistoryQuoteSource>(*db, options.symbols, to - std::chrono::hours(options.hours), to);
+        }
+        return std::make_unique<SyntheticQuoteSource>(options.synthetic);
+    }
+
+    RunResult runOnce(const Options& options, double speed, MessageSocket& publisher,
+        LatencyRecorder& recorder, std::unique_ptr<DatabaseService>& db) {
+        recorder.reset();
+        auto source = makeSource(options, db);
+
+        QuoteReplayer replayer(publisher, ReplayOptions{ speed, true });
+        std::atomic<bool> finished{ false };
+        std::thread timer([&] {
+            auto deadline = std::chrono::steady_clock::now() + options.duration;
+            while (!finished && (options.duration.count() == 0 || std::chrono::steady_clock::now() < deadline)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            replayer.stop();
+        });
+
+        RunResult result;
+        result.replay = replayer.run(*source);
+        finished = true;
+        timer.join();
+
+        // Let the receiver drain: done once nothing arrives for 200ms
+        if (options.loopback) {
+            uint64_t seen = recorder.received();
+            for (;;) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                uint64_t now = recorder.received();
+                if (now == seen) {
+                    break;
+                }
+                seen = now;
+            }
+        }
+        result.received = recorder.stats();
+        return result;
+    }
+
+    void printHeader(bool loopback) {
+        std::printf("%10s %12s %12s", "speed", "sent", "sent/s");
+        if (loopback) {
+            std::printf(" %12s %12s %10s %10s %10s %10s", "received", "recv/s", "p50 us", "p99 us", "p99.9 us", "max us");
+        }
+        std::printf(" %10s\n", "lag ms");
+    }
+
+    void printRow(double speed, const RunResult& run, bool loopback) {
+        double seconds = std::chrono::duration<double>(run.replay.elapsed).count();
+        std::printf("%10.2f %12llu %12.0f", speed, static_cast<unsigned long long>(run.replay.sent),
+            seconds > 0 ? static_cast<double>(run.replay.sent) / seconds : 0.0);
+        if (loopback) {
+            const auto& latency = run.received.latency;
+            std::printf(" %12llu %12.0f %10.1f %10.1f %10.1f %10.1f",
+                static_cast<unsigned long long>(run.received.quotes), run.received.quotes_per_second,
+                micros(latency.p50_ns), micros(latency.p99_ns), micros(latency.p999_ns), micros(latency.max_ns));
+        }
+        std::printf(" %10.1f\n", std::chrono::duration<double, std::milli>(run.replay.max_lag).count());
+        std::fflush(stdout);
+    }
+
+    int listen(const Options& options) {
+        LatencyRecorder recorder;
+        Receiver receiver(options.listen, options.format, recorder);
+        std::printf("%12s %12s %10s %10s %10s\n", "received", "recv/s", "p50 us", "p99 us", "max us");
+        for (;;) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            auto stats = recorder.stats();
+            recorder.reset();
+            std::printf("%12llu %12.0f %10.1f %10.1f %10.1f\n", static_cast<unsigned long long>(stats.quotes),
+                stats.quotes_per_second, micros(stats.latency.p50_ns), micros(stats.latency.p99_ns),
+                micros(stats.latency.max_ns));
+            std::fflush(stdout);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        options = parse(argc, argv);
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        usage();
+        return 2;
+    }
+
+    try {
+        if (!options.listen.empty()) {
+            return listen(options);
+        }
+
+        MessageSocket publisher(zmq::socket_type::pub);
+        publisher.setWireFormat(options.format);
+        if (options.batch > 0) {
+            publisher.enableQuoteBatching(options.batch, std::chrono::milliseconds(1));
+        }
+        publisher.bind(options.endpoint);
+
+        LatencyRecorder recorder;
+        std::unique_ptr<Receiver> receiver;
+        if (options.loopback) {
+            // last_endpoint resolves wildcards like tcp://127.0.0.1:*
+            receiver = std::make_unique<Receiver>(publisher.getSocket().get(zmq::sockopt::last_endpoint),
+                options.format, recorder);
+            // PUB drops everything sent before the subscription reaches it
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
+
+        std::unique_ptr<DatabaseService> db;
+        printHeader(options.loopback);
+        if (!options.sweep) {
+            printRow(options.speed, runOnce(options, options.speed, publisher, recorder, db), options.loopback);
+            return 0;
+        }
+
+        // The first speed at which the receiver misses quotes, or the sender can no longer
+        // keep to the schedule, is the saturation point
+        for (double speed = options.speed;; speed *= 2) {
+            auto run = runOnce(options, speed, publisher, recorder, db);
+            printRow(speed, run, options.loopback);
+            if (run.replay.sent == 0) {
+                std::fprintf(stderr, "The source produced no quotes\n");
+                return 1;
+            }
+            bool dropped = run.received.quotes < run.replay.sent * 95 / 100;
+            bool behind = run.replay.max_lag > options.duration / 20;
+            if (dropped || behind) {
+                std::printf("Saturated at speed %.2f (%s)\n", speed, dropped ? "receiver dropped quotes" : "sender fell behind");
+                return 0;
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "Replay failed: %s\n", e.what());
+        return 1;
+    }
+}